@@ -0,0 +1,207 @@
+/*++
+
+Library name:
+
+  libdelphi
+
+Module Name:
+
+  Bench.cpp
+
+Notices:
+
+  Delphi classes for C++
+
+  Benchmark harness: self-calibrating timing loops with JSON output; counts heap allocations per iteration by
+  interposing malloc/calloc/realloc
+
+Author:
+
+  Copyright (c) Prepodobny Alen
+
+  mailto: alienufo@inbox.ru
+  mailto: ufocomp@gmail.com
+
+--*/
+
+#include "delphi.hpp"
+#include "Bench.hpp"
+//----------------------------------------------------------------------------------------------------------------------
+
+#ifndef __SANITIZE_ADDRESS__
+#define BENCH_COUNT_ALLOCATIONS
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+
+#ifdef BENCH_COUNT_ALLOCATIONS
+
+static uint64_t GBenchAllocations = 0;
+//----------------------------------------------------------------------------------------------------------------------
+
+extern "C" {
+
+void *__libc_malloc(size_t Size);
+void *__libc_calloc(size_t Count, size_t Size);
+void *__libc_realloc(void *Block, size_t Size);
+//----------------------------------------------------------------------------------------------------------------------
+
+void *malloc(size_t Size) noexcept {
+    __atomic_add_fetch(&GBenchAllocations, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(Size);
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void *calloc(size_t Count, size_t Size) noexcept {
+    __atomic_add_fetch(&GBenchAllocations, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(Count, Size);
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void *realloc(void *Block, size_t Size) noexcept {
+    __atomic_add_fetch(&GBenchAllocations, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(Block, Size);
+}
+
+}
+
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+
+extern "C++" {
+
+namespace Delphi {
+
+    namespace Bench {
+
+        uint64_t BenchTime() {
+            struct timespec ts = {0, 0};
+            ::clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint64_t BenchAllocations() {
+#ifdef BENCH_COUNT_ALLOCATIONS
+            return __atomic_load_n(&GBenchAllocations, __ATOMIC_RELAXED);
+#else
+            return 0;
+#endif
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool BenchAllocationsCounted() {
+#ifdef BENCH_COUNT_ALLOCATIONS
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CBenchRunner ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CBenchRunner::CBenchRunner(const CString &Suite): CObject(), m_Suite(Suite), m_MinTime(BENCH_MIN_TIME),
+                m_List(false) {
+
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CBenchRunner::ParseArgs(int argc, char *argv[]) {
+            for (int i = 1; i < argc; ++i) {
+                const CString Arg(argv[i]);
+
+                if (Arg == "--filter" && i + 1 < argc) {
+                    m_Filter = argv[++i];
+                } else if (Arg == "--time" && i + 1 < argc) {
+                    m_MinTime = StrToDouble(argv[++i]);
+                } else if (Arg == "--list") {
+                    m_List = true;
+                } else {
+                    ::fprintf(stderr, "Usage: %s [--filter <text>] [--time <seconds>] [--list]\n", argv[0]);
+                    return false;
+                }
+            }
+
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CBenchRunner::Selected(LPCTSTR Name) const {
+            if (!m_Filter.IsEmpty() && ::strstr(Name, m_Filter.c_str()) == nullptr)
+                return false;
+
+            if (m_List) {
+                ::printf("%s\n", Name);
+                return false;
+            }
+
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CBenchRunner::Add(LPCTSTR Name, uint64_t Iterations, uint64_t Elapsed, size_t Bytes, uint64_t Allocations) {
+            CBenchResult Result;
+
+            Result.Name = Name;
+            Result.Iterations = Iterations;
+            Result.Elapsed = Elapsed;
+            Result.Bytes = Bytes;
+            Result.Allocations = Allocations;
+
+            m_Results.Add(std::move(Result));
+
+            if (BenchAllocationsCounted()) {
+                ::fprintf(stderr, "%-40s %12.1f ns/op %14llu iterations %10.1f allocs/op\n", Name,
+                          (double) Elapsed / (double) Iterations, (unsigned long long) Iterations,
+                          (double) Allocations / (double) Iterations);
+            } else {
+                ::fprintf(stderr, "%-40s %12.1f ns/op %14llu iterations\n", Name, (double) Elapsed / (double) Iterations,
+                          (unsigned long long) Iterations);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CBenchRunner::ToJson(CString &Json) const {
+            CJSONWriter Writer(Json);
+
+            Writer.BeginObject();
+            Writer.Name("suite");
+            Writer.Value(m_Suite);
+            Writer.Name("results");
+            Writer.BeginArray();
+
+            for (int i = 0; i < m_Results.Count(); ++i) {
+                const auto &Result = m_Results[i];
+                const double Nanos = (double) Result.Elapsed / (double) Result.Iterations;
+
+                Writer.BeginObject();
+                Writer.Name("name");
+                Writer.Value(Result.Name);
+                Writer.Name("iterations");
+                Writer.Value((long int) Result.Iterations);
+                Writer.Name("ns_per_op");
+                Writer.Value(Nanos);
+                Writer.Name("ops_per_sec");
+                Writer.Value(1e9 / Nanos);
+                if (Result.Bytes != 0) {
+                    Writer.Name("mb_per_sec");
+                    Writer.Value((double) Result.Bytes * 1e3 / Nanos);
+                }
+                if (BenchAllocationsCounted()) {
+                    Writer.Name("allocs_per_op");
+                    Writer.Value((double) Result.Allocations / (double) Result.Iterations);
+                }
+                Writer.EndObject();
+            }
+
+            Writer.EndArray();
+            Writer.EndObject();
+            Writer.Flush();
+        }
+
+    }
+}
+}
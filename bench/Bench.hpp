@@ -0,0 +1,160 @@
+/*++
+
+Library name:
+
+  libdelphi
+
+Module Name:
+
+  Bench.hpp
+
+Notices:
+
+  Delphi classes for C++
+
+  Benchmark harness: self-calibrating timing loops with JSON output
+
+Author:
+
+  Copyright (c) Prepodobny Alen
+
+  mailto: alienufo@inbox.ru
+  mailto: ufocomp@gmail.com
+
+--*/
+
+#ifndef DELPHI_BENCH_HPP
+#define DELPHI_BENCH_HPP
+//----------------------------------------------------------------------------------------------------------------------
+
+#define BENCH_MIN_TIME              0.2             // seconds per benchmark
+#define BENCH_MAX_ITERATIONS        1000000000ULL
+//----------------------------------------------------------------------------------------------------------------------
+
+extern "C++" {
+
+namespace Delphi {
+
+    namespace Bench {
+
+        /// Monotonic clock in nanoseconds
+        uint64_t BenchTime();
+        //--------------------------------------------------------------------------------------------------------------
+
+        /// malloc/calloc/realloc calls made by the process so far (GHeap and operator new both end up there)
+        uint64_t BenchAllocations();
+
+        /// False in AddressSanitizer builds: the sanitizer owns malloc, so nothing is counted
+        bool BenchAllocationsCounted();
+        //--------------------------------------------------------------------------------------------------------------
+
+        /// Keeps the compiler from dropping a computation whose result is never read
+        template <typename T>
+        inline void DoNotOptimize(const T &Value) {
+            asm volatile("" : : "g"(&Value) : "memory");
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CBenchResult ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        struct CBenchResult {
+            CString Name;
+            uint64_t Iterations = 0;
+            uint64_t Elapsed = 0;   // nanoseconds
+            size_t Bytes = 0;       // processed per iteration, 0 if not meaningful
+            uint64_t Allocations = 0;
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CBenchRunner ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Runs each benchmark body in a loop whose iteration count grows until the loop takes at least MinTime
+         * seconds, then records the time per iteration. Bodies are templates, so the loop itself adds no call.
+         */
+        class CBenchRunner: public CObject {
+        private:
+
+            CString m_Suite;
+            CString m_Filter;
+
+            double m_MinTime;
+
+            bool m_List;
+
+            TList<CBenchResult> m_Results;
+
+            void Add(LPCTSTR Name, uint64_t Iterations, uint64_t Elapsed, size_t Bytes, uint64_t Allocations);
+
+        public:
+
+            explicit CBenchRunner(const CString &Suite);
+
+            ~CBenchRunner() override = default;
+
+            /// Parses --filter <text>, --time <seconds> and --list; returns false if the program should stop
+            bool ParseArgs(int argc, char *argv[]);
+
+            bool Selected(LPCTSTR Name) const;
+
+            template <typename Body>
+            void Run(LPCTSTR Name, size_t Bytes, Body &&Loop) {
+                if (!Selected(Name))
+                    return;
+
+                const auto Target = (uint64_t) (m_MinTime * 1e9);
+
+                uint64_t Iterations = 1;
+                uint64_t Elapsed;
+                uint64_t Allocations;
+
+                for (;;) {
+                    const auto Allocated = BenchAllocations();
+                    const auto Start = BenchTime();
+                    for (uint64_t i = 0; i < Iterations; ++i)
+                        Loop();
+                    Elapsed = BenchTime() - Start;
+                    Allocations = BenchAllocations() - Allocated;
+
+                    if (Elapsed >= Target || Iterations >= BENCH_MAX_ITERATIONS)
+                        break;
+
+                    // Aim 20% past the target so the next round is usually the last one
+                    uint64_t Next = Elapsed == 0 ? Iterations * 100 : (uint64_t) ((double) Iterations * 1.2 * (double) Target / (double) Elapsed) + 1;
+                    if (Next > Iterations * 100)
+                        Next = Iterations * 100;
+                    if (Next <= Iterations)
+                        Next = Iterations * 2;
+
+                    Iterations = Next > BENCH_MAX_ITERATIONS ? BENCH_MAX_ITERATIONS : Next;
+                }
+
+                Add(Name, Iterations, Elapsed, Bytes, Allocations);
+            }
+
+            template <typename Body>
+            void Run(LPCTSTR Name, Body &&Loop) {
+                Run(Name, 0, std::forward<Body>(Loop));
+            }
+
+            void ToJson(CString &Json) const;
+
+            const TList<CBenchResult> &Results() const { return m_Results; }
+
+            double MinTime() const { return m_MinTime; }
+            void MinTime(double Value) { m_MinTime = Value; }
+
+        };
+
+    }
+}
+
+using namespace Delphi::Bench;
+}
+
+#endif //DELPHI_BENCH_HPP
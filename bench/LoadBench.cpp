@@ -0,0 +1,591 @@
+/*++
+
+Library name:
+
+  libdelphi
+
+Module Name:
+
+  LoadBench.cpp
+
+Notices:
+
+  Delphi classes for C++
+
+  Loopback HTTP/WebSocket load generator against a CHTTPServer forked on the same host: HTTP runs on
+  CHTTPLoadGenerator (closed or open loop, several reactor threads), WebSocket on a closed-loop CTCPAsyncClient;
+  prints throughput and latency percentiles as JSON
+
+Author:
+
+  Copyright (c) Prepodobny Alen
+
+  mailto: alienufo@inbox.ru
+  mailto: ufocomp@gmail.com
+
+--*/
+
+#include "delphi.hpp"
+#include "Bench.hpp"
+
+#include <sys/prctl.h>
+#include <sys/wait.h>
+//----------------------------------------------------------------------------------------------------------------------
+
+#define LOAD_POLL_TIMEOUT           100     // milliseconds
+#define LOAD_WS_MASKING_KEY         0x5A17C0DEu
+//----------------------------------------------------------------------------------------------------------------------
+
+struct CLoadOptions {
+    CString Mode = "http";
+    CString Host = "127.0.0.1";
+    unsigned short Port = 18480;
+    int Connections = 64;
+    int Threads = 1;
+    int Workers = 1;
+    double Rate = 0;
+    double Duration = 5;
+    double Warmup = 1;
+    size_t Payload = 64;
+    bool External = false;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//-- CLoadSession ------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Parser state of one client connection; a reply may arrive in several reads
+class CLoadSession: public CObject {
+public:
+
+    CHTTPReply HTTPReply;
+
+    Reply::CParserState State = Reply::http_version_h;
+    size_t ContentLength = 0;
+    size_t ChunkedLength = 0;
+
+    CWebSocket WSReply;
+
+    bool Upgraded = false;
+
+    uint64_t Start = 0;
+
+    void ClearReply() {
+        HTTPReply.Clear();
+        State = Reply::http_version_h;
+        ContentLength = 0;
+        ChunkedLength = 0;
+    }
+
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//-- CLoadClient -------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/**
+ * Closed-loop WebSocket load: every connection upgrades, then keeps exactly one frame in flight and sends the next
+ * one as soon as the echo is parsed. Frames are serialised once up front so the client spends its time on I/O.
+ */
+class CLoadClient: public CTCPAsyncClient {
+private:
+
+    const CLoadOptions &m_Options;
+
+    CMetricHistogram m_Latency;
+
+    CMemoryStream m_Request;
+    CMemoryStream m_Message;
+
+    CList m_Sessions;
+
+    uint64_t m_Replies;
+    uint64_t m_Errors;
+
+    int m_Connected;
+
+    bool m_Recording;
+
+    void Send(CTCPClientConnection *AConnection, const CMemoryStream &Data);
+
+    void SendNext(CTCPClientConnection *AConnection, CLoadSession *ASession);
+
+    void Complete(CTCPClientConnection *AConnection, CLoadSession *ASession);
+
+    void ParseReply(CTCPClientConnection *AConnection, CLoadSession *ASession, const CMemoryStream &Stream);
+    void ParseFrame(CTCPClientConnection *AConnection, CLoadSession *ASession, const CMemoryStream &Stream);
+
+protected:
+
+    bool DoExecute(CTCPConnection *AConnection) override;
+
+    void DoConnected(CObject *Sender) override;
+    void DoDisconnected(CObject *Sender) override;
+
+    void DoException(CTCPConnection *AConnection, const Delphi::Exception::Exception &E) override;
+
+public:
+
+    explicit CLoadClient(const CLoadOptions &Options);
+
+    ~CLoadClient() override;
+
+    void Start();
+
+    void Stop();
+
+    const CMetricHistogram &Latency() const { return m_Latency; }
+
+    uint64_t Replies() const { return m_Replies; }
+    uint64_t Errors() const { return m_Errors; }
+
+    int Connected() const { return m_Connected; }
+
+    bool Recording() const { return m_Recording; }
+    void Recording(bool Value) { m_Recording = Value; }
+
+};
+//----------------------------------------------------------------------------------------------------------------------
+
+CLoadClient::CLoadClient(const CLoadOptions &Options): CTCPAsyncClient(Options.Host.c_str(), Options.Port),
+        m_Options(Options), m_Latency("delphi_load_latency_microseconds", "Request latency.", CString()) {
+
+    m_Replies = 0;
+    m_Errors = 0;
+    m_Connected = 0;
+    m_Recording = false;
+
+    m_AutoConnect = false;
+
+    CHTTPRequest Request;
+
+    Request.Location.hostname = m_Host;
+    Request.Location.port = m_Port;
+    Request.UserAgent = "delphi-load";
+    Request.CloseConnection = false;
+
+    Request.AddHeader("Upgrade", "websocket");
+    CHTTPRequest::Prepare(Request, "GET", "/", nullptr, "Upgrade");
+    Request.AddHeader("Sec-WebSocket-Key", "dGhlIHNhbXBsZSBub25jZQ==");
+    Request.AddHeader("Sec-WebSocket-Version", "13");
+
+    Request.ToBuffers(m_Request);
+
+    CWebSocket Frame;
+    Frame.SetPayload(CString(m_Options.Payload, 'x'), LOAD_WS_MASKING_KEY);
+    Frame.SaveToStream(m_Message);
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+CLoadClient::~CLoadClient() {
+    for (int i = 0; i < m_Sessions.Count(); ++i)
+        delete static_cast<CLoadSession *> (m_Sessions.Items(i));
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CLoadClient::Start() {
+    EventHandlers()->PollStack().TimeOut(LOAD_POLL_TIMEOUT);
+
+    Active(true);
+
+    for (int i = 0; i < m_Options.Connections; ++i)
+        ConnectStart();
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CLoadClient::Stop() {
+    m_Recording = false;
+    Active(false);
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CLoadClient::Send(CTCPClientConnection *AConnection, const CMemoryStream &Data) {
+    AConnection->OutputBuffer().Write(Data.Memory(), Data.Size());
+    AConnection->WriteAsync();
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CLoadClient::SendNext(CTCPClientConnection *AConnection, CLoadSession *ASession) {
+    ASession->Start = MetricsTime();
+
+    if (ASession->Upgraded) {
+        Send(AConnection, m_Message);
+    } else {
+        Send(AConnection, m_Request);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CLoadClient::Complete(CTCPClientConnection *AConnection, CLoadSession *ASession) {
+    if (m_Recording) {
+        m_Latency.ObserveSince(ASession->Start);
+        m_Replies++;
+    }
+
+    SendNext(AConnection, ASession);
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CLoadClient::ParseReply(CTCPClientConnection *AConnection, CLoadSession *ASession, const CMemoryStream &Stream) {
+    CHTTPReplyContext Context((LPCBYTE) Stream.Memory(), Stream.Size(), ASession->State, ASession->ContentLength,
+                              ASession->ChunkedLength);
+
+    switch (CHTTPReplyParser::Parse(ASession->HTTPReply, Context)) {
+        case 0:
+            throw Delphi::Exception::Exception("Invalid HTTP reply.");
+
+        case 1:
+            if (ASession->HTTPReply.Status != CHTTPReply::switching_protocols)
+                throw Delphi::Exception::Exception("WebSocket upgrade refused.");
+            ASession->Upgraded = true;
+            ASession->ClearReply();
+            SendNext(AConnection, ASession);
+            break;
+
+        default:
+            ASession->State = Context.State;
+            ASession->ContentLength = Context.ContentLength;
+            ASession->ChunkedLength = Context.ChunkedLength;
+            break;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CLoadClient::ParseFrame(CTCPClientConnection *AConnection, CLoadSession *ASession, const CMemoryStream &Stream) {
+    while ((size_t) Stream.Position() < Stream.Size()) {
+        if (ASession->WSReply.LoadFromStream(Stream) == -1)
+            break;
+
+        if (ASession->WSReply.Frame().FIN != 0) {
+            ASession->WSReply.Clear();
+            Complete(AConnection, ASession);
+        }
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+bool CLoadClient::DoExecute(CTCPConnection *AConnection) {
+    const auto pConnection = dynamic_cast<CTCPClientConnection *> (AConnection);
+    const auto pSession = static_cast<CLoadSession *> (pConnection->Object());
+
+    CMemoryStream Stream(pConnection->ReadAsync());
+    if (Stream.Size() == 0)
+        return false;
+
+    pConnection->InputBuffer().Extract(Stream.Memory(), Stream.Size());
+
+    if (pSession->Upgraded) {
+        ParseFrame(pConnection, pSession, Stream);
+    } else {
+        ParseReply(pConnection, pSession, Stream);
+    }
+
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CLoadClient::DoConnected(CObject *Sender) {
+    const auto pConnection = dynamic_cast<CTCPClientConnection *> (Sender);
+    const auto pSession = new CLoadSession();
+
+    m_Sessions.Add(pSession);
+    m_Connected++;
+
+    pConnection->Object(pSession);
+
+    SendNext(pConnection, pSession);
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CLoadClient::DoDisconnected(CObject *Sender) {
+    const auto pConnection = dynamic_cast<CTCPClientConnection *> (Sender);
+
+    if (pConnection != nullptr && pConnection->Object() != nullptr) {
+        pConnection->Object(nullptr);
+        m_Connected--;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+void CLoadClient::DoException(CTCPConnection *, const Delphi::Exception::Exception &E) {
+    if (m_Errors++ == 0)
+        ::fprintf(stderr, "delphi-load: %s\n", E.what());
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void ServerExecute(CHTTPServerConnection *AConnection, const CString &Content) {
+    if (AConnection->Protocol() == pWebSocket) {
+        auto &WSReply = AConnection->WSReply();
+        WSReply.Clear();
+        WSReply.SetPayload(AConnection->WSRequest().Payload());
+        AConnection->SendWebSocket(true);
+        return;
+    }
+
+    const auto &Request = AConnection->Request();
+
+    if (Request.Headers["Upgrade"] == "websocket") {
+        AConnection->SwitchingProtocols(CString(), CString());
+        return;
+    }
+
+    auto &Reply = AConnection->Reply();
+
+    Reply.Content = Content;
+    Reply.CloseConnection = false;
+
+    AConnection->SendReply(CHTTPReply::ok, "text/plain");
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Forks a CHTTPServer on the loopback address; returns once it listens. Several workers share the port via SO_REUSEPORT
+static pid_t StartServer(const CLoadOptions &Options) {
+    int Ready[2];
+    if (::pipe(Ready) == -1)
+        throw EOSError(errno, "Could not create pipe: ");
+
+    const pid_t Pid = ::fork();
+    if (Pid == -1)
+        throw EOSError(errno, "Could not fork server: ");
+
+    if (Pid == 0) {
+        ::close(Ready[0]);
+        ::prctl(PR_SET_PDEATHSIG, SIGTERM);
+
+        try {
+            const CString Content(Options.Payload, 'x');
+
+            CHTTPServer Server(Options.Host, Options.Port);
+
+            if (Options.Workers > 1)
+                Server.Bindings()->Add()->ReusePort(true);
+
+            Server.OnExecute([&Content](CTCPConnection *AConnection) {
+                ServerExecute(dynamic_cast<CHTTPServerConnection *> (AConnection), Content);
+                return true;
+            });
+
+            Server.ActiveLevel(alActive);
+
+            const char Byte = 1;
+            if (::write(Ready[1], &Byte, sizeof(Byte)) != sizeof(Byte))
+                ::_exit(1);
+            ::close(Ready[1]);
+
+            for (;;)
+                Server.Wait();
+        } catch (Delphi::Exception::Exception &E) {
+            ::fprintf(stderr, "delphi-load server: %s\n", E.what());
+        }
+
+        ::_exit(1);
+    }
+
+    ::close(Ready[1]);
+
+    char Byte = 0;
+    const auto Count = ::read(Ready[0], &Byte, sizeof(Byte));
+    ::close(Ready[0]);
+
+    if (Count != sizeof(Byte)) {
+        ::waitpid(Pid, nullptr, 0);
+        throw Delphi::Exception::Exception("Load server did not start.");
+    }
+
+    return Pid;
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static bool ParseArgs(int argc, char *argv[], CLoadOptions &Options) {
+    for (int i = 1; i < argc; ++i) {
+        const CString Arg(argv[i]);
+        const bool HasValue = i + 1 < argc;
+
+        if (Arg == "--mode" && HasValue) {
+            Options.Mode = argv[++i];
+        } else if (Arg == "--host" && HasValue) {
+            Options.Host = argv[++i];
+        } else if (Arg == "--port" && HasValue) {
+            Options.Port = (unsigned short) StrToInt(argv[++i]);
+        } else if (Arg == "--connections" && HasValue) {
+            Options.Connections = StrToInt(argv[++i]);
+        } else if (Arg == "--threads" && HasValue) {
+            Options.Threads = StrToInt(argv[++i]);
+        } else if (Arg == "--workers" && HasValue) {
+            Options.Workers = StrToInt(argv[++i]);
+        } else if (Arg == "--rate" && HasValue) {
+            Options.Rate = StrToDouble(argv[++i]);
+        } else if (Arg == "--duration" && HasValue) {
+            Options.Duration = StrToDouble(argv[++i]);
+        } else if (Arg == "--warmup" && HasValue) {
+            Options.Warmup = StrToDouble(argv[++i]);
+        } else if (Arg == "--payload" && HasValue) {
+            Options.Payload = (size_t) StrToInt(argv[++i]);
+        } else if (Arg == "--external") {
+            Options.External = true;
+        } else {
+            return false;
+        }
+    }
+
+    if (Options.Mode == "ws" && (Options.Threads != 1 || Options.Rate != 0))
+        return false;
+
+    return (Options.Mode == "http" || Options.Mode == "ws") && Options.Connections > 0 && Options.Threads > 0 &&
+        Options.Workers > 0 &&
+        Options.Rate >= 0 && Options.Payload > 0;
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void WriteLatency(CJSONWriter &Writer, LPCTSTR Name, const CMetricHistogram &Latency) {
+    const auto Count = Latency.Count();
+
+    Writer.Name(Name);
+    Writer.BeginObject();
+    Writer.Name("mean");
+    Writer.Value(Count == 0 ? 0.0 : (double) Latency.Sum() / (double) Count);
+    Writer.Name("p50");
+    Writer.Value((long int) Latency.Quantile(0.5));
+    Writer.Name("p90");
+    Writer.Value((long int) Latency.Quantile(0.9));
+    Writer.Name("p99");
+    Writer.Value((long int) Latency.Quantile(0.99));
+    Writer.Name("p999");
+    Writer.Value((long int) Latency.Quantile(0.999));
+    Writer.Name("max");
+    Writer.Value((long int) Latency.Quantile(1.0));
+    Writer.EndObject();
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Service time and backlog are only reported for the HTTP generator, where they can differ from the latency
+static void ReportJson(const CLoadOptions &Options, uint64_t Replies, uint64_t Errors, const CMetricHistogram &Latency,
+        const CHTTPLoadGenerator *AGenerator, double Elapsed, CString &Json) {
+
+    CJSONWriter Writer(Json);
+
+    Writer.BeginObject();
+    Writer.Name("suite");
+    Writer.Value("load");
+    Writer.Name("mode");
+    Writer.Value(Options.Mode);
+    Writer.Name("loop");
+    Writer.Value(Options.Rate > 0 ? "open" : "closed");
+    Writer.Name("connections");
+    Writer.Value(Options.Connections);
+    Writer.Name("threads");
+    Writer.Value(Options.Threads);
+    if (!Options.External) {
+        Writer.Name("workers");
+        Writer.Value(Options.Workers);
+    }
+    if (Options.Rate > 0) {
+        Writer.Name("rate");
+        Writer.Value(Options.Rate);
+    }
+    Writer.Name("payload");
+    Writer.Value((long int) Options.Payload);
+    Writer.Name("duration");
+    Writer.Value(Elapsed);
+    Writer.Name("requests");
+    Writer.Value((long int) Replies);
+    Writer.Name("errors");
+    Writer.Value((long int) Errors);
+    Writer.Name("throughput");
+    Writer.Value((double) Replies / Elapsed);
+
+    WriteLatency(Writer, "latency_us", Latency);
+
+    if (AGenerator != nullptr) {
+        WriteLatency(Writer, "service_time_us", AGenerator->ServiceTime());
+        Writer.Name("backlog");
+        Writer.Value((long int) AGenerator->Backlog());
+    }
+
+    Writer.EndObject();
+    Writer.Flush();
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void RunHTTP(const CLoadOptions &Options, CString &Json) {
+    CHTTPLoadGenerator Generator(Options.Host, Options.Port);
+
+    Generator.Connections(Options.Connections);
+    Generator.Threads(Options.Threads);
+    Generator.Rate(Options.Rate);
+
+    const auto Elapsed = Generator.Run(Options.Warmup, Options.Duration);
+
+    ReportJson(Options, Generator.Replies(), Generator.Errors(), Generator.Latency(), &Generator, Elapsed, Json);
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void RunWebSocket(const CLoadOptions &Options, CString &Json) {
+    CLoadClient Client(Options);
+
+    Client.Start();
+
+    const auto Warmup = BenchTime() + (uint64_t) (Options.Warmup * 1e9);
+    while (BenchTime() < Warmup)
+        Client.Wait();
+
+    Client.Recording(true);
+
+    const auto Start = BenchTime();
+    const auto End = Start + (uint64_t) (Options.Duration * 1e9);
+
+    while (BenchTime() < End)
+        Client.Wait();
+
+    const double Elapsed = (double) (BenchTime() - Start) / 1e9;
+
+    Client.Stop();
+
+    ReportJson(Options, Client.Replies(), Client.Errors(), Client.Latency(), nullptr, Elapsed, Json);
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    CLoadOptions Options;
+
+    if (!ParseArgs(argc, argv, Options)) {
+        ::fprintf(stderr, "Usage: %s [--mode http|ws] [--connections <n>] [--duration <seconds>] [--warmup <seconds>]\n"
+                          "       [--payload <bytes>] [--host <ip>] [--port <port>] [--workers <n>] [--external]\n"
+                          "       [--threads <n>] [--rate <requests/s>]    (http only; --rate runs an open loop)\n", argv[0]);
+        return 1;
+    }
+
+    ::signal(SIGPIPE, SIG_IGN);
+
+    TList<pid_t> Servers;
+    int Result = 0;
+
+    try {
+        for (int i = 0; !Options.External && i < Options.Workers; ++i)
+            Servers.Add(StartServer(Options));
+
+        CString Json;
+
+        if (Options.Mode == "ws") {
+            RunWebSocket(Options, Json);
+        } else {
+            RunHTTP(Options, Json);
+        }
+
+        ::printf("%s\n", Json.c_str());
+    } catch (Delphi::Exception::Exception &E) {
+        ::fprintf(stderr, "delphi-load: %s\n", E.what());
+        Result = 1;
+    }
+
+    for (int i = 0; i < Servers.Count(); ++i) {
+        ::kill(Servers[i], SIGTERM);
+        ::waitpid(Servers[i], nullptr, 0);
+    }
+
+    return Result;
+}
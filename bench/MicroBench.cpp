@@ -0,0 +1,673 @@
+/*++
+
+Library name:
+
+  libdelphi
+
+Module Name:
+
+  MicroBench.cpp
+
+Notices:
+
+  Delphi classes for C++
+
+  Micro-benchmarks: strings, lists, streams, hashing, JSON, HTTP, WebSocket, Base64 and variants
+
+Author:
+
+  Copyright (c) Prepodobny Alen
+
+  mailto: alienufo@inbox.ru
+  mailto: ufocomp@gmail.com
+
+--*/
+
+#include "delphi.hpp"
+#include "Bench.hpp"
+//----------------------------------------------------------------------------------------------------------------------
+
+static const char *HTTPRequestText =
+        "GET /api/v1/users/42?fields=name,email HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "User-Agent: delphi-bench/1.0\r\n"
+        "Accept: application/json\r\n"
+        "Accept-Encoding: gzip, deflate\r\n"
+        "Connection: keep-alive\r\n"
+        "X-Request-Id: 7f9c2ba4e88f827d616045507605853e\r\n\r\n";
+//----------------------------------------------------------------------------------------------------------------------
+
+static const char *JsonRecordText =
+        R"({"id": 12345, "name": "some fairly long string value here", "active": true, "score": 98.25, )"
+        R"("tags": ["alpha", "beta", "gamma"], "address": {"city": "Moscow", "zip": "101000"}, "note": null})";
+//----------------------------------------------------------------------------------------------------------------------
+
+static CString MakeText(size_t Size) {
+    CString Text;
+    for (size_t i = 0; i < Size; ++i)
+        Text.Append((TCHAR) ('a' + i % 26));
+    return Text;
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static CString MakeJsonArray(int Count) {
+    CString Json;
+    Json.Append('[');
+    for (int i = 0; i < Count; ++i) {
+        if (i > 0)
+            Json.Append(", ");
+        Json.Append(JsonRecordText);
+    }
+    Json.Append(']');
+    return Json;
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+/*
+ * Reference copy of the recursive serialiser CJSONWriter replaced: every level builds its own CString and
+ * appends it to the parent's. Kept here only so json/serialise_recursive_100 can be set against the writer.
+ */
+static CString RecursiveToString(const CJSONValue &Value);
+
+static CString RecursiveToString(const CJSONElements &Elements) {
+    CString S;
+
+    S += "[";
+
+    for (int i = 0; i < Elements.Count(); i++) {
+        if (i > 0) {
+            S += ", ";
+        }
+
+        S << RecursiveToString(Elements.Values(i));
+    }
+
+    S += "]";
+
+    return S;
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static CString RecursiveToString(const CJSONMembers &Members) {
+    CString S;
+
+    S = "{";
+
+    for (int i = 0; i < Members.Count(); i++) {
+
+        if (i > 0) {
+            S += ", ";
+        }
+
+        S += "\"";
+        S += Members.Members(i).String();
+        S += "\": ";
+
+        S << RecursiveToString(Members.Members(i).Value());
+    }
+
+    S += "}";
+
+    return S;
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static CString RecursiveToString(const CJSONValue &Value) {
+    CString S;
+
+    switch (Value.ValueType()) {
+        case jvtObject:
+            S = RecursiveToString(Value.Object());
+            break;
+
+        case jvtArray:
+            S = RecursiveToString(Value.Array());
+            break;
+
+        case jvtString:
+            S = "\"";
+            S += Value.Data();
+            S += "\"";
+            break;
+
+        case jvtNumber:
+            S = Value.Data();
+            break;
+
+        case jvtBoolean:
+            if (Value.AsBoolean()) {
+                S = "true";
+            } else {
+                S = "false";
+            }
+            break;
+
+        case jvtNull:
+            S = "null";
+            break;
+    }
+
+    return S;
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static CString MakeJsonObject(int Count) {
+    CString Json;
+    Json.Append('{');
+    for (int i = 0; i < Count; ++i) {
+        if (i > 0)
+            Json.Append(", ");
+        Json.Append(CString().Format(R"("member_%d": %d)", i, i));
+    }
+    Json.Append('}');
+    return Json;
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BenchStrings(CBenchRunner &Runner) {
+    const CString Short("short text");
+    const CString Long(MakeText(256));
+    const CString Haystack(MakeText(4096) + "needle");
+
+    Runner.Run("string/copy_short", [&]() {
+        CString S(Short);
+        DoNotOptimize(S);
+    });
+
+    Runner.Run("string/copy_long", Long.Size(), [&]() {
+        CString S(Long);
+        DoNotOptimize(S);
+    });
+
+    Runner.Run("string/move_long", [&]() {
+        CString S(Long);
+        CString T(std::move(S));
+        DoNotOptimize(T);
+    });
+
+    Runner.Run("string/append_8x16", 128, [&]() {
+        CString S;
+        for (int i = 0; i < 8; ++i)
+            S.Append("0123456789abcdef", 16);
+        DoNotOptimize(S);
+    });
+
+    Runner.Run("string/format", [&]() {
+        CString S;
+        S.Format("%s:%d/%s", "localhost", 8080, "index.html");
+        DoNotOptimize(S);
+    });
+
+    Runner.Run("string/find_4k", Haystack.Size(), [&]() {
+        const auto Pos = Haystack.Find("needle");
+        DoNotOptimize(Pos);
+    });
+
+    Runner.Run("string/compare_long", Long.Size(), [&]() {
+        const auto Result = Long.Compare(Long.c_str());
+        DoNotOptimize(Result);
+    });
+
+    Runner.Run("string/lower_256", Long.Size(), [&]() {
+        const CString S(Long.Lower());
+        DoNotOptimize(S);
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BenchLists(CBenchRunner &Runner) {
+    CStringList Names;
+    for (int i = 0; i < 256; ++i)
+        Names.Add(CString().Format("name-%d=value-%d", i, i));
+
+    const CString Last(Names[Names.Count() - 1]);
+
+    Runner.Run("list/tlist_add_1k", [&]() {
+        TList<int> List;
+        for (int i = 0; i < 1000; ++i)
+            List.Add(i);
+        DoNotOptimize(List);
+    });
+
+    Runner.Run("list/stringlist_add_256", [&]() {
+        CStringList List;
+        for (int i = 0; i < Names.Count(); ++i)
+            List.Add(Names[i]);
+        DoNotOptimize(List);
+    });
+
+    Runner.Run("list/stringlist_indexof_256", [&]() {
+        const auto Index = Names.IndexOf(Last);
+        DoNotOptimize(Index);
+    });
+
+    Runner.Run("list/stringlist_values_256", [&]() {
+        const auto &Value = Names.Values("name-128");
+        DoNotOptimize(Value);
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BenchStreams(CBenchRunner &Runner) {
+    const CString Chunk(MakeText(64));
+
+    CMemoryStream Stream;
+    char Buffer[64];
+
+    Runner.Run("stream/write_64x64", 64 * Chunk.Size(), [&]() {
+        Stream.Clear();
+        for (int i = 0; i < 64; ++i)
+            Stream.Write(Chunk.Data(), Chunk.Size());
+        DoNotOptimize(Stream);
+    });
+
+    Runner.Run("stream/read_64x64", 64 * sizeof(Buffer), [&]() {
+        Stream.Position(0);
+        for (int i = 0; i < 64; ++i)
+            Stream.Read(Buffer, sizeof(Buffer));
+        DoNotOptimize(Buffer);
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BenchHashing(CBenchRunner &Runner) {
+    const CString Key("Content-Type");
+    const CString Block(MakeText(1024));
+
+    Runner.Run("hash/buffer_12", Key.Size(), [&]() {
+        const auto Hash = HashBuffer(Key.Data(), Key.Size());
+        DoNotOptimize(Hash);
+    });
+
+    Runner.Run("hash/buffer_1k", Block.Size(), [&]() {
+        const auto Hash = HashBuffer(Block.Data(), Block.Size());
+        DoNotOptimize(Hash);
+    });
+
+    Runner.Run("hash/buffer_1k_nocase", Block.Size(), [&]() {
+        const auto Hash = HashBuffer(Block.Data(), Block.Size(), false);
+        DoNotOptimize(Hash);
+    });
+
+    TList<CString> Keys;
+    THashMap<int> Map(0, false);
+    CStringHash Hash(0, true);
+
+    for (int i = 0; i < 256; ++i) {
+        const CString Name(CString().Format("header-name-%d", i));
+        Keys.Add(Name);
+        Map.Add(Name, i);
+        Hash.Add(Name, i);
+    }
+
+    int Index = 0;
+
+    Runner.Run("hash/hashmap_find_256", [&]() {
+        const auto Value = Map.Find(Keys[Index]);
+        Index = (Index + 1) & 255;
+        DoNotOptimize(Value);
+    });
+
+    Runner.Run("hash/hashmap_add_256", [&]() {
+        THashMap<int> Local;
+        for (int i = 0; i < Keys.Count(); ++i)
+            Local.Add(Keys[i], i);
+        DoNotOptimize(Local);
+    });
+
+    Runner.Run("hash/stringhash_valueof_256", [&]() {
+        const auto Value = Hash.ValueOf(Keys[Index]);
+        Index = (Index + 1) & 255;
+        DoNotOptimize(Value);
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BenchJson(CBenchRunner &Runner) {
+    const CString Record(JsonRecordText);
+    const CString Array(MakeJsonArray(100));
+
+    Runner.Run("json/parse_record", Record.Size(), [&]() {
+        CJSON Json;
+        Json << Record;
+        DoNotOptimize(Json);
+    });
+
+    Runner.Run("json/parse_array_100", Array.Size(), [&]() {
+        CJSON Json;
+        Json << Array;
+        DoNotOptimize(Json);
+    });
+
+    // Large enough that the element and member lists grow several times
+    const CString LargeArray(MakeJsonArray(1600));
+
+    Runner.Run("json/parse_array_1600", LargeArray.Size(), [&]() {
+        CJSON Json;
+        Json << LargeArray;
+        DoNotOptimize(Json);
+    });
+
+    Runner.Run("json/validate_array_100", Array.Size(), [&]() {
+        CJSONReader Reader(Array.Data(), Array.Size());
+        const auto Valid = Reader.Validate();
+        DoNotOptimize(Valid);
+    });
+
+    Runner.Run("json/document_array_100", Array.Size(), [&]() {
+        CJSONDocument Document(Array);
+        DoNotOptimize(Document);
+    });
+
+    const CJSONDocument LargeDocument(LargeArray);
+
+    // Children are walked in order: indexing the array by position would be quadratic
+    Runner.Run("json/document_walk_1600", [&]() {
+        size_t Length = 0;
+        for (const auto &Item : LargeDocument.Root()) {
+            for (const auto &Member : Item)
+                Length += Member.Name().Length() + Member.Length();
+        }
+        DoNotOptimize(Length);
+    });
+
+    CJSON Parsed;
+    Parsed << Array;
+
+    Runner.Run("json/serialise_writer_100", Array.Size(), [&]() {
+        CString Text;
+        CJSONWriter Writer(Text);
+        Writer.WriteJson(Parsed);
+        Writer.Flush();
+        DoNotOptimize(Text);
+    });
+
+    Runner.Run("json/serialise_string_100", Array.Size(), [&]() {
+        const CString Text(Parsed.ToString());
+        DoNotOptimize(Text);
+    });
+
+    Runner.Run("json/serialise_recursive_100", Array.Size(), [&]() {
+        const CString Text(RecursiveToString(Parsed.Array()));
+        DoNotOptimize(Text);
+    });
+
+    // Below JSON_OBJECT_INDEX_THRESHOLD the members are scanned, above it the name index answers
+    for (const int Count : {10, 64, 100, 10000}) {
+        CJSON Object;
+        Object << MakeJsonObject(Count);
+
+        const CString Member(CString().Format("member_%d", Count * 3 / 4));
+        const CString Name(CString().Format("json/member_lookup_%d", Count));
+
+        Runner.Run(Name.c_str(), [&]() {
+            const auto Index = Object.Object().IndexOfString(Member);
+            DoNotOptimize(Index);
+        });
+    }
+
+    CJSON Wide;
+    Wide << MakeJsonObject(100);
+
+    auto &Members = Wide.Object();
+    const CString Member("member_75");
+
+    // Reading a member by position must not throw the name index away
+    Runner.Run("json/member_read_lookup_100", [&]() {
+        const auto &Value = Members.Members(25).Value();
+        const auto Index = Members.IndexOfString(Member);
+        DoNotOptimize(Value);
+        DoNotOptimize(Index);
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BenchHTTP(CBenchRunner &Runner) {
+    const size_t RequestSize = strlen(HTTPRequestText);
+
+    CHTTPRequest Request;
+
+    Runner.Run("http/request_parse", RequestSize, [&]() {
+        Request.Clear();
+        Request::CParserState State = Request::method_start;
+        size_t ContentLength = 0;
+        CHTTPContext Context((LPCBYTE) HTTPRequestText, RequestSize, State, ContentLength);
+        const auto Result = CHTTPRequestParser::Parse(Request, Context);
+        DoNotOptimize(Result);
+    });
+
+    CHTTPReply Reply;
+    CMemoryStream Buffer;
+
+    Runner.Run("http/reply_build", [&]() {
+        Reply.Clear();
+        Reply.ServerName = "libdelphi";
+        Reply.Content = R"({"id":42,"name":"Alice","email":"alice@example.com"})";
+        Reply.CloseConnection = false;
+        CHTTPReply::InitReply(Reply, CHTTPReply::ok, "application/json");
+        Buffer.Clear();
+        Reply.ToBuffers(Buffer);
+        DoNotOptimize(Buffer);
+    });
+
+    const auto ReplySize = (size_t) Buffer.Size();
+
+    // One request through the server path: parse, then build and serialise the reply; allocs_per_op is the
+    // allocations-per-request figure
+    Runner.Run("http/request_reply", RequestSize, [&]() {
+        Request.Clear();
+        Request::CParserState State = Request::method_start;
+        size_t ContentLength = 0;
+        CHTTPContext Context((LPCBYTE) HTTPRequestText, RequestSize, State, ContentLength);
+        CHTTPRequestParser::Parse(Request, Context);
+
+        Reply.Clear();
+        Reply.ServerName = "libdelphi";
+        Reply.Content = R"({"id":42,"name":"Alice","email":"alice@example.com"})";
+        Reply.CloseConnection = false;
+        CHTTPReply::InitReply(Reply, CHTTPReply::ok, "application/json");
+        Buffer.Clear();
+        Reply.ToBuffers(Buffer);
+        DoNotOptimize(Buffer);
+    });
+
+    Runner.Run("http/reply_parse", ReplySize, [&]() {
+        Reply.Clear();
+        CHTTPReplyContext Context((LPCBYTE) Buffer.Memory(), ReplySize);
+        const auto Result = CHTTPReplyParser::Parse(Reply, Context);
+        DoNotOptimize(Result);
+    });
+
+    CHTTPRouter Router;
+    auto OnRoute = [](CHTTPServerConnection *, CHTTPRoute *, const CStringList &) {};
+
+    Router.Add(hmGet, "/", OnRoute);
+    Router.Add(hmGet | hmHead, "/users", OnRoute);
+    Router.Add(hmPost, "/users", OnRoute);
+    Router.Add(hmGet, "/users/me", OnRoute);
+    Router.Add(hmGet | hmDelete, "/users/:id", OnRoute);
+    Router.Add(hmGet, "/users/:id/posts/:post", OnRoute);
+    Router.Add(hmGet, "/static/*path", OnRoute);
+
+    for (int i = 0; i < 64; ++i)
+        Router.Add(hmGet, CString().Format("/api/v1/resource%d/:id", i), OnRoute);
+
+    const CString Method("GET");
+    const CString Static("/users/me");
+    const CString Param("/users/42/posts/7");
+    const CString Wide("/api/v1/resource63/42");
+
+    CStringList Params;
+
+    Runner.Run("http/router_find_static", [&]() {
+        Params.Clear();
+        const auto Route = Router.Find(Method, Static, Params);
+        DoNotOptimize(Route);
+    });
+
+    Runner.Run("http/router_find_params", [&]() {
+        Params.Clear();
+        const auto Route = Router.Find(Method, Param, Params);
+        DoNotOptimize(Route);
+    });
+
+    Runner.Run("http/router_find_wide_64", [&]() {
+        Params.Clear();
+        const auto Route = Router.Find(Method, Wide, Params);
+        DoNotOptimize(Route);
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BenchWebSocket(CBenchRunner &Runner) {
+    const CString Small(MakeText(100));
+    const CString Large(MakeText(4096));
+
+    CWebSocket Frame;
+    CMemoryStream Stream;
+
+    Runner.Run("ws/encode_100", Small.Size(), [&]() {
+        Frame.Clear();
+        Frame.SetPayload(Small);
+        Stream.Clear();
+        Frame.SaveToStream(Stream);
+        DoNotOptimize(Stream);
+    });
+
+    Runner.Run("ws/encode_masked_4k", Large.Size(), [&]() {
+        Frame.Clear();
+        Frame.SetPayload(Large, 0x12345678);
+        Stream.Clear();
+        Frame.SaveToStream(Stream);
+        DoNotOptimize(Stream);
+    });
+
+    Runner.Run("ws/decode_masked_4k", Large.Size(), [&]() {
+        Frame.Clear();
+        Stream.Position(0);
+        const auto Result = Frame.LoadFromStream(Stream);
+        DoNotOptimize(Result);
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BenchBase64(CBenchRunner &Runner) {
+    const CString Plain(MakeText(1024));
+    const CString Encoded(base64_encode(Plain));
+
+    Runner.Run("base64/encode_1k", Plain.Size(), [&]() {
+        const CString Text(base64_encode(Plain));
+        DoNotOptimize(Text);
+    });
+
+    Runner.Run("base64/decode_1k", Encoded.Size(), [&]() {
+        const CString Text(base64_decode(Encoded));
+        DoNotOptimize(Text);
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+
+static void BenchVariant(CBenchRunner &Runner) {
+    const CString Short("short");
+    const CString Long("a text value longer than the inline buffer");
+    const CString Number("1234567890");
+
+    const CVariant Text(Long);
+
+    Runner.Run("variant/assign_short", [&]() {
+        CVariant Value;
+        Value = Short;
+        DoNotOptimize(Value);
+    });
+
+    Runner.Run("variant/copy_long", [&]() {
+        CVariant Value(Text);
+        DoNotOptimize(Value);
+    });
+
+    Runner.Run("variant/move_long", [&]() {
+        CVariant Value(Long);
+        CVariant Moved(std::move(Value));
+        DoNotOptimize(Moved);
+    });
+
+    const CVariant Digits(Number);
+
+    Runner.Run("variant/as_int64", [&]() {
+        const auto Value = Digits.AsInt64();
+        DoNotOptimize(Value);
+    });
+}
+//----------------------------------------------------------------------------------------------------------------------
+#ifdef WITH_SQLITE
+static void BenchSQLite(CBenchRunner &Runner) {
+    SQLite3::CSQLiteConnection Connection(":memory:");
+
+    Connection.Connect();
+    Connection.Exec("create table bench (id integer, name text, score real)");
+
+    TList<CString> Names;
+    for (int i = 0; i < 1000; ++i)
+        Names.Add(CString().Format("row text number %d", i));
+
+    Runner.Run("sqlite/bulk_insert_1k", [&]() {
+        Connection.Exec("delete from bench");
+        const auto Rows = Connection.BulkInsert("insert into bench values (?, ?, ?)", [&](int Row, SQLite3::CCSQLiteParams &Params) {
+            if (Row >= Names.Count())
+                return false;
+            Params.Add(CVariant(Row));
+            Params.Add(CVariant(Names[Row]));
+            Params.Add(CVariant((double) Row / 2));
+            return true;
+        });
+        DoNotOptimize(Rows);
+    });
+
+    // A cursor that outlives a reconnect must release its statement exactly once (run under ASAN to check)
+    SQLite3::CSQLiteConnection Reconnecting(":memory:");
+    Reconnecting.Connect();
+
+    Runner.Run("sqlite/cursor_across_reconnect", [&]() {
+        SQLite3::CSQLiteCursor Cursor(&Reconnecting, "select 1 union all select 2");
+        const auto Row = Cursor.Next();
+        Reconnecting.Disconnect();
+        Reconnecting.Connect();
+        Cursor.Close();
+        DoNotOptimize(Row);
+    });
+}
+#endif
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    CBenchRunner Runner("micro");
+
+    if (!Runner.ParseArgs(argc, argv))
+        return 1;
+
+    try {
+        BenchStrings(Runner);
+        BenchLists(Runner);
+        BenchStreams(Runner);
+        BenchHashing(Runner);
+        BenchJson(Runner);
+        BenchHTTP(Runner);
+        BenchWebSocket(Runner);
+        BenchBase64(Runner);
+        BenchVariant(Runner);
+#ifdef WITH_SQLITE
+        BenchSQLite(Runner);
+#endif
+    } catch (Delphi::Exception::Exception &E) {
+        ::fprintf(stderr, "Error: %s\n", E.what());
+        return 1;
+    }
+
+    if (Runner.Results().Count() > 0) {
+        CString Json;
+        Runner.ToJson(Json);
+        ::printf("%s\n", Json.c_str());
+    }
+
+    return 0;
+}
@@ -33,6 +33,8 @@ Author:
 #include <ctime>
 #include <csignal>
 #include <functional>
+#include <new>
+#include <utility>
 #include <unistd.h>
 #include <fcntl.h>
 #include <malloc.h>
@@ -285,6 +287,10 @@ inline void chMB(LPCSTR szMsg);
 #    include "delphi/JSON.hpp"
 #  endif
 
+#  ifndef DELPHI_METRICS_HPP
+#    include "delphi/Metrics.hpp"
+#  endif
+
 #  ifndef DELPHI_SOCKETS_HPP
 #    include "delphi/Sockets.hpp"
 #  endif
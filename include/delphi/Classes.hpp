@@ -62,9 +62,6 @@ namespace Delphi {
         extern LIB_DELPHI CSysError *GSysError;
         //--------------------------------------------------------------------------------------------------------------
 
-        static pthread_mutex_t GThreadLock;
-        //--------------------------------------------------------------------------------------------------------------
-
         typedef unsigned (*PTHREAD_START)(void *);
         //--------------------------------------------------------------------------------------------------------------
 
@@ -287,6 +284,8 @@ namespace Delphi {
             virtual CPersistent *GetOwner() { return m_pOwner; };
             virtual CPersistent *GetOwner() const { return m_pOwner; };
 
+            void SetOwner(CPersistent *AOwner) { m_pOwner = AOwner; };
+
         public:
 
             explicit CPersistent(CPersistent *AOwner): CObject(), m_pOwner(AOwner) {
@@ -676,6 +675,9 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        #define STRING_INLINE_SIZE 32
+        //--------------------------------------------------------------------------------------------------------------
+
         class LIB_DELPHI CStringStream: public CCustomStringStream
         {
             typedef CCustomStringStream inherited;
@@ -684,12 +686,18 @@ namespace Delphi {
 
             size_t m_Capacity;
 
+            /// Storage for short strings, so they never reach the heap. One spare byte keeps room for the
+            /// terminator written by CCustomString::Str() when the capacity is exactly the size.
+            TCHAR m_Inline[STRING_INLINE_SIZE + 1];
+
             void SetCapacity(size_t NewCapacity);
 
         protected:
 
             virtual LPTSTR Realloc(size_t &NewCapacity);
 
+            void MoveFrom(CStringStream &Source) noexcept;
+
             void SetSize(size_t NewSize) override;
 
             void Capacity(size_t Value) { SetCapacity(Value); };
@@ -734,6 +742,8 @@ namespace Delphi {
 
         protected:
 
+            void MoveFrom(CCustomString &Source) noexcept;
+
             size_t GetLength() const noexcept { return m_Length; };
 
             void SetStr(LPCTSTR Str, size_t Length = 0);
@@ -793,6 +803,8 @@ namespace Delphi {
 
             CString(const CString& S);
 
+            CString(CString&& S) noexcept;
+
             CString(const std::string& str);
 
             CString(LPCTSTR Str, size_t Length = 0);
@@ -895,6 +907,12 @@ namespace Delphi {
                 return *this;
             };
 
+            CString& operator= (CString&& S) noexcept {
+                if (this != &S)
+                    MoveFrom(S);
+                return *this;
+            };
+
             CString& operator= (LPCTSTR Value) {
                 Clear();
                 Create(Value);
@@ -1390,9 +1408,6 @@ namespace Delphi {
         } CStringItem, *PStringItem;
         //--------------------------------------------------------------------------------------------------------------
 
-        typedef PStringItem *PStringItemList;
-        //--------------------------------------------------------------------------------------------------------------
-
         typedef int (*PStringListSortCompare)(CStringList *List, int Index1, int Index2);
         //--------------------------------------------------------------------------------------------------------------
 
@@ -1402,7 +1417,7 @@ namespace Delphi {
 
         private:
 
-            PStringItemList m_pList;
+            PStringItem m_pList;
 
             int m_nCount;
             int m_nCapacity;
@@ -1433,6 +1448,8 @@ namespace Delphi {
             CObject* GetObject(int Index) const override;
             void PutObject(int Index, CObject* AObject) override;
 
+            virtual void InsertItem(int Index, CStringItem &&Item);
+
             virtual void InsertItem(int Index, const CString &S, CObject *AObject);
             virtual void InsertItem(int Index, reference Str, CObject *AObject);
             virtual void InsertItem(int Index, TCHAR C, CObject *AObject);
@@ -1485,6 +1502,9 @@ namespace Delphi {
             void Insert(int Index, TCHAR C) override;
             void InsertObject(int Index, TCHAR C, CObject* AObject) override;
 
+            int Add(CString &&S);
+            void Insert(int Index, CString &&S);
+
             bool OwnsObjects() const { return m_fOwnsObjects; };
 
             CStringList &operator=(const CStringList &Strings) {
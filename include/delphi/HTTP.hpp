@@ -986,6 +986,8 @@ namespace Delphi {
 
             size_t m_ContentLength;
 
+            uint64_t m_RequestStart;
+
             COnHTTPServerParseEvent m_OnParse;
 
             void DoParse(const CMemoryStream &Stream, COnSocketExecuteEvent && OnExecute);
@@ -997,6 +999,8 @@ namespace Delphi {
 
             ~CHTTPServerConnection() override;
 
+            DECLARE_FREE_LIST_ALLOCATOR
+
             void Clear() override;
 
             bool ParseInput(COnSocketExecuteEvent && OnExecute);
@@ -1012,6 +1016,10 @@ namespace Delphi {
             size_t ContentLength() const { return m_ContentLength; }
             void ContentLength(const size_t Value) { m_ContentLength = Value; }
 
+            /// MetricsTime() at which the current request was parsed, 0 once it has been answered
+            uint64_t RequestStart() const { return m_RequestStart; }
+            void RequestStart(uint64_t Value) { m_RequestStart = Value; }
+
             void SendStockReply(CHTTPReply::CStatusType Status, bool bSendNow = false, const CString &RootDir = {});
             void SendReply(CHTTPReply::CStatusType Status, LPCTSTR lpszContentType = nullptr, bool bSendNow = false);
             void SendReply(bool bSendNow = false);
@@ -1045,6 +1053,10 @@ namespace Delphi {
             size_t m_ContentLength;
             size_t m_ChunkedLength;
 
+            uint64_t m_RequestStart;
+
+            CString m_PoolKey;
+
             void Parse(const CMemoryStream &Stream, COnSocketExecuteEvent && OnExecute) override;
 
         protected:
@@ -1072,10 +1084,120 @@ namespace Delphi {
 
             void SendRequest(bool bSendNow = false);
 
+            /// MetricsTime() at which the current request was queued for sending
+            uint64_t RequestStart() const { return m_RequestStart; }
+
+            const CString &PoolKey() const { return m_PoolKey; }
+            void PoolKey(const CString &Value) { m_PoolKey = Value; }
+
         }; // CHTTPServerConnection
 
         //--------------------------------------------------------------------------------------------------------------
 
+        //-- CHTTPRouter -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        enum CHTTPMethod {
+            hmUnknown = 0x0000,
+            hmGet     = 0x0001,
+            hmHead    = 0x0002,
+            hmPost    = 0x0004,
+            hmPut     = 0x0008,
+            hmDelete  = 0x0010,
+            hmPatch   = 0x0020,
+            hmOptions = 0x0040,
+            hmConnect = 0x0080,
+            hmTrace   = 0x0100,
+            hmAny     = 0x01FF
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CHTTPRoute;
+        class CHTTPRouteNode;
+        //--------------------------------------------------------------------------------------------------------------
+
+        typedef std::function<void (CHTTPServerConnection *AConnection, CHTTPRoute *ARoute, const CStringList &Params)> COnHTTPRouteEvent;
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CHTTPRoute: public CObject {
+        private:
+
+            int m_Methods;
+
+            CString m_Pattern;
+
+            Pointer m_Data;
+
+            COnHTTPRouteEvent m_OnRoute;
+
+        public:
+
+            CHTTPRoute(int Methods, const CString &Pattern, COnHTTPRouteEvent && OnRoute);
+
+            int Methods() const { return m_Methods; }
+
+            const CString &Pattern() const { return m_Pattern; }
+
+            Pointer Data() const { return m_Data; }
+            void Data(Pointer Value) { m_Data = Value; }
+
+            const COnHTTPRouteEvent &OnRoute() const { return m_OnRoute; }
+            void OnRoute(COnHTTPRouteEvent && Value) { m_OnRoute = Value; }
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Compiled request router: a trie over path segments where a segment is a literal, a
+         * ":name" capture or a trailing "*name" catch-all. Literal children are found by hash, so
+         * a lookup costs one probe per segment regardless of the number of routes.
+         */
+        class CHTTPRouter: public CObject {
+        private:
+
+            CList m_Routes;
+            CList m_Nodes;
+
+            CStringHash m_Children;
+
+            CHTTPRouteNode *GetNode(int Index) const;
+
+            int AddNode();
+
+            int FindChild(int Index, LPCTSTR Segment, size_t Length);
+
+            bool Match(int Index, LPCTSTR Path, size_t Length, bool AEnd, int Method, CStringList &Params,
+                CHTTPRoute *&ARoute, int &Allowed);
+
+        public:
+
+            CHTTPRouter();
+
+            ~CHTTPRouter() override;
+
+            CHTTPRoute *Add(int Methods, const CString &Pattern, COnHTTPRouteEvent && OnRoute);
+
+            void Clear();
+
+            CHTTPRoute *Find(const CString &Method, const CString &URI, CStringList &Params, int *Allowed = nullptr);
+
+            bool Dispatch(CHTTPServerConnection *AConnection);
+
+            void Dump(CStringList &Lines) const;
+
+            static int MethodOf(const CString &Method);
+            static CString MethodsToString(int Methods);
+
+            int Count() const { return m_Routes.Count(); }
+
+            CHTTPRoute *Routes(int Index) const { return static_cast<CHTTPRoute *> (m_Routes.Items(Index)); }
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
         //-- CHTTPServer -----------------------------------------------------------------------------------------------
 
         //--------------------------------------------------------------------------------------------------------------
@@ -1090,6 +1212,8 @@ namespace Delphi {
 
             CSites m_Sites;
 
+            CHTTPRouter m_Router;
+
             COnHTTPServerParseEvent m_OnParse;
 
             void DoTimeOut(CPollEventHandler *AHandler) override;
@@ -1123,6 +1247,12 @@ namespace Delphi {
             CSites& Sites() { return m_Sites; };
             const CSites& Sites() const { return m_Sites; };
 
+            CHTTPRouter& Router() { return m_Router; };
+            const CHTTPRouter& Router() const { return m_Router; };
+
+            /// Serves the registry (the library default when nullptr) in Prometheus text format on GET Path
+            CHTTPRoute *MountMetrics(const CString &Path = _T("/metrics"), CMetricsRegistry *ARegistry = nullptr);
+
             CHTTPServer &operator = (const CHTTPServer &Server) {
                 Assign(Server);
                 return *this;
@@ -1136,13 +1266,83 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
-        //-- CHTTPClient -----------------------------------------------------------------------------------------------
+        //-- CHTTPConnectionPool ---------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
 
+        #define HTTP_POOL_MAX_IDLE          64
+        #define HTTP_POOL_MAX_IDLE_PER_HOST 8
+        #define HTTP_POOL_IDLE_TIMEOUT      30000
         //--------------------------------------------------------------------------------------------------------------
 
         class CHTTPClient;
         //--------------------------------------------------------------------------------------------------------------
 
+        /**
+         * Idle keep-alive upstream connections keyed by scheme, host and port. A connection is parked
+         * here after a complete reply and handed to the next client for the same key that shares the
+         * same event loop; any input, EOF or the idle timeout while parked closes it.
+         */
+        class CHTTPConnectionPool: public CObject {
+        private:
+
+            CPollManager m_Connections;
+
+            int m_MaxIdle;
+            int m_MaxIdlePerHost;
+            int m_IdleTimeOut;
+
+            size_t m_Hits;
+            size_t m_Misses;
+
+            int IdleCount(const CString &Key);
+
+            void Evict(CHTTPClientConnection *AConnection);
+
+        protected:
+
+            void DoRead(CPollEventHandler *AHandler);
+            void DoWrite(CPollEventHandler *) {};
+            void DoTimeOut(CPollEventHandler *AHandler);
+
+        public:
+
+            CHTTPConnectionPool();
+
+            ~CHTTPConnectionPool() override;
+
+            static CString GetKey(CHTTPClient *AClient);
+
+            static bool KeepAlive(const CHTTPReply &Reply);
+
+            CHTTPClientConnection *Acquire(CHTTPClient *AClient);
+
+            bool Release(CHTTPClient *AClient, CHTTPClientConnection *AConnection);
+
+            void Clear();
+
+            int IdleCount() const { return m_Connections.Count(); }
+
+            size_t Hits() const { return m_Hits; }
+            size_t Misses() const { return m_Misses; }
+
+            int MaxIdle() const { return m_MaxIdle; }
+            void MaxIdle(int Value) { m_MaxIdle = Value; }
+
+            int MaxIdlePerHost() const { return m_MaxIdlePerHost; }
+            void MaxIdlePerHost(int Value) { m_MaxIdlePerHost = Value; }
+
+            int IdleTimeOut() const { return m_IdleTimeOut; }
+            void IdleTimeOut(int Value) { m_IdleTimeOut = Value; }
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CHTTPClient -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
         typedef std::function<void (CHTTPClient *Sender, CHTTPRequest &Request)> COnHTTPClientRequestEvent;
         //--------------------------------------------------------------------------------------------------------------
 
@@ -1153,6 +1353,8 @@ namespace Delphi {
 
         protected:
 
+            CHTTPConnectionPool *m_pPool;
+
             void DoConnectStart(CIOHandlerSocket *AIOHandler, CPollEventHandler *AHandler) override;
 
             void DoConnect(CPollEventHandler *AHandler) override;
@@ -1175,6 +1377,11 @@ namespace Delphi {
 
             ~CHTTPClient() override = default;
 
+            void ConnectStart() override;
+
+            CHTTPConnectionPool *Pool() const { return m_pPool; }
+            void Pool(CHTTPConnectionPool *Value) { m_pPool = Value; }
+
             const COnHTTPClientRequestEvent &OnRequest() const { return m_OnRequest; }
             void OnRequest(COnHTTPClientRequestEvent && Value) { m_OnRequest = Value; }
 
@@ -1207,13 +1414,17 @@ namespace Delphi {
         class CHTTPClientManager: public CCollection {
             typedef CCollection inherited;
 
+        private:
+
+            CHTTPConnectionPool *m_pPool;
+
         protected:
 
             CHTTPClientItem *GetItem(int Index) const override;
 
         public:
 
-            CHTTPClientManager(): CCollection(this) {
+            CHTTPClientManager(): CCollection(this), m_pPool(nullptr) {
 
             };
 
@@ -1221,6 +1432,9 @@ namespace Delphi {
 
             CHTTPClientItem *Add(const CString &Host, unsigned short Port);
 
+            CHTTPConnectionPool *Pool() const { return m_pPool; }
+            void Pool(CHTTPConnectionPool *Value) { m_pPool = Value; }
+
             CHTTPClientItem *Items(int Index) const override { return GetItem(Index); };
 
             CHTTPClientItem *operator[] (int Index) const override { return Items(Index); };
@@ -1229,12 +1443,232 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        //-- CHTTPLoadClient -------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        #define HTTP_LOAD_POLL_TIMEOUT 100 // milliseconds
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CHTTPLoadGenerator;
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * One reactor of a CHTTPLoadGenerator. Every keep-alive connection carries at most one request at a time;
+         * the request is serialised once in Start() and copied to the socket on each send.
+         *
+         * Closed loop (Rate == 0) sends the next request as soon as a reply is parsed. Open loop sends request k at
+         * Start + k / Rate on the first idle connection. When none is idle the request waits, and its latency is
+         * still counted from the time it was due: a server stall shows up in the percentiles instead of silently
+         * slowing the client down (coordinated omission).
+         */
+        class CHTTPLoadClient: public CHTTPClient {
+        private:
+
+            CHTTPLoadGenerator *m_pGenerator;
+
+            CEPollTimer *m_pTimer;
+
+            CMemoryStream m_Request;
+
+            CList m_Sessions;
+            CList m_Idle;
+
+            int m_ConnectionCount;
+            int m_Reconnect;
+
+            uint64_t m_Start;
+            uint64_t m_Stop;
+            uint64_t m_Armed;
+            uint64_t m_Issued;
+
+            /// Microseconds between intended sends, 0 for a closed loop
+            double m_Interval;
+
+            uint64_t m_Replies;
+            uint64_t m_Errors;
+
+            uint64_t Due(uint64_t Now) const;
+            uint64_t Intended(uint64_t Index) const { return m_Start + (uint64_t) ((double) Index * m_Interval); }
+
+            void Send(CHTTPClientConnection *AConnection, uint64_t Intended);
+
+            void Next(CHTTPClientConnection *AConnection, uint64_t Now);
+
+            void Complete(CHTTPClientConnection *AConnection);
+
+            void Schedule(uint64_t Now);
+
+            void Arm(uint64_t Now);
+
+            void DoTimer(CPollEventHandler *AHandler);
+
+        protected:
+
+            void DoConnectStart(CIOHandlerSocket *AIOHandler, CPollEventHandler *AHandler) override;
+
+            void DoRead(CPollEventHandler *AHandler) override;
+
+            bool DoExecute(CTCPConnection *AConnection) override;
+
+            void DoRequest(CHTTPClientConnection *AConnection) override;
+
+            void DoDisconnected(CObject *Sender) override;
+
+            void DoException(CTCPConnection *AConnection, const Delphi::Exception::Exception &E) override;
+
+        public:
+
+            CHTTPLoadClient(CHTTPLoadGenerator *AGenerator, int Connections, double Rate);
+
+            ~CHTTPLoadClient() override;
+
+            /// Opens the connections; Start is the MetricsTime() from which the open-loop schedule is counted
+            void Start(uint64_t Start);
+
+            /// One turn of the event loop, then reopens connections the server has closed
+            void Poll();
+
+            /// Closes the connections; call once the reactor thread has finished
+            void Stop();
+
+            uint64_t Replies() const { return m_Replies; }
+            uint64_t Errors() const { return m_Errors; }
+
+            /// Open-loop requests that are due but not sent yet
+            uint64_t Backlog() const;
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CHTTPLoadThread -------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CHTTPLoadThread: public CThread {
+        private:
+
+            CHTTPLoadClient *m_pClient;
+
+        protected:
+
+            void Execute() override;
+
+        public:
+
+            explicit CHTTPLoadThread(CHTTPLoadClient *AClient);
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CHTTPLoadGenerator ----------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Drives an HTTP server with Connections keep-alive connections spread over Threads reactors, each a
+         * CHTTPLoadClient running in its own thread. Latency is recorded in microseconds while Recording() is set:
+         * Latency() from the time a request was due, ServiceTime() from the time it was written. The two only
+         * differ in open loop, where their gap is the time requests spent waiting for a connection.
+         *
+         * Replies(), Errors() and Backlog() are read from the reactors and are exact only after Stop().
+         */
+        class CHTTPLoadGenerator: public CObject {
+        private:
+
+            CString m_Host;
+            unsigned short m_Port;
+
+            int m_Connections;
+            int m_Threads;
+
+            double m_Rate;
+
+            bool m_Active;
+            bool m_Recording;
+
+            CMetricHistogram m_Latency;
+            CMetricHistogram m_ServiceTime;
+
+            CList m_Clients;
+            CList m_ThreadList;
+
+            COnHTTPClientRequestEvent m_OnRequest;
+
+            void Clear();
+
+        public:
+
+            CHTTPLoadGenerator(const CString &Host, unsigned short Port);
+
+            ~CHTTPLoadGenerator() override;
+
+            void Start();
+
+            void Stop();
+
+            /// Start(), Warmup seconds unrecorded, Duration seconds recorded, Stop(); returns the recorded seconds
+            double Run(double Warmup, double Duration);
+
+            bool Active() const { return m_Active; }
+
+            bool Recording() const { return __atomic_load_n(&m_Recording, __ATOMIC_RELAXED); }
+            void Recording(bool Value) { __atomic_store_n(&m_Recording, Value, __ATOMIC_RELAXED); }
+
+            const CString &Host() const { return m_Host; }
+            unsigned short Port() const { return m_Port; }
+
+            int Connections() const { return m_Connections; }
+            void Connections(int Value) { m_Connections = Value; }
+
+            int Threads() const { return m_Threads; }
+            void Threads(int Value) { m_Threads = Value; }
+
+            /// Requests per second across all connections; 0 runs a closed loop
+            double Rate() const { return m_Rate; }
+            void Rate(double Value) { m_Rate = Value; }
+
+            CMetricHistogram &Latency() { return m_Latency; }
+            const CMetricHistogram &Latency() const { return m_Latency; }
+
+            CMetricHistogram &ServiceTime() { return m_ServiceTime; }
+            const CMetricHistogram &ServiceTime() const { return m_ServiceTime; }
+
+            uint64_t Replies() const;
+            uint64_t Errors() const;
+            uint64_t Backlog() const;
+
+            /// Builds the request template; called once per reactor from Start(). Defaults to "GET /"
+            const COnHTTPClientRequestEvent &OnRequest() const { return m_OnRequest; }
+            void OnRequest(COnHTTPClientRequestEvent && Value) { m_OnRequest = Value; }
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
         //-- CHTTPProxy ------------------------------------------------------------------------------------------------
 
         //--------------------------------------------------------------------------------------------------------------
 
         enum CProxyType { ptHTTP = 0, ptSOCKS5 };
 
+        #define HTTP_TUNNEL_SPLICE_SIZE 65536
+        //--------------------------------------------------------------------------------------------------------------
+
+        /// One direction of a tunnel: bytes read from one peer and not yet written to the other.
+        struct CTunnelChannel
+        {
+            int Pipe[2] = { -1, -1 };
+
+            size_t Pending = 0;
+            size_t Bytes = 0;
+
+            bool Eof = false;
+            bool Shutdown = false;
+        };
+
         class CHTTPProxyManager;
         //--------------------------------------------------------------------------------------------------------------
 
@@ -1248,8 +1682,22 @@ namespace Delphi {
 
             CHTTPRequest m_Request;
 
+            bool m_Tunnel;
+            bool m_Tunnelling;
+            bool m_Splice;
+
+            /// 0: downstream to upstream, 1: upstream to downstream.
+            CTunnelChannel m_Channels[2];
+
             static void Auth(CHTTPClientConnection *AConnection);
             void SOCKS5(CHTTPClientConnection *AConnection);
+
+            static void Relay(CTCPConnection *AFrom, CTCPConnection *ATo, CTunnelChannel &Channel);
+            static void Splice(CTCPConnection *AFrom, CTCPConnection *ATo, CTunnelChannel &Channel);
+
+            void StartTunnel(CHTTPClientConnection *AConnection);
+            void CloseTunnel();
+            void ClosePipes();
 #ifdef WITH_SSL
             void SetUsedSSL(bool Value) override;
 #endif
@@ -1263,10 +1711,16 @@ namespace Delphi {
             void DoHandshake(CHTTPClientConnection *AConnection);
             void DoRequest(CHTTPClientConnection *AConnection) override;
 
+            void DoTunnel(CPollEventHandler *AHandler);
+
         public:
 
             explicit CHTTPProxy(CHTTPProxyManager *AManager, CHTTPServerConnection *AConnection);
 
+            ~CHTTPProxy() override;
+
+            void ConnectStart() override;
+
             CHTTPServerConnection *Connection() const { return m_pConnection; }
 
             CHTTPServer *Server() const { return dynamic_cast<CHTTPServer *> (m_pConnection->Server()); }
@@ -1277,6 +1731,15 @@ namespace Delphi {
             CProxyType ProxyType() const { return m_ProxyType; }
             void ProxyType(const CProxyType Value) { m_ProxyType = Value; }
 
+            bool Tunnel() const { return m_Tunnel; }
+            void Tunnel(bool Value) { m_Tunnel = Value; }
+
+            bool Tunnelling() const { return m_Tunnelling; }
+            bool Spliced() const { return m_Splice; }
+
+            size_t BytesSent() const { return m_Channels[0].Bytes; }
+            size_t BytesReceived() const { return m_Channels[1].Bytes; }
+
         };
 
         //--------------------------------------------------------------------------------------------------------------
@@ -140,54 +140,36 @@ namespace Delphi {
         class CStringHash;
         //--------------------------------------------------------------------------------------------------------------
 
-        class LIB_DELPHI CStringHash: public CObject {
-            typedef CObject inherited;
+        /**
+         * String to index map of the hashed lists. A key added twice resolves to its first value, and empty keys
+         * are never found, as with CString comparison.
+         */
+        class LIB_DELPHI CStringHash: public THashMap<int> {
+            typedef THashMap<int> inherited;
 
-        private:
-
-            size_t m_BucketSize;
-
-            CList **m_Buckets;
-
-            void ClearList(CList *List);
-
-        protected:
+        public:
 
-            struct CHashItem {
-            public:
-                CString Key;
-                int Value;
+            explicit CStringHash(size_t Size = 0, bool CaseSensitive = true): inherited((int) Size, CaseSensitive) {
 
-                CHashItem& operator= (const CHashItem& Item) = default;
             };
 
-            int Find(const CString &Key, CHashItem* &AItem);
-            int Find(LPCTSTR Key, CHashItem* &AItem);
-
-            virtual unsigned HashOf(const CString &Key);
-            virtual unsigned HashOf(LPCTSTR Key);
-
-        public:
-
-            explicit CStringHash(size_t Size = 256);
+            ~CStringHash() override = default;
 
-            ~CStringHash() override;
-
-            inline static class CStringHash* Create(size_t Size = 256) { return new CStringHash(Size); };
+            inline static class CStringHash* Create(size_t Size = 0, bool CaseSensitive = true) {
+                return new CStringHash(Size, CaseSensitive);
+            };
 
             void Add(const CString &Key, int Value);
             void Add(LPCTSTR Key, int Value);
 
-            void Clear();
-
             void Remove(const CString &Key);
             void Remove(LPCTSTR Key);
 
             bool Modify(const CString &Key, int Value);
             bool Modify(LPCTSTR Key, int Value);
 
-            int ValueOf(const CString &Key);
-            int ValueOf(LPCTSTR Key);
+            int ValueOf(const CString &Key) const;
+            int ValueOf(LPCTSTR Key) const;
         };
 
         //--------------------------------------------------------------------------------------------------------------
@@ -213,6 +195,15 @@ namespace Delphi {
             void UpdateValueHash() const;
             void UpdateNameHash() const;
 
+        protected:
+
+            using inherited::InsertItem;
+
+            void InsertItem(int Index, CStringItem &&Item) override;
+
+            void Put(int Index, const CString &S) override;
+            void Put(int Index, LPCTSTR Str) override;
+
         public:
 
             CHashedStringList(): CStringList() {
@@ -237,6 +228,10 @@ namespace Delphi {
 
             ~CHashedStringList() override;
 
+            void Clear() override;
+
+            void Delete(int Index) override;
+
             int IndexOf(const CString &S) const override;
             int IndexOf(LPCTSTR S) const override;
 
@@ -38,6 +38,7 @@ namespace Delphi {
         class CJSONArray;
         class CJSONObject;
         class CJSONParser;
+        class CJSONWriter;
         //--------------------------------------------------------------------------------------------------------------
 
         typedef struct CJSONParserResult {
@@ -62,6 +63,7 @@ namespace Delphi {
 
         class LIB_DELPHI CJSON : public CPersistent {
             friend CJSONValue;
+            friend CJSONWriter;
             typedef LPCTSTR reference;
 
         private:
@@ -80,10 +82,15 @@ namespace Delphi {
 
             virtual CString JsonToString() const;
 
+            virtual void JsonToWriter(CJSONWriter &Writer) const;
+
             void StrToJson(LPCTSTR ABuffer, size_t ASize);
 
             bool JsonToStr(LPTSTR ABuffer, size_t &ASize);
 
+            /// Takes over the value of Source (which is left null) without copying it
+            void MoveFrom(CJSON &Source) noexcept;
+
         public:
 
             typedef TEnumerator<CJSON, TList<CJSON>> Enumerator;
@@ -302,7 +309,7 @@ namespace Delphi {
 
         protected:
 
-            CString JsonToString() const override;
+            void JsonToWriter(CJSONWriter &Writer) const override;
 
             static void Error(const CString &Msg, int Data);
 
@@ -482,7 +489,7 @@ namespace Delphi {
 
         protected:
 
-            CString JsonToString() const override;
+            void JsonToWriter(CJSONWriter &Writer) const override;
 
             static void Error(const CString &Msg, int Data);
 
@@ -784,7 +791,7 @@ namespace Delphi {
 
         protected:
 
-            CString JsonToString() const override;
+            void JsonToWriter(CJSONWriter &Writer) const override;
 
             CJSONValue &GetValue(const CString &String);
 
@@ -810,6 +817,15 @@ namespace Delphi {
                 m_Value = nullptr;
             };
 
+            CJSONValue(const CJSONValue &AValue) : CJSON(this, jvtNull) {
+                Assign(AValue);
+            };
+
+            CJSONValue(CJSONValue &&AValue) noexcept : CJSON(this, jvtNull) {
+                MoveFrom(AValue);
+                m_Data = std::move(AValue.m_Data);
+            };
+
             explicit CJSONValue(CJSONValueType AType) : CJSON(this, AType) {
                 if (AType == jvtObject)
                     GetObject();
@@ -877,6 +893,14 @@ namespace Delphi {
                 return *this;
             }
 
+            CJSONValue &operator=(CJSONValue &&AValue) noexcept {
+                if (this != &AValue) {
+                    MoveFrom(AValue);
+                    m_Data = std::move(AValue.m_Data);
+                }
+                return *this;
+            }
+
             CJSONValue &operator=(const CJSONMembers &AValue) {
                 Assign(AValue);
                 return *this;
@@ -997,6 +1021,11 @@ namespace Delphi {
                 Assign(AValue);
             }
 
+            CJSONMember(CJSONMember &&AValue) noexcept : CPersistent(this), m_String(std::move(AValue.m_String)),
+                    m_Value(std::move(AValue.m_Value)) {
+
+            }
+
             explicit CJSONMember(CJSONValueType ValueType) : CPersistent(this) {
                 m_Value.ValueType(ValueType);
             }
@@ -1137,6 +1166,14 @@ namespace Delphi {
                 return *this;
             }
 
+            CJSONMember &operator=(CJSONMember &&AValue) noexcept {
+                if (this != &AValue) {
+                    m_String = std::move(AValue.m_String);
+                    m_Value = std::move(AValue.m_Value);
+                }
+                return *this;
+            }
+
             virtual CJSONMember &operator<<(const CJSONMember &Element) {
                 if (this != &Element)
                     Assign(Element);
@@ -1315,6 +1352,9 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        #define JSON_OBJECT_INDEX_THRESHOLD 16
+        //--------------------------------------------------------------------------------------------------------------
+
         class LIB_DELPHI CJSONObject : public CJSONMembers {
             typedef CJSONMembers inherited;
             typedef LPCTSTR reference;
@@ -1325,6 +1365,18 @@ namespace Delphi {
 
             CJSONValue m_NullValue;
 
+            mutable CStringHash *m_pIndex;
+
+            mutable bool m_IndexValid;
+
+            void UpdateIndex() const;
+
+            int IndexInserted(int Index);
+
+            void IndexDeleting(int Index);
+
+            void IndexRenaming(int Index, const CString &String);
+
             const CString &GetString(int Index) const override;
 
             CJSONValue &GetValue(const CString &String) override;
@@ -1343,6 +1395,10 @@ namespace Delphi {
 
             void Put(int Index, const CJSONMember &Value) override;
 
+            void PutPair(int Index, const CString &String, const CJSONValue &Value) override;
+
+            void PutPair(int Index, reference String, const CJSONValue &Value) override;
+
             int GetCapacity() const noexcept override;
 
             void SetCapacity(int NewCapacity) override;
@@ -1401,6 +1457,8 @@ namespace Delphi {
 
             void Clear() override;
 
+            /// Call after renaming the member at Index in place, through Members(Index).String(); Put() and the
+            /// other setters keep the name index up to date themselves.
             virtual void Update(int Index);
 
             void Delete(int Index) override;
@@ -1445,6 +1503,10 @@ namespace Delphi {
 
             void Insert(int Index, const CJSONMember &Value) override;
 
+            int IndexOfString(const CString &Value) const override;
+
+            int IndexOfString(reference Value) const override;
+
             bool HasOwnProperty(const CString &String) const override;
 
             CJSONMember &Members(int Index) override { return Get(Index); };
@@ -1523,6 +1585,464 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        //-- CJSONWriter -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        #define JSON_WRITER_BUFFER_SIZE 0x2000
+        #define JSON_WRITER_MAX_DEPTH   128
+        //--------------------------------------------------------------------------------------------------------------
+
+        size_t JsonEscapeScan(LPCTSTR Str, size_t Length);
+        //--------------------------------------------------------------------------------------------------------------
+
+        class LIB_DELPHI CJSONWriter : public CObject {
+        private:
+
+            CStream *m_pStream;
+            CString *m_pString;
+
+            TCHAR m_Buffer[JSON_WRITER_BUFFER_SIZE];
+
+            size_t m_Length;
+            size_t m_Written;
+
+            int m_Depth;
+
+            bool m_First[JSON_WRITER_MAX_DEPTH];
+            bool m_AfterName;
+
+            void Separator();
+
+            void Push();
+            void Pop();
+
+        public:
+
+            explicit CJSONWriter(CStream &Stream);
+
+            explicit CJSONWriter(CString &String);
+
+            ~CJSONWriter() override;
+
+            void Flush();
+
+            void Write(LPCTSTR Str, size_t Length);
+
+            void Write(TCHAR C) {
+                if (m_Length == JSON_WRITER_BUFFER_SIZE)
+                    Flush();
+                m_Buffer[m_Length++] = C;
+            };
+
+            void WriteEncoded(LPCTSTR Str, size_t Length);
+
+            void WriteJson(const CJSON &Json);
+
+            void BeginObject();
+            void EndObject();
+
+            void BeginArray();
+            void EndArray();
+
+            void Name(const CString &String);
+            void Name(LPCTSTR String);
+
+            void Value(const CJSON &Json);
+
+            void Value(const CString &String);
+            void Value(LPCTSTR String);
+
+            void Value(int Number);
+            void Value(long int Number);
+            void Value(double Number);
+
+            void Value(bool Boolean);
+
+            void Null();
+
+            size_t Written() const { return m_Written + m_Length; };
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CJSONHandler ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * SAX interface of CJSONReader::Parse(). String, name and number text points into the source buffer
+         * and is passed raw (still escaped). Returning false from any event stops the parse.
+         */
+        class LIB_DELPHI CJSONHandler : public CObject {
+        public:
+
+            CJSONHandler() : CObject() {};
+
+            ~CJSONHandler() override = default;
+
+            virtual bool OnStartObject() { return true; };
+            virtual bool OnEndObject() { return true; };
+
+            virtual bool OnStartArray() { return true; };
+            virtual bool OnEndArray() { return true; };
+
+            virtual bool OnName(LPCTSTR, size_t) { return true; };
+
+            virtual bool OnString(LPCTSTR, size_t) { return true; };
+            virtual bool OnNumber(LPCTSTR, size_t) { return true; };
+
+            virtual bool OnBoolean(bool) { return true; };
+
+            virtual bool OnNull() { return true; };
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CJSONReader -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        #define JSON_READER_MAX_DEPTH   JSON_WRITER_MAX_DEPTH
+        //--------------------------------------------------------------------------------------------------------------
+
+        size_t JsonStringScan(LPCTSTR Str, size_t Length);
+        size_t JsonStructuralScan(LPCTSTR Str, size_t Length);
+        //--------------------------------------------------------------------------------------------------------------
+
+        enum CJSONToken {
+            jtNone = 0, jtStartObject, jtEndObject, jtStartArray, jtEndArray, jtName, jtString, jtNumber, jtTrue,
+            jtFalse, jtNull, jtEnd, jtError
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Strict (RFC 8259) pull cursor over a byte range. Does not allocate and does not build a CJSON tree:
+         * every token is a pointer into the source buffer, so the buffer must outlive the reader.
+         */
+        class LIB_DELPHI CJSONReader : public CObject {
+        private:
+
+            enum CReaderState {
+                rsValue, rsFirstValue, rsName, rsFirstName, rsComma, rsDone, rsError
+            };
+
+            LPCTSTR m_Begin;
+            LPCTSTR m_End;
+            LPCTSTR m_Pos;
+
+            CJSONToken m_Token;
+
+            LPCTSTR m_Text;
+            size_t m_Length;
+
+            CReaderState m_State;
+
+            int m_Depth;
+
+            TCHAR m_Stack[JSON_READER_MAX_DEPTH];
+
+            void SkipWhiteSpace();
+
+            bool ScanString();
+            bool ScanNumber();
+            bool ScanLiteral(LPCTSTR Literal, size_t Length);
+
+            CJSONToken Error();
+
+            CJSONToken ReadValue(TCHAR C);
+            CJSONToken CloseContainer(TCHAR C);
+
+            CJSONToken AfterValue(CJSONToken Token);
+
+        public:
+
+            CJSONReader(LPCTSTR ABuffer, size_t ASize);
+
+            ~CJSONReader() override = default;
+
+            void Reset();
+
+            CJSONToken Next();
+
+            bool Skip();
+
+            bool Find(LPCTSTR Name, size_t Length);
+            bool Find(const CString &Name) { return Find(Name.Data(), Name.Length()); };
+
+            bool Validate();
+
+            bool Parse(CJSONHandler &Handler);
+
+            CJSONToken Token() const { return m_Token; };
+
+            LPCTSTR Text() const { return m_Text; };
+            size_t Length() const { return m_Length; };
+
+            CString AsString() const;
+
+            int Depth() const { return m_Depth; };
+
+            size_t Position() const { return m_Pos - m_Begin; };
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CJSONBuilder ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CJSONBuilder : public CJSONHandler {
+        private:
+
+            CJSON *m_Json;
+
+            CList *m_pJsonList;
+
+            CJSON &CurrentJson();
+
+            CJSONObject &CurrentObject();
+
+            CJSONArray &CurrentArray();
+
+            bool AddValue(CJSONValueType ValueType, LPCTSTR Str, size_t Length);
+
+            bool AddContainer(CJSONValueType ValueType);
+
+        public:
+
+            explicit CJSONBuilder(CJSON *Json);
+
+            ~CJSONBuilder() override;
+
+            bool OnStartObject() override { return AddContainer(jvtObject); };
+            bool OnEndObject() override;
+
+            bool OnStartArray() override { return AddContainer(jvtArray); };
+            bool OnEndArray() override { return OnEndObject(); };
+
+            bool OnName(LPCTSTR Str, size_t Length) override;
+
+            bool OnString(LPCTSTR Str, size_t Length) override { return AddValue(jvtString, Str, Length); };
+            bool OnNumber(LPCTSTR Str, size_t Length) override { return AddValue(jvtNumber, Str, Length); };
+
+            bool OnBoolean(bool Value) override;
+
+            bool OnNull() override { return AddValue(jvtNull, _T("null"), 4); };
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CJSONDocument ---------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CJSONDocument;
+        //--------------------------------------------------------------------------------------------------------------
+
+        typedef struct CJSONTapeItem {
+            uint32_t Type;      // CJSONValueType
+            uint32_t Next;      // Tape index of the next sibling
+            uint32_t Offset;    // Source offset of the text (strings and names: past the opening quote)
+            uint32_t Length;    // Source length of the text (containers: up to the closing bracket)
+            uint32_t Count;     // Containers: number of members or elements
+        } CJSONTapeItem;
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Read-only view of one node of a CJSONDocument. Valid while the document is alive; a missing member or
+         * index yields a null node, as CJSONObject does.
+         *
+         * operator[](int) and Strings() follow the sibling links from the first child, so an index loop over a
+         * container is quadratic. Walk the children in order instead:
+         *
+         *   for (const auto &Item : Document["items"]) {
+         *       const auto &Name = Item.Name();    // empty for array elements
+         *       const auto Id = Item["id"].AsInteger();
+         *   }
+         */
+        class LIB_DELPHI CJSONNode {
+            typedef LPCTSTR reference;
+
+        private:
+
+            const CJSONDocument *m_pDocument;
+
+            uint32_t m_Index;
+            uint32_t m_Parent;  // Tape index of the enclosing container (the root refers to itself)
+
+            const CJSONTapeItem *Item() const;
+
+            CJSONNode Child(uint32_t Index) const { return {m_pDocument, Index, m_Index}; };
+
+            CJSONNode First() const;
+            CJSONNode Next() const;
+
+        public:
+
+            class const_iterator;
+
+            CJSONNode(): m_pDocument(nullptr), m_Index(0), m_Parent(0) {};
+
+            CJSONNode(const CJSONDocument *ADocument, uint32_t AIndex): m_pDocument(ADocument), m_Index(AIndex),
+                m_Parent(AIndex) {};
+
+            CJSONNode(const CJSONDocument *ADocument, uint32_t AIndex, uint32_t AParent): m_pDocument(ADocument),
+                m_Index(AIndex), m_Parent(AParent) {};
+
+            const_iterator begin() const;
+            const_iterator end() const;
+
+            CJSONValueType ValueType() const;
+
+            bool IsNull() const { return ValueType() == jvtNull; };
+
+            bool IsObject() const { return ValueType() == jvtObject; };
+
+            bool IsArray() const { return ValueType() == jvtArray; };
+
+            bool IsString() const { return ValueType() == jvtString; };
+
+            bool IsNumber() const { return ValueType() == jvtNumber; };
+
+            bool IsBoolean() const { return ValueType() == jvtBoolean; };
+
+            int Count() const;
+
+            int IndexOfString(reference String, size_t Length) const;
+            int IndexOfString(const CString &String) const { return IndexOfString(String.Data(), String.Length()); };
+            int IndexOfString(reference String) const { return IndexOfString(String, strlen(String)); };
+
+            bool HasOwnProperty(const CString &String) const { return IndexOfString(String) != -1; };
+
+            CString Strings(int Index) const;
+
+            CString Name() const;
+
+            LPCTSTR Text() const;
+            size_t Length() const;
+
+            CString Data() const;
+
+            CString AsString() const;
+
+            int AsInteger() const { return StrToInt(Data().c_str()); }
+            long AsLong() const { return StrToInt(Data().c_str()); }
+            float AsFloat() const { return StrToFloat(Data().c_str()); }
+            double AsDouble() const { return StrToDouble(Data().c_str()); }
+            long double AsDecimal() const { return StrToDecimal(Data().c_str()); }
+
+            bool AsBoolean() const;
+
+            void ToJson(CJSON &Json) const;
+
+            CJSONNode operator[](int Index) const;
+
+            CJSONNode operator[](const CString &String) const { return operator[](IndexOfString(String)); };
+
+            CJSONNode operator[](reference String) const { return operator[](IndexOfString(String)); };
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        /// Forward iterator over the children of a CJSONNode (array elements or object member values).
+        class CJSONNode::const_iterator {
+        private:
+
+            CJSONNode m_Node;
+
+        public:
+
+            explicit const_iterator(const CJSONNode &ANode): m_Node(ANode) {};
+
+            const CJSONNode &operator*() const { return m_Node; };
+            const CJSONNode *operator->() const { return &m_Node; };
+
+            const_iterator &operator++() { m_Node = m_Node.Next(); return *this; };
+
+            bool operator==(const const_iterator &Value) const {
+                return m_Node.m_pDocument == Value.m_Node.m_pDocument && m_Node.m_Index == Value.m_Node.m_Index;
+            };
+
+            bool operator!=(const const_iterator &Value) const { return !operator==(Value); };
+
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        inline CJSONNode::const_iterator CJSONNode::begin() const { return const_iterator(First()); }
+        inline CJSONNode::const_iterator CJSONNode::end() const { return const_iterator(CJSONNode()); }
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Immutable parsed document: the source is copied once and every node is a CJSONTapeItem in one flat
+         * tape referring back into that copy. Use ToJson() to get a mutable CJSON tree.
+         */
+        class LIB_DELPHI CJSONDocument : public CObject {
+            friend CJSONNode;
+            typedef LPCTSTR reference;
+
+        private:
+
+            LPTSTR m_Source;
+            size_t m_Size;
+
+            CJSONTapeItem *m_Tape;
+
+            uint32_t m_Count;
+            uint32_t m_Capacity;
+
+            uint32_t NewItem(CJSONValueType Type, size_t Offset, size_t Length);
+
+            void Replay(uint32_t Index, CJSONHandler &Handler) const;
+
+        public:
+
+            CJSONDocument();
+
+            explicit CJSONDocument(const CString &String);
+
+            CJSONDocument(const CJSONDocument &) = delete;
+
+            ~CJSONDocument() override;
+
+            void Clear();
+
+            void Parse(LPCTSTR ABuffer, size_t ASize);
+            void Parse(const CString &String) { Parse(String.Data(), String.Length()); };
+
+            bool IsEmpty() const { return m_Count == 0; };
+
+            size_t Size() const { return m_Size; };
+
+            uint32_t TapeCount() const { return m_Count; };
+
+            CJSONNode Root() const { return {this, 0}; };
+
+            CJSONValueType ValueType() const { return Root().ValueType(); };
+
+            int Count() const { return Root().Count(); };
+
+            bool HasOwnProperty(const CString &String) const { return Root().HasOwnProperty(String); };
+
+            void ToJson(CJSON &Json) const { Root().ToJson(Json); };
+
+            CJSONDocument &operator=(const CJSONDocument &) = delete;
+
+            CJSONNode operator[](int Index) const { return Root()[Index]; };
+
+            CJSONNode operator[](const CString &String) const { return Root()[String]; };
+
+            CJSONNode operator[](reference String) const { return Root()[String]; };
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
         //-- CJSONParser -----------------------------------------------------------------------------------------------
 
         //--------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,359 @@
+/*++
+
+Library name:
+
+  libdelphi
+
+Module Name:
+
+  Metrics.hpp
+
+Notices:
+
+  Delphi classes for C++
+
+  Metrics registry: counters, gauges and latency histograms in Prometheus text format
+
+Author:
+
+  Copyright (c) Prepodobny Alen
+
+  mailto: alienufo@inbox.ru
+  mailto: ufocomp@gmail.com
+
+--*/
+
+#ifndef DELPHI_METRICS_HPP
+#define DELPHI_METRICS_HPP
+//----------------------------------------------------------------------------------------------------------------------
+
+#define METRICS_SHARDS                  16
+#define METRICS_CACHE_LINE              64
+
+#define METRICS_HISTOGRAM_PRECISION     3   // sub-bucket bits: relative error <= 1/8
+#define METRICS_HISTOGRAM_RANGE         40  // values below 2^40 microseconds (~12.7 days)
+#define METRICS_HISTOGRAM_BUCKETS       ((METRICS_HISTOGRAM_RANGE - METRICS_HISTOGRAM_PRECISION + 1) << METRICS_HISTOGRAM_PRECISION)
+
+#define METRICS_CONTENT_TYPE            "text/plain; version=0.0.4"
+//----------------------------------------------------------------------------------------------------------------------
+
+extern "C++" {
+
+namespace Delphi {
+
+    namespace Metrics {
+
+        enum CMetricType {
+            mtCounter, mtGauge, mtHistogram
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        /// Monotonic clock in microseconds
+        LIB_DELPHI uint64_t MetricsTime();
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CMetric ---------------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Base of all metrics. Updates go to a per-thread shard with a relaxed atomic add, so threads never share
+         * a cache line on the hot path; readers sum the shards.
+         */
+        class LIB_DELPHI CMetric: public CObject {
+        private:
+
+            CMetricType m_Type;
+
+            CString m_Name;
+            CString m_Help;
+            CString m_Labels;
+
+        protected:
+
+            static int Shard();
+
+            void AppendName(CString &Text, LPCTSTR Suffix, LPCTSTR Label = nullptr) const;
+
+        public:
+
+            CMetric(CMetricType Type, const CString &Name, const CString &Help, const CString &Labels);
+
+            ~CMetric() override = default;
+
+            virtual void ToText(CString &Text) const abstract;
+
+            CMetricType Type() const { return m_Type; }
+
+            LPCTSTR TypeName() const;
+
+            const CString &Name() const { return m_Name; }
+            const CString &Help() const { return m_Help; }
+
+            /// Prometheus label set without braces, e.g. code="2xx"
+            const CString &Labels() const { return m_Labels; }
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CMetricCounter --------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        struct CMetricCell {
+            int64_t Value;
+            char Padding[METRICS_CACHE_LINE - sizeof(int64_t)];
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        class LIB_DELPHI CMetricCounter: public CMetric {
+        protected:
+
+            CMetricCell m_Cells[METRICS_SHARDS];
+
+            int64_t Sum() const;
+
+            CMetricCounter(CMetricType Type, const CString &Name, const CString &Help, const CString &Labels);
+
+        public:
+
+            CMetricCounter(const CString &Name, const CString &Help, const CString &Labels);
+
+            void Inc(int64_t Delta = 1) {
+                __atomic_fetch_add(&m_Cells[Shard()].Value, Delta, __ATOMIC_RELAXED);
+            }
+
+            int64_t Value() const { return Sum(); }
+
+            void ToText(CString &Text) const override;
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CMetricGauge ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        class LIB_DELPHI CMetricGauge: public CMetricCounter {
+        private:
+
+            int64_t m_Base;
+
+        public:
+
+            CMetricGauge(const CString &Name, const CString &Help, const CString &Labels);
+
+            void Dec(int64_t Delta = 1) { Inc(-Delta); }
+
+            void Set(int64_t Value);
+
+            int64_t Value() const;
+
+            void ToText(CString &Text) const override;
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CMetricHistogram ------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        #define METRICS_HISTOGRAM_SHARD_DATA    ((METRICS_HISTOGRAM_BUCKETS + 2) * sizeof(uint64_t))
+        //--------------------------------------------------------------------------------------------------------------
+
+        struct CMetricHistogramShard {
+            uint64_t Buckets[METRICS_HISTOGRAM_BUCKETS];
+            uint64_t Count;
+            uint64_t Sum;
+            // Whole cache lines, so neighbouring shards of the array never share one
+            char Padding[METRICS_CACHE_LINE - METRICS_HISTOGRAM_SHARD_DATA % METRICS_CACHE_LINE];
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * HDR-style latency histogram over microseconds: log2 groups split into 2^METRICS_HISTOGRAM_PRECISION
+         * linear sub-buckets, so every recorded value is kept with a bounded relative error and a fixed footprint.
+         */
+        class LIB_DELPHI CMetricHistogram: public CMetric {
+        private:
+
+            CMetricHistogramShard *m_pShards;
+
+            void Merge(CMetricHistogramShard &Total) const;
+
+        public:
+
+            CMetricHistogram(const CString &Name, const CString &Help, const CString &Labels);
+
+            ~CMetricHistogram() override;
+
+            static int BucketOf(uint64_t Value);
+            static uint64_t BucketUpper(int Index);
+
+            void Observe(uint64_t Value) {
+                auto &Shard = m_pShards[CMetric::Shard()];
+                __atomic_fetch_add(&Shard.Buckets[BucketOf(Value)], 1, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&Shard.Count, 1, __ATOMIC_RELAXED);
+                __atomic_fetch_add(&Shard.Sum, Value, __ATOMIC_RELAXED);
+            }
+
+            /// Observes the time elapsed since Start (a MetricsTime() value)
+            void ObserveSince(uint64_t Start) { Observe(MetricsTime() - Start); }
+
+            uint64_t Count() const;
+            uint64_t Sum() const;
+
+            /// Upper bound of the bucket holding the given quantile (0..1), in microseconds
+            uint64_t Quantile(double Q) const;
+
+            void ToText(CString &Text) const override;
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CMetricsRegistry ------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Owns the metrics. Lookups take a lock and are meant for start-up; keep the returned pointer and update
+         * it without any locking.
+         */
+        class LIB_DELPHI CMetricsRegistry: public CObject {
+        private:
+
+            CList m_Metrics;
+
+            pthread_mutex_t m_Lock;
+
+            CMetric *Find(const CString &Name, const CString &Labels) const;
+
+            CMetric *Get(CMetricType Type, const CString &Name, const CString &Help, const CString &Labels);
+
+        public:
+
+            CMetricsRegistry();
+
+            ~CMetricsRegistry() override;
+
+            /// Process-wide registry used by the library itself; never destroyed
+            static CMetricsRegistry &Default();
+
+            CMetricCounter *Counter(const CString &Name, const CString &Help, const CString &Labels = CString());
+            CMetricGauge *Gauge(const CString &Name, const CString &Help, const CString &Labels = CString());
+            CMetricHistogram *Histogram(const CString &Name, const CString &Help, const CString &Labels = CString());
+
+            int Count() const { return m_Metrics.Count(); }
+
+            CMetric *Metrics(int Index) const { return static_cast<CMetric *> (m_Metrics.Items(Index)); }
+
+            /// Prometheus text exposition format 0.0.4
+            void ToText(CString &Text);
+
+            CString Text();
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CSharedStats ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        struct CSharedStatsSlot {
+            pid_t Pid;      // owner, 0 - free
+            uint32_t Used;  // ever owned: its counters are kept after release
+            int64_t Values[1];
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        struct CSharedStatsValue {
+            CMetricType Type;
+            CString Name;
+            CString Help;
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Counters and gauges shared by the master and its worker processes. The master defines the values and
+         * calls Create() before forking; the segment is an anonymous MAP_SHARED mapping, so every worker sees it.
+         * A worker claims its own cache-line aligned slot with Acquire() and updates it with relaxed atomics;
+         * the master (or an admin endpoint) reads all slots.
+         */
+        class LIB_DELPHI CSharedStats: public CObject {
+        private:
+
+            CHeap m_Heap;
+
+            TList<CSharedStatsValue> m_Values;
+
+            int m_SlotCount;
+            size_t m_SlotSize;
+
+            char *m_pData;
+
+            int m_Slot;
+
+            CSharedStatsSlot *GetSlot(int Index) const;
+
+        public:
+
+            explicit CSharedStats(int SlotCount);
+
+            CSharedStats(const CSharedStats &) = delete;
+            CSharedStats &operator=(const CSharedStats &) = delete;
+
+            ~CSharedStats() override = default;
+
+            /// Adds a value before Create() and returns its index (mtCounter or mtGauge)
+            int Define(CMetricType Type, const CString &Name, const CString &Help);
+
+            void Create();
+
+            /// Claims a free slot for the calling process; call it in the worker after fork
+            int Acquire();
+
+            /// Frees the slot of a finished worker: counters are kept, gauges are reset
+            void Release(pid_t Pid);
+
+            void Inc(int Index, int64_t Delta = 1) {
+                if (m_Slot != -1)
+                    __atomic_fetch_add(&GetSlot(m_Slot)->Values[Index], Delta, __ATOMIC_RELAXED);
+            }
+
+            void Dec(int Index, int64_t Delta = 1) { Inc(Index, -Delta); }
+
+            void Set(int Index, int64_t Value) {
+                if (m_Slot != -1)
+                    __atomic_store_n(&GetSlot(m_Slot)->Values[Index], Value, __ATOMIC_RELAXED);
+            }
+
+            int64_t Value(int Slot, int Index) const;
+
+            /// Sum over all slots; gauges count only slots owned by a running worker
+            int64_t Total(int Index) const;
+
+            pid_t SlotPid(int Slot) const;
+
+            int Slot() const { return m_Slot; }
+            int SlotCount() const { return m_SlotCount; }
+            int ValueCount() const { return m_Values.Count(); }
+
+            bool Created() const { return m_pData != nullptr; }
+
+            /// Prometheus text, one series per worker slot labelled worker="<slot>"
+            void ToText(CString &Text) const;
+
+        };
+
+    }
+}
+
+using namespace Delphi::Metrics;
+}
+
+#endif //DELPHI_METRICS_HPP
@@ -96,6 +96,8 @@ namespace Delphi {
                 }
             }
 
+            CProvider &operator=(const CProvider &Other) = default;
+
             CJSONObject &Applications() {
                 return m_Params.Object();
             }
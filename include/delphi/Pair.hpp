@@ -50,6 +50,9 @@ namespace Delphi {
                 m_Value = Value;
             }
 
+            TPair(const TPair &Pair) = default;
+            TPair(TPair &&Pair) = default;
+
             TPair &operator=(const TPair &Pair) {
                 if (this != &Pair) {
                     m_Name = Pair.m_Name;
@@ -58,6 +61,15 @@ namespace Delphi {
                 }
                 return *this;
             }
+
+            TPair &operator=(TPair &&Pair) {
+                if (this != &Pair) {
+                    m_Name = std::move(Pair.m_Name);
+                    m_Value = std::move(Pair.m_Value);
+                    m_Data = std::move(Pair.m_Data);
+                }
+                return *this;
+            }
             
             bool IsEmpty() { return m_Value.IsEmpty(); }
 
@@ -99,8 +111,7 @@ namespace Delphi {
             ClassPair m_Default;
 
             void Put(int Index, const ClassPair &Pair) {
-                m_pList.Delete(Index);
-                m_pList.Insert(Index, Pair);
+                m_pList.Items(Index, Pair);
             }
 
             ClassPair &Get(int Index) {
@@ -161,8 +172,8 @@ namespace Delphi {
                 Assign(Value);
             }
 
-            TPairs(TPairs &&Value) noexcept {
-                Assign(Value);
+            TPairs(TPairs &&Value) noexcept: m_pList(std::move(Value.m_pList)) {
+                m_Default = std::move(Value.m_Default);
             }
 
             ~TPairs() override {
@@ -286,6 +297,14 @@ namespace Delphi {
                 return *this;
             }
 
+            TPairs &operator=(TPairs &&Value) noexcept {
+                if (this != &Value) {
+                    m_pList = std::move(Value.m_pList);
+                    m_Default = std::move(Value.m_Default);
+                }
+                return *this;
+            }
+
             TPairs& operator<< (const TPairs &Value) {
                 if (this != &Value)
                     Concat(Value);
@@ -581,6 +581,9 @@ namespace Delphi {
 
             CStringList m_Data;
 
+            uint64_t m_QueuedAt;
+            uint64_t m_StartedAt;
+
             COnPQPollQueryExecutedEvent m_OnExecuted;
 
             COnPQPollQueryExceptionEvent m_OnException;
@@ -738,7 +741,7 @@ namespace Delphi {
 
             CPQPollConnection *GetConnection(int Index) const;
 
-            static CPQPollConnection *GetHandlerConnection(CPollEventHandler *AHandler);
+            CPQPollConnection *GetHandlerConnection(CPollEventHandler *AHandler);
 
             void OnChangeSocket(CPQConnection *AConnection, CSocket AOldSocket);
 
@@ -42,6 +42,27 @@ namespace Delphi {
         enum CProcessType {
             ptMain, ptSingle, ptMaster, ptSignaller, ptNewBinary, ptWorker, ptHelper, ptCustom
         };
+        //--------------------------------------------------------------------------------------------------------------
+
+        #define PROCESS_LIMIT_UNCHANGED     ((uint64_t) -1)
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Placement and limits the master configures once; workers get a copy through Assign() and apply it
+         * with ApplyTuning() right after fork.
+         */
+        struct CProcessTuning {
+            /// "" - no affinity, "auto" - every online CPU, or a list such as "0-3,8,10-11";
+            /// worker N is pinned to the N-th CPU of the list (round-robin)
+            CString CPUAffinity;
+
+            /// Prefer memory from the NUMA node of the pinned CPU
+            bool NUMALocal = false;
+
+            uint64_t LimitNoFile = PROCESS_LIMIT_UNCHANGED;
+            uint64_t LimitCore = PROCESS_LIMIT_UNCHANGED;
+            uint64_t LimitMemLock = PROCESS_LIMIT_UNCHANGED;
+        };
 
         //--------------------------------------------------------------------------------------------------------------
 
@@ -85,6 +106,10 @@ namespace Delphi {
 
             pid_t m_NewBinary;
 
+            CProcessTuning m_Tuning;
+
+            int m_CPU;
+
             bool m_fDaemonized;
 
             Pointer m_pData;
@@ -130,6 +155,13 @@ namespace Delphi {
 
             static void ExecuteProcess(CExecuteContext *AContext);
 
+            /**
+             * Forks and executes a new binary that inherits the listening sockets listed in Sockets ("fd;fd;",
+             * see CSocketHandles::ExportHandles) through SOCKET_INHERIT_ENV. Returns the child pid, also kept
+             * in NewBinary().
+             */
+            pid_t ExecuteNewBinary(CExecuteContext *AContext, const CString &Sockets);
+
             CProcessType Type() const { return m_Type; };
 
             pid_t Pid() const { return m_Pid; };
@@ -177,6 +209,24 @@ namespace Delphi {
 
             static void SetLimitNoFile(uint32_t value);
 
+            /// setrlimit() with soft and hard limits set to Value; PROCESS_LIMIT_UNCHANGED is a no-op
+            static void SetLimit(int Resource, uint64_t Value);
+
+            /// Parses a CPUAffinity list ("auto" - every online CPU) into ASet; returns the number of CPUs
+            static int ParseCPUList(const CString &List, cpu_set_t *ASet);
+
+            /// Pins the calling process to CPU; with NUMALocal also prefers memory from that CPU's node
+            static void SetAffinity(int CPU, bool NUMALocal = false);
+
+            /// Applies Tuning() for the worker with the given index: limits, CPU affinity and NUMA policy
+            void ApplyTuning(int WorkerIndex);
+
+            CProcessTuning &Tuning() { return m_Tuning; };
+            const CProcessTuning &Tuning() const { return m_Tuning; };
+
+            /// CPU the process is pinned to by ApplyTuning(), or -1; e.g. for CSocketHandle::IncomingCPU()
+            int CPU() const { return m_CPU; };
+
         }; // class CCustomProcess
 
     }
@@ -35,6 +35,45 @@ namespace Delphi {
 
     namespace SQLite3 {
 
+        #define SQLITE_STATEMENT_CACHE_SIZE 32
+        #define SQLITE_BULK_BATCH_SIZE      1000
+        //--------------------------------------------------------------------------------------------------------------
+
+        typedef TList<CVariant> CCSQLiteParams;
+        //--------------------------------------------------------------------------------------------------------------
+
+        //- CSQLiteStatement ------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CSQLiteStatement: public CObject {
+        private:
+
+            CString m_SQL;
+
+            sqlite3_stmt *m_Handle;
+
+            bool m_InUse;
+
+        public:
+
+            CSQLiteStatement(const CString &ASQL, sqlite3_stmt *AHandle): CObject(), m_SQL(ASQL), m_Handle(AHandle) {
+                m_InUse = false;
+            };
+
+            ~CSQLiteStatement() override {
+                sqlite3_finalize(m_Handle);
+            };
+
+            const CString &SQL() const { return m_SQL; }
+
+            sqlite3_stmt *Handle() { return m_Handle; }
+
+            bool InUse() const { return m_InUse; }
+            void InUse(bool Value) { m_InUse = Value; }
+
+        };
+
         //--------------------------------------------------------------------------------------------------------------
 
         //- CSQLiteConnection -----------------------------------------------------------------------------------------
@@ -44,6 +83,7 @@ namespace Delphi {
         class CSQLiteConnection;
 
         typedef std::function<void (CSQLiteConnection *AConnection)> COnSQlLiteConnectionEvent;
+        typedef std::function<bool (int Row, CCSQLiteParams &Params)> COnSQlLiteBulkRowEvent;
         //--------------------------------------------------------------------------------------------------------------
 
         class CSQLiteConnection: public CObject {
@@ -55,13 +95,26 @@ namespace Delphi {
 
             int m_ResultCode;
 
+            bool m_Connected;
+
+            CList m_Statements;
+
+            /// In-use statements of a previous connection, finalized on Release()
+            CList m_Detached;
+
+            int m_StatementCacheSize;
+
             COnSQlLiteConnectionEvent m_OnConnected;
             COnSQlLiteConnectionEvent m_OnDisconnected;
 
+            void ClearStatements();
+
         protected:
 
             int GetResultCode();
 
+            void SetStatementCacheSize(int Value);
+
             void DoConnected(CSQLiteConnection *AConnection);
             void DoDisconnected(CSQLiteConnection *AConnection);
 
@@ -77,7 +130,33 @@ namespace Delphi {
 
             void Disconnect();
 
-            bool Connected() { return ResultCode() == SQLITE_OK; }
+            void CheckConnected();
+
+            sqlite3_stmt *Prepare(const CString &SQL);
+
+            void Release(sqlite3_stmt *AHandle);
+
+            void Exec(LPCSTR SQL);
+
+            void BeginTransaction() { Exec("BEGIN"); }
+
+            void Commit() { Exec("COMMIT"); }
+
+            void Rollback() { Exec("ROLLBACK"); }
+
+            /**
+             * Inserts the rows supplied by OnRow with one prepared statement. Outside a transaction it commits every
+             * BatchSize rows; inside the caller's transaction it works under a savepoint and leaves the commit (and
+             * any rollback of the outer transaction) to the caller.
+             */
+            int BulkInsert(const CString &SQL, const COnSQlLiteBulkRowEvent &OnRow, int BatchSize = SQLITE_BULK_BATCH_SIZE);
+
+            int StatementCount() const { return m_Statements.Count(); }
+
+            int StatementCacheSize() const { return m_StatementCacheSize; }
+            void StatementCacheSize(int Value) { SetStatementCacheSize(Value); }
+
+            bool Connected() const { return m_Connected; }
 
             int ResultCode() { return GetResultCode(); }
 
@@ -152,8 +231,6 @@ namespace Delphi {
         typedef std::function<void (CSQLiteQuery *AQuery)> COnSQlLiteQueryExecutedEvent;
         //--------------------------------------------------------------------------------------------------------------
 
-        typedef TList<CVariant> CCSQLiteParams;
-
         class CSQLiteQuery: public CCollection {
             typedef CCollection inherited;
 
@@ -187,12 +264,16 @@ namespace Delphi {
 
             void Connection(CSQLiteConnection *Value) { SetConnection(Value); };
 
-            void Clear() override;
+            void Clear();
 
             int ResultCount() { return inherited::Count(); };
 
             void Execute();
 
+            /// StaticText binds strings without copying; the caller keeps Params alive until the statement is reset
+            static void Bind(CSQLiteConnection *AConnection, sqlite3_stmt *AHandle, const CCSQLiteParams &Params,
+                bool StaticText = false);
+
             CString& SQL() { return m_SQL; }
             const CString& SQL() const { return m_SQL; }
 
@@ -206,6 +287,72 @@ namespace Delphi {
 
         };
 
+        //--------------------------------------------------------------------------------------------------------------
+
+        //- CSQLiteCursor ---------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Forward-only row cursor: steps the cached statement and reads the current row in place
+         * without collecting results.
+         */
+        class CSQLiteCursor: public CObject {
+        private:
+
+            CSQLiteConnection *m_pConnection;
+
+            sqlite3_stmt *m_Handle;
+
+            CString m_SQL;
+
+            CCSQLiteParams m_Params;
+
+            bool m_Active;
+
+        public:
+
+            CSQLiteCursor(CSQLiteConnection *AConnection, const CString &ASQL);
+
+            ~CSQLiteCursor() override;
+
+            void Open();
+
+            void Close();
+
+            bool Next();
+
+            bool Active() const { return m_Active; }
+
+            int ColumnCount() { return sqlite3_column_count(m_Handle); }
+
+            LPCSTR ColumnName(int Index) { return sqlite3_column_name(m_Handle, Index); }
+
+            int ColumnType(int Index) { return sqlite3_column_type(m_Handle, Index); }
+
+            int ColumnSize(int Index) { return sqlite3_column_bytes(m_Handle, Index); }
+
+            bool IsNull(int Index) { return ColumnType(Index) == SQLITE_NULL; }
+
+            int AsInteger(int Index) { return sqlite3_column_int(m_Handle, Index); }
+
+            int64_t AsInt64(int Index) { return sqlite3_column_int64(m_Handle, Index); }
+
+            double AsDouble(int Index) { return sqlite3_column_double(m_Handle, Index); }
+
+            LPCSTR AsText(int Index) { return (LPCSTR) sqlite3_column_text(m_Handle, Index); }
+
+            CString AsString(int Index);
+
+            sqlite3_stmt *Handle() { return m_Handle; }
+
+            const CString& SQL() const { return m_SQL; }
+
+            CCSQLiteParams& Params() { return m_Params; }
+            const CCSQLiteParams& Params() const { return m_Params; }
+
+        };
+
     }
 }
 
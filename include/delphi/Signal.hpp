@@ -37,6 +37,9 @@ Author:
 #define sig_value(n)                sig_value_helper(n)
 //----------------------------------------------------------------------------------------------------------------------
 
+#define SIG_FD_BATCH_SIZE           16
+//----------------------------------------------------------------------------------------------------------------------
+
 #define SIG_SHUTDOWN_SIGNAL         QUIT
 #define SIG_TERMINATE_SIGNAL        TERM
 #define SIG_NOACCEPT_SIGNAL         WINCH
@@ -114,6 +117,9 @@ namespace Delphi {
 
             sigset_t m_SigSet {};
 
+            static sigset_t m_SavedMask;
+            static bool m_MaskSaved;
+
             CSignal *Get(int Index) const;
             void Put(int Index, CSignal *Signal);
 
@@ -123,6 +129,8 @@ namespace Delphi {
 
             CHandle GetHandle() const;
 
+            void DoSignalFD(CPollEventHandler *AHandler);
+
         public:
 
             CSignals(): CCollection(this), m_Handle(INVALID_HANDLE_VALUE) {};
@@ -142,6 +150,22 @@ namespace Delphi {
 
             void SigProcMask(int How, sigset_t *OldSet = nullptr) const;
 
+            /**
+             * Blocks the handled signals and registers a signalfd in the event loop: they then arrive as ordinary
+             * loop events, are read in batches and passed to their CSignal handlers synchronously. Signals without
+             * a handler stay ignored. Call it after InitSignals() and before any thread is started, since the
+             * signal mask is inherited per thread.
+             */
+            CPollEventHandler *AllocateSignalFD(CPollEventHandlers *AEventHandlers);
+
+            /**
+             * Restores the signal mask the process had before the first AllocateSignalFD() call. The mask survives
+             * fork() and execve(), so a child that executes another binary must call it after fork() and before
+             * execve(), or the new image starts with the handled signals blocked. Async-signal-safe; does nothing
+             * if AllocateSignalFD() was never called.
+             */
+            static void RestoreSigMask();
+
             int SignalsCount() const { return Count(); };
 
             CSignal *Signals(int Index) const { return Get(Index); };
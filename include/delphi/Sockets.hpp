@@ -31,6 +31,7 @@ Author:
 #include <sys/socket.h>
 #include <sys/epoll.h>
 //#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #ifdef WITH_SSL
@@ -75,6 +76,10 @@ Author:
 #endif
 //----------------------------------------------------------------------------------------------------------------------
 
+#define SOCKET_INHERIT_ENV      "DELPHI_LISTEN_FDS"
+#define SOCKET_INHERIT_MAX      64
+//----------------------------------------------------------------------------------------------------------------------
+
 #define WS_FIN                  0x80u
 #define WS_MASK                 0x80u
 
@@ -270,6 +275,82 @@ namespace Delphi {
             virtual void SetNonBloking(CSocket ASocket);
 
         };
+#ifdef WITH_SSL
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CSSLContext -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        #define SSL_SESSION_CACHE_SIZE 20480
+        #define SSL_SESSION_ID_CONTEXT "libdelphi"
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Long-lived TLS context shared by all connections of a server or client.
+         * Server contexts keep a session cache and issue tickets; client contexts keep
+         * the last session per upstream (host:port) for resumption.
+         */
+        class LIB_DELPHI CSSLContext: public CObject {
+        private:
+
+            SSL_CTX *m_pContext;
+
+            CSSLMethod m_Method;
+
+            CString m_CertificateFile;
+            CString m_PrivateKeyFile;
+
+            bool m_KTLS;
+
+            long m_SessionCacheSize;
+
+            CList m_Sessions;
+
+            void ClearSessions();
+
+            int IndexOfSession(const CString &Key) const;
+
+        public:
+
+            explicit CSSLContext(CSSLMethod AMethod);
+
+            ~CSSLContext() override;
+
+            void Load();
+
+            void Reload() { Load(); }
+
+            void Clear();
+
+            SSL *New();
+
+            void SaveSession(SSL *ssl, const CString &Key);
+
+            bool RestoreSession(SSL *ssl, const CString &Key);
+
+            bool Active() const { return m_pContext != nullptr; }
+
+            SSL_CTX *Handle() const { return m_pContext; }
+
+            CSSLMethod Method() const { return m_Method; }
+
+            const CString &CertificateFile() const { return m_CertificateFile; }
+            void CertificateFile(const CString &Value) { m_CertificateFile = Value; }
+
+            const CString &PrivateKeyFile() const { return m_PrivateKeyFile; }
+            void PrivateKeyFile(const CString &Value) { m_PrivateKeyFile = Value; }
+
+            bool KTLS() const { return m_KTLS; }
+            void KTLS(bool Value) { m_KTLS = Value; }
+
+            long SessionCacheSize() const { return m_SessionCacheSize; }
+            void SessionCacheSize(long Value) { m_SessionCacheSize = Value; }
+
+            int SessionCount() const { return m_Sessions.Count(); }
+
+        };
+#endif
 
         //--------------------------------------------------------------------------------------------------------------
 
@@ -310,6 +391,63 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        //-- CFreeList -------------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        #define FreeListCapacityDefault 1024
+        //--------------------------------------------------------------------------------------------------------------
+
+        /// Per-thread cache of released blocks for class-specific operator new/delete.
+        /// Only blocks of exactly BlockSize are kept, so derived classes fall through to the global heap.
+        /// Kept trivially destructible: objects freed during static destruction still find a valid list.
+        struct CFreeList {
+            void *Head;
+            size_t Count;
+            bool Armed;     // the thread's CFreeListDrain has been constructed
+            bool Drained;   // the thread is exiting: released blocks go straight back to the heap
+
+            void *Allocate(size_t Size, size_t BlockSize);
+            void Release(void *Block, size_t Size, size_t BlockSize);
+
+            /// Frees the cached blocks and stops caching new ones
+            void Drain();
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        /// Drains a CFreeList when its thread exits; built by the first release in that thread.
+        struct CFreeListDrain {
+            CFreeList &List;
+
+            explicit CFreeListDrain(CFreeList &AList): List(AList) {}
+            ~CFreeListDrain() { List.Drain(); }
+
+            void Arm() { List.Armed = true; }
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        /// Declares the class-specific operator new/delete; DEFINE_FREE_LIST_ALLOCATOR goes in the class's .cpp
+        #define DECLARE_FREE_LIST_ALLOCATOR                                                                             \
+            static void *operator new(size_t Size);                                                                     \
+            static void operator delete(void *Block, size_t Size);
+
+        /// Backs them with a per-thread CFreeList of sizeof(ClassName) blocks, freed when the thread exits
+        #define DEFINE_FREE_LIST_ALLOCATOR(ClassName)                                                                   \
+            static thread_local CFreeList G##ClassName##FreeList = {nullptr, 0, false, false};                          \
+            static thread_local CFreeListDrain G##ClassName##FreeListDrain(G##ClassName##FreeList);                     \
+                                                                                                                        \
+            void *ClassName::operator new(size_t Size) {                                                                \
+                return G##ClassName##FreeList.Allocate(Size, sizeof(ClassName));                                        \
+            }                                                                                                           \
+                                                                                                                        \
+            void ClassName::operator delete(void *Block, size_t Size) {                                                 \
+                if (!G##ClassName##FreeList.Armed)                                                                      \
+                    G##ClassName##FreeListDrain.Arm();                                                                  \
+                G##ClassName##FreeList.Release(Block, Size, sizeof(ClassName));                                         \
+            }
+
+        //--------------------------------------------------------------------------------------------------------------
+
         //-- CSimpleBuffer ---------------------------------------------------------------------------------------------
 
         //--------------------------------------------------------------------------------------------------------------
@@ -392,6 +530,10 @@ namespace Delphi {
             SSL *m_pSSL;
 
             CSSLMethod m_SSLMethod;
+
+            CSSLContext *m_pSSLContext;
+
+            CString m_SessionKey;
 #endif
             int m_SocketType;
 
@@ -407,6 +549,14 @@ namespace Delphi {
             unsigned short m_ClientPortMin;
             unsigned short m_ClientPortMax;
 
+            int m_BackLog;
+            int m_DeferAccept;
+            int m_FastOpen;
+            int m_BusyPoll;
+            int m_IncomingCPU;
+
+            bool m_ReusePort;
+
             bool TryBind();
 
             bool BindPortReserved();
@@ -429,28 +579,42 @@ namespace Delphi {
             explicit CSocketHandle(CCollection *ACollection);
 
             ~CSocketHandle() override;
+
+            DECLARE_FREE_LIST_ALLOCATOR
 #ifdef WITH_SSL
             void AllocateSSL();
             void CloseSSL();
             void ShutdownSSL();
             void ClearSSL();
             void ConnectSSL();
+            void AcceptSSL();
             uint64_t GetOptionsSSL();
             uint64_t SetOptionsSSL(uint64_t op);
 
             CSSLMethod SSLMethod() const { return m_SSLMethod; }
             void SSLMethod(CSSLMethod Value) { m_SSLMethod = Value; }
 
+            CSSLContext *SSLContext() const { return m_pSSLContext; }
+            void SSLContext(CSSLContext *Value) { m_pSSLContext = Value; }
+
             bool UsedSSL() const { return m_SSLMethod != sslNotUsed; }
+
+            bool KTLSSend() const;
 #endif
             bool Accept(CSocket ASocket, unsigned int AFlag);
 
             void AllocateSocket(int ASocketType, int AProtocol, unsigned int AFlag);
 
+            /// Takes over an already bound and listening socket (e.g. inherited from the previous binary)
+            void Adopt(CSocket AHandle);
+
             void Bind();
 
             void CloseSocket(bool AResetLocal = true);
 
+            /// Closes this process's descriptor without shutting the socket down, so other holders keep using it
+            void ReleaseSocket();
+
             static bool GetHostName(char *AName, size_t ASize);
 
             static void GetHostByName(const char *AName, char *VHost, size_t ASize);
@@ -460,6 +624,7 @@ namespace Delphi {
             static bool GetHostIP(char *AIP, size_t ASize);
 
             int Connect(sa_family_t AFamily, LPCSTR AHost, unsigned short APort);
+            int Connect(sa_family_t AFamily, LPCSTR AHost, LPCSTR AIP, unsigned short APort);
 
             bool CheckConnection();
 
@@ -468,6 +633,7 @@ namespace Delphi {
             void GetSockOpt(int ALevel, int AOptName, void *AOptVal, socklen_t AOptLen) const;
 
             void Listen(int anQueueCount) const;
+            void Listen() const;
 
             ssize_t Recv(void *ABuffer, size_t ABufferSize, int AFlags = 0) const;
 
@@ -520,6 +686,31 @@ namespace Delphi {
             unsigned short ClientPortMax() const { return m_ClientPortMax; }
             void ClientPortMax(unsigned short Value) { m_ClientPortMax = Value; }
 
+            /// Listen queue length (listen backlog), SOMAXCONN by default
+            int BackLog() const { return m_BackLog; }
+            void BackLog(int Value) { m_BackLog = Value; }
+
+            /// TCP_DEFER_ACCEPT: seconds to wait for the first data before waking accept (0 - off)
+            int DeferAccept() const { return m_DeferAccept; }
+            void DeferAccept(int Value) { m_DeferAccept = Value; }
+
+            /// TCP_FASTOPEN: pending TFO request queue length (0 - off)
+            int FastOpen() const { return m_FastOpen; }
+            void FastOpen(int Value) { m_FastOpen = Value; }
+
+            /// SO_BUSY_POLL: microseconds to busy-poll the device queue on blocking reads (0 - off);
+            /// accepted sockets inherit it from the listener
+            int BusyPoll() const { return m_BusyPoll; }
+            void BusyPoll(int Value) { m_BusyPoll = Value; }
+
+            /// SO_INCOMING_CPU: CPU whose incoming connections this SO_REUSEPORT listener should get (-1 - off)
+            int IncomingCPU() const { return m_IncomingCPU; }
+            void IncomingCPU(int Value) { m_IncomingCPU = Value; }
+
+            /// SO_REUSEPORT: let several listeners (e.g. workers) share the port
+            bool ReusePort() const { return m_ReusePort; }
+            void ReusePort(bool Value) { m_ReusePort = Value; }
+
             static int LastError() { return GetLastError(); }
         };
 
@@ -554,6 +745,15 @@ namespace Delphi {
 
             CSocketHandle *BindingByHandle(CSocket AHandle);
 
+            /// Appends "fd;" for every allocated handle: the SOCKET_INHERIT_ENV value for a new binary
+            void ExportHandles(CString &Value) const;
+
+            /// IPv4 listening socket bound to IP:Port passed in SOCKET_INHERIT_ENV, or INVALID_SOCKET; each is handed out once
+            static CSocket InheritedSocket(LPCSTR AIP, unsigned short APort);
+
+            /// Closes inherited sockets no binding has claimed and removes SOCKET_INHERIT_ENV
+            static void CloseInheritedSockets();
+
             CSocketHandle *Handles(int Index) const { return GetItem(Index); }
             void Handles(int Index, CSocketHandle *Value) { SetItem(Index, Value); }
 
@@ -624,6 +824,8 @@ namespace Delphi {
             CIOHandlerSocket();
 
             ~CIOHandlerSocket() override;
+
+            DECLARE_FREE_LIST_ALLOCATOR
 #ifdef WITH_SSL
             void Open(CSSLMethod SSLMethod) override;
 
@@ -771,6 +973,8 @@ namespace Delphi {
 
             int IndexOfConnection(CPollConnection *AConnection);
 
+            bool Contains(CPollConnection *AConnection) { return AConnection != nullptr && AConnection->Collection() == this; }
+
             void CloseAllConnection() { Clear(); };
 
             CPollConnection *operator[] (int Index) const override { return dynamic_cast<CPollConnection *> (Items(Index)); };
@@ -1449,6 +1653,8 @@ namespace Delphi {
 
             ~CTCPServerConnection() override;
 
+            DECLARE_FREE_LIST_ALLOCATOR
+
             virtual CPollSocketServer *Server() { return m_pServer; }
 
         }; // CTCPServerConnection
@@ -1473,6 +1679,7 @@ namespace Delphi {
             ~CTCPClientConnection() override;
 
             virtual CPollSocketClient *Client() { return m_pClient; }
+            void Client(CPollSocketClient *Value) { m_pClient = Value; }
 
             bool FreeClient() override;
 
@@ -1493,7 +1700,11 @@ namespace Delphi {
 
             ~CServerIOHandler() override = default;
 
+#ifdef WITH_SSL
+            static CIOHandlerSocket *Accept(CSocket ASocket, int AFlags, CSSLContext *AContext = nullptr);
+#else
             static CIOHandlerSocket *Accept(CSocket ASocket, int AFlags);
+#endif
 
         }; // CServerIOHandler
 
@@ -2136,6 +2347,20 @@ namespace Delphi {
             int m_EventSize;
             int m_TimeOut;
 
+            int m_BusyPoll;
+            int m_SpinWindow;
+
+            uint64_t m_Wakeups;
+            uint64_t m_EventCount;
+            uint64_t m_IdleTime;
+            uint64_t m_SpinTime;
+
+            int Poll(int ATimeOut, const sigset_t *ASigMask);
+
+            int Spin(const sigset_t *ASigMask);
+
+            void SetEventSize(int Value);
+
         protected:
 
             void Ctl(int AOption, CPollEventHandler *AEventHandler);
@@ -2174,6 +2399,23 @@ namespace Delphi {
             CPollEvent *EventList() { return m_pEventList; };
 
             int EventSize() const { return m_EventSize; };
+            void EventSize(int Value) { SetEventSize(Value); };
+
+            /// Busy-poll window in microseconds (0 - off): poll with a zero timeout before blocking.
+            /// The window adapts to the observed gap between events and shrinks while traffic is sparse.
+            int BusyPoll() const { return m_BusyPoll; };
+            void BusyPoll(int Value) { m_BusyPoll = Value; m_SpinWindow = Value; };
+
+            /// Wait() calls that returned events
+            uint64_t Wakeups() const { return m_Wakeups; };
+            /// Events returned in total
+            uint64_t EventCount() const { return m_EventCount; };
+            double EventsPerWakeup() const { return m_Wakeups == 0 ? 0 : (double) m_EventCount / (double) m_Wakeups; };
+            /// Microseconds spent blocked in the kernel and spinning without events
+            uint64_t IdleTime() const { return m_IdleTime; };
+            uint64_t SpinTime() const { return m_SpinTime; };
+
+            void ResetCounters();
 
             CPollEvent *Events(int Index) { return GetEvent(Index); };
 
@@ -2198,7 +2440,7 @@ namespace Delphi {
         typedef std::function<void (CPollEventHandler *AHandler, uint32_t events)> COnPollEventHandlerEPollEvent;
         //--------------------------------------------------------------------------------------------------------------
 
-        enum CPollEventType { etNull, etAccept, etConnect, etIO, etEvent, etDelete, etTimer };
+        enum CPollEventType { etNull, etAccept, etConnect, etIO, etEvent, etDelete, etTimer, etSignal };
         //--------------------------------------------------------------------------------------------------------------
 
         class LIB_DELPHI CEPoll;
@@ -2228,6 +2470,7 @@ namespace Delphi {
             CPollEventHandlers *m_pEventHandlers;
 
             COnPollEventHandlerEvent m_OnTimerEvent;
+            COnPollEventHandlerEvent m_OnSignalEvent;
             COnPollEventHandlerEvent m_OnTimeOutEvent;
 
             COnPollEventHandlerEvent m_OnAcceptEvent;
@@ -2247,6 +2490,7 @@ namespace Delphi {
             void SetTimeStamp(CDateTime Value);
 
             void DoTimerEvent();
+            void DoSignalEvent();
             void DoTimeOutEvent();
 
             void DoAcceptEvent();
@@ -2262,6 +2506,8 @@ namespace Delphi {
 
             ~CPollEventHandler() override;
 
+            DECLARE_FREE_LIST_ALLOCATOR
+
             CSocket Socket() const { return m_Socket; }
 
             uint32_t Events() const { return m_Events; }
@@ -2288,6 +2534,10 @@ namespace Delphi {
             const COnPollEventHandlerEvent &OnTimerEvent() const { return m_OnTimerEvent; }
             void OnTimerEvent(COnPollEventHandlerEvent && Value) { m_OnTimerEvent = Value; }
 
+            COnPollEventHandlerEvent &OnSignalEvent() { return m_OnSignalEvent; }
+            const COnPollEventHandlerEvent &OnSignalEvent() const { return m_OnSignalEvent; }
+            void OnSignalEvent(COnPollEventHandlerEvent && Value) { m_OnSignalEvent = Value; }
+
             COnPollEventHandlerEvent &OnTimeOutEvent() { return m_OnTimeOutEvent; }
             const COnPollEventHandlerEvent &OnTimeOutEvent() const { return m_OnTimeOutEvent; }
             void OnTimeOutEvent(COnPollEventHandlerEvent && Value) { m_OnTimeOutEvent = Value; }
@@ -2329,15 +2579,25 @@ namespace Delphi {
         typedef std::function<void (CPollEventHandler *AHandler, const Delphi::Exception::Exception &E)> COnPollEventHandlerExceptionEvent;
         //--------------------------------------------------------------------------------------------------------------
 
+        class CDNSResolver;
+        //--------------------------------------------------------------------------------------------------------------
+
         class LIB_DELPHI CPollEventHandlers: public CCollection {
             typedef CCollection inherited;
 
             friend CPollEventHandler;
+            friend CEPoll;
 
         private:
 
             CPollStack m_PollStack;
 
+            CDNSResolver *m_pResolver;
+
+            int m_StoppedCount;
+
+            CDateTime m_TimeOutCheck;
+
             COnPollEventHandlerExceptionEvent m_OnException;
 
         protected:
@@ -2349,12 +2609,16 @@ namespace Delphi {
             void PollMod(CPollEventHandler *AHandler);
             void PollDel(CPollEventHandler *AHandler);
 
+            CDNSResolver *GetResolver();
+
             void DoException(CPollEventHandler *AHandler, const Delphi::Exception::Exception &E);
 
         public:
 
             CPollEventHandlers();
 
+            ~CPollEventHandlers() override;
+
             CPollStack &PollStack() { return m_PollStack; };
             const CPollStack &PollStack() const { return m_PollStack; };
 
@@ -2364,6 +2628,9 @@ namespace Delphi {
 
             CPollEventHandler *FindHandlerBySocket(CSocket ASocket);
 
+            CDNSResolver *Resolver() { return GetResolver(); }
+            bool HasResolver() const { return m_pResolver != nullptr; }
+
             CPollEventHandler *Handlers(int Index) const { return GetItem(Index); }
             void Handlers(int Index, CPollEventHandler *Value) { SetItem(Index, Value); }
 
@@ -2425,10 +2692,151 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        //-- CDNSResolver ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        #define DNS_PORT                53
+        #define DNS_PACKET_SIZE         1500
+        #define DNS_RESOLVER_TIMEOUT    5000
+        #define DNS_RESOLVER_ATTEMPTS   2
+        #define DNS_RESOLVER_NDOTS      1
+        #define DNS_RESOLVER_TICK       100
+        #define DNS_CACHE_SIZE          4096
+        #define DNS_CACHE_MIN_TTL       1
+        #define DNS_CACHE_MAX_TTL       3600
+        #define DNS_CACHE_NEGATIVE_TTL  30
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CDNSQuery;
+        class CDNSResolver;
+
+        typedef std::function<void (CDNSResolver *Sender, const CString &Host, LPCSTR IP, int ErrorCode)> COnDNSResolvedEvent;
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Non-blocking IPv4 resolver for the event loop. Queries go out over one UDP socket
+         * registered in the poll stack, retries are driven by a timer, and answers (including
+         * NXDOMAIN/NODATA) are cached for their TTL. Numeric addresses and /etc/hosts entries
+         * never touch the network. Names are expanded with the "search"/"domain" list and the
+         * "ndots" option the way the libc stub resolver does it; a trailing dot disables that.
+         *
+         * ErrorCode carries h_errno values: HOST_NOT_FOUND, NO_DATA or TRY_AGAIN.
+         */
+        class LIB_DELPHI CDNSResolver: public CPollConnection {
+        private:
+
+            CPollEventHandlers *m_pEventHandlers;
+
+            CEPollTimer *m_pTimer;
+
+            CSocket m_Socket;
+
+            CStringList m_Servers;
+            CStringList m_Search;
+
+            CStringHash m_CacheIndex;
+            CList m_Cache;
+
+            CList m_Queries;
+            CDNSQuery *m_pCompleting;
+
+            bool m_Configured;
+            bool m_HostsLoaded;
+            bool m_TimerActive;
+
+            int m_QueryTimeOut;
+            int m_Attempts;
+            int m_NDots;
+
+            int m_CacheSize;
+            int m_MinTTL;
+            int m_MaxTTL;
+            int m_NegativeTTL;
+
+            void Open();
+            void CloseSocket();
+
+            void CheckConfig();
+            void UpdateTimer();
+
+            bool Find(const CString &Key, char *VIP, size_t ASize, int &ErrorCode);
+            void AddCache(const CString &Name, in_addr_t Addr, int ErrorCode, int TTL);
+            void PackCache();
+
+            CDNSQuery *FindQuery(const CString &Name) const;
+            CDNSQuery *FindQuery(uint16_t Id) const;
+
+            void SearchList(const CString &Name, bool Absolute, CStringList &Names) const;
+
+            void Send(CDNSQuery *AQuery);
+            void Complete(CDNSQuery *AQuery, int ErrorCode, in_addr_t Addr);
+
+        protected:
+
+            void DoRead(CPollEventHandler *AHandler);
+            void DoTimer(CPollEventHandler *AHandler);
+
+        public:
+
+            explicit CDNSResolver(CPollEventHandlers *AEventHandlers);
+
+            ~CDNSResolver() override;
+
+            void Close() override;
+
+            void LoadConfig(LPCTSTR lpszFileName = _T("/etc/resolv.conf"));
+            void LoadHosts(LPCTSTR lpszFileName = _T("/etc/hosts"));
+
+            bool Lookup(const CString &Host, char *VIP, size_t ASize);
+
+            void Resolve(const CString &Host, CObject *AOwner, COnDNSResolvedEvent &&OnResolved);
+
+            void Cancel(CObject *AOwner);
+
+            void ClearCache();
+
+            int CacheCount() const { return m_Cache.Count(); }
+            int QueryCount() const { return m_Queries.Count(); }
+
+            CStringList &Servers() { return m_Servers; }
+            const CStringList &Servers() const { return m_Servers; }
+
+            CStringList &Search() { return m_Search; }
+            const CStringList &Search() const { return m_Search; }
+
+            int QueryTimeOut() const { return m_QueryTimeOut; }
+            void QueryTimeOut(int Value) { m_QueryTimeOut = Value; }
+
+            int Attempts() const { return m_Attempts; }
+            void Attempts(int Value) { m_Attempts = Value; }
+
+            int NDots() const { return m_NDots; }
+            void NDots(int Value) { m_NDots = Value; }
+
+            int CacheSize() const { return m_CacheSize; }
+            void CacheSize(int Value) { m_CacheSize = Value; }
+
+            int MinTTL() const { return m_MinTTL; }
+            void MinTTL(int Value) { m_MinTTL = Value; }
+
+            int MaxTTL() const { return m_MaxTTL; }
+            void MaxTTL(int Value) { m_MaxTTL = Value; }
+
+            int NegativeTTL() const { return m_NegativeTTL; }
+            void NegativeTTL(int Value) { m_NegativeTTL = Value; }
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
         //-- CEPoll ----------------------------------------------------------------------------------------------------
 
         //--------------------------------------------------------------------------------------------------------------
 
+        #define POLL_TIMEOUT_CHECK_INTERVAL 1000
+        //--------------------------------------------------------------------------------------------------------------
+
         class LIB_DELPHI CEPoll {
         private:
 
@@ -2503,10 +2911,10 @@ namespace Delphi {
         class LIB_DELPHI CEPollServer: public CPollSocketServer, public CEPoll {
         protected:
 
-            void DoTimeOut(CPollEventHandler *AHandler) override {};
-            void DoAccept(CPollEventHandler *AHandler) override {};
-            void DoConnect(CPollEventHandler *AHandler) override {};
-            void DoError(CPollEventHandler *AHandler) override {};
+            void DoTimeOut(CPollEventHandler *) override {};
+            void DoAccept(CPollEventHandler *) override {};
+            void DoConnect(CPollEventHandler *) override {};
+            void DoError(CPollEventHandler *) override {};
             bool DoExecute(CTCPConnection *AConnection) override;
 
         public:
@@ -2527,10 +2935,10 @@ namespace Delphi {
         protected:
 
             void DoTimeOut(CPollEventHandler *AHandler) override;
-            void DoAccept(CPollEventHandler *AHandler) override {};
+            void DoAccept(CPollEventHandler *) override {};
             void DoRead(CPollEventHandler *AHandler) override;
             void DoWrite(CPollEventHandler *AHandler) override;
-            void DoError(CPollEventHandler *AHandler) override {};
+            void DoError(CPollEventHandler *) override {};
             bool DoExecute(CTCPConnection *AConnection) override;
 
         public:
@@ -2565,6 +2973,9 @@ namespace Delphi {
         protected:
 
             CActiveLevel m_ActiveLevel;
+#ifdef WITH_SSL
+            CSSLContext m_SSLContext;
+#endif
 
             CServerIOHandler *m_pIOHandler;
 
@@ -2588,7 +2999,10 @@ namespace Delphi {
 
             CServerIOHandler *IOHandler() const { return m_pIOHandler; }
             void IOHandler(CServerIOHandler *Value) { SetIOHandler(Value); }
-
+#ifdef WITH_SSL
+            CSSLContext &SSLContext() { return m_SSLContext; }
+            const CSSLContext &SSLContext() const { return m_SSLContext; }
+#endif
             CCommandHandlers &CommandHandlers() { return m_CommandHandlers; }
             const CCommandHandlers &CommandHandlers() const { return m_CommandHandlers; }
 
@@ -2616,6 +3030,8 @@ namespace Delphi {
             bool m_Active;
 #ifdef WITH_SSL
             bool m_UsedSSL;
+
+            CSSLContext m_SSLContext;
 #endif
             CStringList m_Data;
 
@@ -2629,6 +3045,8 @@ namespace Delphi {
 
             virtual void DoConnectStart(CIOHandlerSocket *AIOHandler, CPollEventHandler *AHandler) abstract;
 
+            void ConnectResolved(CIOHandlerSocket *AIOHandler, CPollEventHandler *AHandler, const CString &Host, LPCSTR IP, unsigned short Port);
+
             bool DoCommand(CTCPConnection *AConnection) override;
 
         public:
@@ -2639,7 +3057,7 @@ namespace Delphi {
 
             ~CAsyncClient() override;
 
-            void ConnectStart();
+            virtual void ConnectStart();
 
             void Disconnect() { SetActive(false); };
 
@@ -2651,6 +3069,9 @@ namespace Delphi {
 #ifdef WITH_SSL
             bool UsedSSL() const { return m_UsedSSL; }
             void UsedSSL(bool Value) { SetUsedSSL(Value); }
+
+            CSSLContext &SSLContext() { return m_SSLContext; }
+            const CSSLContext &SSLContext() const { return m_SSLContext; }
 #endif
 
             CCommandHandlers &CommandHandlers() { return m_CommandHandlers; }
@@ -2734,9 +3155,14 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        #define SOCKET_ACCEPT_BUDGET    64
+        //--------------------------------------------------------------------------------------------------------------
+
         class CTCPAsyncServer: public CAsyncServer {
         private:
 
+            int m_AcceptBudget = SOCKET_ACCEPT_BUDGET;
+
             void SetActiveLevel(CActiveLevel AValue) override;
 
             CTCPServerConnection *GetConnection(int AIndex) const;
@@ -2761,6 +3187,16 @@ namespace Delphi {
 
             void InitializeBindings() override;
 
+            /**
+             * Stops accepting and releases the listening sockets without shutting them down, so a new binary that
+             * inherited them keeps listening. Established connections are served until they close.
+             */
+            void StopListening();
+
+            /// Maximum connections accepted per listener wakeup; the rest stay queued for the next poll
+            int AcceptBudget() const { return m_AcceptBudget; }
+            void AcceptBudget(int Value) { m_AcceptBudget = Value; }
+
             CTCPServerConnection *Connections(int Index) const { return GetConnection(Index); }
             void Connections(int Index, CTCPServerConnection *Value) { SetConnection(Index, Value); }
 
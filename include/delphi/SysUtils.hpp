@@ -70,6 +70,10 @@ namespace Delphi {
         LIB_DELPHI size_t MemoryPos(LPSTR ASubStr, LPSTR ABuffer, size_t ASize);
         //--------------------------------------------------------------------------------------------------------------
 
+        /// 64-bit wyhash-style hash; with CaseSensitive false ASCII letters hash as lower case (see strcasecmp)
+        LIB_DELPHI uint64_t HashBuffer(const void *Buffer, size_t Size, bool CaseSensitive = true, uint64_t Seed = 0);
+        //--------------------------------------------------------------------------------------------------------------
+
         LIB_DELPHI BOOL OSCheck(BOOL RetVal);
         //--------------------------------------------------------------------------------------------------------------
 
@@ -39,16 +39,23 @@ namespace Delphi {
         template<class ClassName>
         class TList : public CObject, public CHeapComponent {
             typedef ClassName *PClassName;
-            typedef PClassName *PClassNameList;
 
         private:
 
-            PClassNameList m_pList;
+            PClassName m_pList;
 
             int m_nCount;
             int m_nCapacity;
 
-            void QuickSort(PClassNameList SortList, int L, int R, ListSortCompare SCompare);
+            static void Swap(ClassName &Item1, ClassName &Item2);
+
+            static void Relocate(PClassName Dest, PClassName Source, int Count);
+
+            bool Contains(const ClassName &Item) const;
+
+            PClassName InsertSlot(int Index);
+
+            void QuickSort(int L, int R, ListSortCompare SCompare);
 
         protected:
 
@@ -56,8 +63,6 @@ namespace Delphi {
 
             PClassName Get(int Index) const;
 
-            void Put(int Index, PClassName Item);
-
             ClassName &GetItem(int Index);
 
             const ClassName &GetItem(int Index) const;
@@ -72,22 +77,28 @@ namespace Delphi {
 
             TList();
 
+            TList(const TList<ClassName> &Value);
+
+            TList(TList<ClassName> &&Value) noexcept;
+
             ~TList() override;
 
             virtual void Clear();
 
             void Exchange(int Index1, int Index2);
 
+            /// Kept for TEnumerator and source compatibility: it no longer grows the list, since with contiguous
+            /// storage a grow moves every item and would invalidate outstanding references
             TList<ClassName> *Expand();
 
-            PClassName Extract(PClassName Item);
-
             int IndexOf(PClassName Item) const;
 
             int IndexOf(const ClassName &Item) const;
 
             void Insert(int Index, const ClassName &Item);
 
+            void Insert(int Index, ClassName &&Item);
+
             ClassName &First();
 
             const ClassName &First() const;
@@ -98,14 +109,18 @@ namespace Delphi {
 
             int Add(const ClassName &Item);
 
+            int Add(ClassName &&Item);
+
+            /// Constructs a new last item in place; the arguments must not refer to items of this list
+            template<class... Args>
+            ClassName &Emplace(Args&&... AArgs);
+
             void Delete(int Index);
 
             void Move(int CurIndex, int NewIndex);
 
             int Remove(const ClassName &Item);
 
-            void Pack();
-
             void Sort(ListSortCompare Compare);
 
             void Assign(TList<ClassName> *ListA, ListAssignOp AOperator = laCopy, TList<ClassName> *ListB = nullptr);
@@ -122,7 +137,7 @@ namespace Delphi {
 
             int Count() const noexcept { return GetCount(); }
 
-            PClassNameList GetList() const { return m_pList; }
+            PClassName GetList() const { return m_pList; }
 
             ClassName &Items(int Index) { return GetItem(Index); }
 
@@ -140,6 +155,16 @@ namespace Delphi {
                 return *this;
             }
 
+            TList<ClassName> &operator=(TList<ClassName> &&Value) noexcept {
+                if (this != &Value) {
+                    Clear();
+                    std::swap(m_pList, Value.m_pList);
+                    std::swap(m_nCount, Value.m_nCount);
+                    std::swap(m_nCapacity, Value.m_nCapacity);
+                }
+                return *this;
+            }
+
             ClassName &operator[](int Index) { return GetItem(Index); }
             const ClassName &operator[](int Index) const { return GetItem(Index); }
 
@@ -238,49 +263,85 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        template<class ClassName>
+        TList<ClassName>::TList(const TList<ClassName> &Value): TList() {
+            *this = Value;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassName>
+        TList<ClassName>::TList(TList<ClassName> &&Value) noexcept: TList() {
+            *this = std::move(Value);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         template<class ClassName>
         TList<ClassName>::~TList() {
             Clear();
-            if (m_pList != nullptr)
-                GHeap->Free(0, m_pList, m_nCapacity * sizeof(PClassName));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         template<class ClassName>
-        ClassName *TList<ClassName>::Get(int Index) {
-            if ((Index < 0) || (m_pList == nullptr) || (Index >= m_nCount))
-                throw ExceptionFrm(SListIndexError, Index);
+        void TList<ClassName>::Swap(ClassName &Item1, ClassName &Item2) {
+            ClassName Temp;
+            Temp = std::move(Item1);
+            Item1 = std::move(Item2);
+            Item2 = std::move(Temp);
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
-            return m_pList[Index];
+        template<class ClassName>
+        void TList<ClassName>::Relocate(PClassName Dest, PClassName Source, int Count) {
+            // Items are default-constructed and then assigned: several item classes keep pointers to themselves
+            // and only their assignment operators know how to rebuild them.
+            for (int i = 0; i < Count; i++) {
+                ::new (&Dest[i]) ClassName();
+                Dest[i] = std::move(Source[i]);
+                Source[i].~ClassName();
+            }
         }
         //--------------------------------------------------------------------------------------------------------------
 
         template<class ClassName>
-        ClassName *TList<ClassName>::Get(int Index) const {
-            if ((Index < 0) || (m_pList == nullptr) || (Index >= m_nCount))
+        bool TList<ClassName>::Contains(const ClassName &Item) const {
+            return (m_pList != nullptr) && (&Item >= m_pList) && (&Item < m_pList + m_nCount);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassName>
+        ClassName *TList<ClassName>::InsertSlot(int Index) {
+            if ((Index < 0) || (Index > m_nCount))
                 throw Delphi::Exception::ExceptionFrm(SListIndexError, Index);
 
-            return m_pList[Index];
+            if (m_nCount == m_nCapacity)
+                Grow();
+
+            ::new (&m_pList[m_nCount]) ClassName();
+
+            for (int i = m_nCount; i > Index; i--)
+                m_pList[i] = std::move(m_pList[i - 1]);
+
+            m_nCount++;
+
+            return &m_pList[Index];
         }
         //--------------------------------------------------------------------------------------------------------------
 
         template<class ClassName>
-        void TList<ClassName>::Put(int Index, PClassName Item) {
-            PClassName Temp;
-
+        ClassName *TList<ClassName>::Get(int Index) {
             if ((Index < 0) || (m_pList == nullptr) || (Index >= m_nCount))
-                throw Delphi::Exception::ExceptionFrm(SListIndexError, Index);
+                throw ExceptionFrm(SListIndexError, Index);
 
-            if (Item != m_pList[Index]) {
-                Temp = m_pList[Index];
-                m_pList[Index] = Item;
+            return &m_pList[Index];
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
-                if (Temp != nullptr)
-                    Notify(Temp, lnDeleted);
+        template<class ClassName>
+        ClassName *TList<ClassName>::Get(int Index) const {
+            if ((Index < 0) || (m_pList == nullptr) || (Index >= m_nCount))
+                throw Delphi::Exception::ExceptionFrm(SListIndexError, Index);
 
-                if (Item != nullptr)
-                    Notify(Temp, lnAdded);
-            }
+            return &m_pList[Index];
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -298,20 +359,13 @@ namespace Delphi {
 
         template<class ClassName>
         void TList<ClassName>::PutItem(int Index, const ClassName &Item) {
-            PClassName Temp;
-
             if ((Index < 0) || (m_pList == nullptr) || (Index >= m_nCount))
                 throw Delphi::Exception::ExceptionFrm(SListIndexError, Index);
 
-            if (&Item != m_pList[Index]) {
-                Temp = m_pList[Index];
-
-                if (Temp != nullptr)
-                    Notify(Temp, lnDeleted);
-
-                *m_pList[Index] = Item;
-
-                Notify(Temp, lnAdded);
+            if (&Item != &m_pList[Index]) {
+                Notify(&m_pList[Index], lnDeleted);
+                m_pList[Index] = Item;
+                Notify(&m_pList[Index], lnAdded);
             }
         }
         //--------------------------------------------------------------------------------------------------------------
@@ -332,7 +386,7 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         template<class ClassName>
-        void TList<ClassName>::Notify(PClassName Item, ListNotification Action) {
+        void TList<ClassName>::Notify(PClassName, ListNotification) {
 
         }
         //--------------------------------------------------------------------------------------------------------------
@@ -343,20 +397,17 @@ namespace Delphi {
                 throw Delphi::Exception::ExceptionFrm(SListCapacityError, NewCapacity);
 
             if (NewCapacity != m_nCapacity) {
-                if (NewCapacity == 0) {
-                    m_pList = (PClassNameList) GHeap->Free(0, m_pList, m_nCapacity * sizeof(PClassName));
-                } else {
-                    if (m_nCapacity == 0) {
-                        m_pList = (PClassNameList) GHeap->Alloc(0, NewCapacity * sizeof(PClassName));
-                    } else {
-                        m_pList = (PClassNameList) GHeap->ReAlloc(0, m_pList, NewCapacity * sizeof(PClassName),
-                                                                  m_nCapacity * sizeof(PClassName));
-                    }
+                PClassName List = nullptr;
 
-                    if (m_pList == nullptr)
-                        throw Delphi::Exception::Exception(_T("Out of memory while expanding memory heap"));
+                if (NewCapacity > 0) {
+                    List = (PClassName) GHeap->Alloc(0, NewCapacity * sizeof(ClassName));
+                    Relocate(List, m_pList, m_nCount);
                 }
 
+                if (m_pList != nullptr)
+                    GHeap->Free(0, m_pList, m_nCapacity * sizeof(ClassName));
+
+                m_pList = List;
                 m_nCapacity = NewCapacity;
             }
         }
@@ -370,13 +421,14 @@ namespace Delphi {
             if (NewCount > m_nCapacity)
                 SetCapacity(NewCount);
 
-            if (NewCount > m_nCount)
-                ZeroMemory(&m_pList[m_nCount], (NewCount - m_nCount) * sizeof(PClassName));
-            else
+            if (NewCount > m_nCount) {
+                for (int i = m_nCount; i < NewCount; i++)
+                    ::new (&m_pList[i]) ClassName();
+                m_nCount = NewCount;
+            } else {
                 for (int i = m_nCount - 1; i >= NewCount; i--)
                     Delete(i);
-
-            m_nCount = NewCount;
+            }
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -389,61 +441,28 @@ namespace Delphi {
 
         template<class ClassName>
         void TList<ClassName>::Exchange(int Index1, int Index2) {
-            PClassName Item;
-
             if ((Index1 < 0) || (Index1 >= m_nCount))
                 throw Delphi::Exception::ExceptionFrm(SListIndexError, Index1);
             if ((Index2 < 0) || (Index2 >= m_nCount))
                 throw Delphi::Exception::ExceptionFrm(SListIndexError, Index2);
-            Item = m_pList[Index1];
-            m_pList[Index1] = m_pList[Index2];
-            m_pList[Index2] = Item;
+
+            if (Index1 != Index2)
+                Swap(m_pList[Index1], m_pList[Index2]);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         template<class ClassName>
         TList<ClassName> *TList<ClassName>::Expand() {
-            if (m_nCount == m_nCapacity)
-                Grow();
-
             return this;
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        template<class ClassName>
-        ClassName *TList<ClassName>::Extract(PClassName Item) {
-            int Index;
-            PClassName Result = nullptr;
-
-            Index = IndexOf(Item);
-
-            if (Index >= 0) {
-                Result = m_pList[Index];
-                m_pList[Index] = nullptr;
-
-                m_nCount--;
-                if (Index < m_nCount)
-                    MoveMemory(&m_pList[Index], &m_pList[Index + 1], (m_nCount - Index) * sizeof(PClassName));
-
-                if (Result != nullptr)
-                    Notify(Result, lnExtracted);
-            }
-
-            return Result;
-        }
-        //--------------------------------------------------------------------------------------------------------------
-
         template<class ClassName>
         int TList<ClassName>::IndexOf(PClassName Item) const {
-            int Result = 0;
-
-            while ((Result < m_nCount) && (m_pList[Result] != Item))
-                Result++;
+            if (Item == nullptr || !Contains(*Item))
+                return -1;
 
-            if (Result == m_nCount)
-                Result = -1;
-
-            return Result;
+            return (int) (Item - m_pList);
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -451,7 +470,7 @@ namespace Delphi {
         int TList<ClassName>::IndexOf(const ClassName &Item) const {
             int Result = 0;
 
-            while ((Result < m_nCount) && (*m_pList[Result] != Item))
+            while ((Result < m_nCount) && (m_pList[Result] != Item))
                 Result++;
 
             if (Result == m_nCount)
@@ -488,34 +507,63 @@ namespace Delphi {
         template<class ClassName>
         int TList<ClassName>::Add(const ClassName &Item) {
             int Result = m_nCount;
-
-            if (Result == m_nCapacity)
-                Grow();
-
             Insert(Result, Item);
-
             return Result;
         }
         //--------------------------------------------------------------------------------------------------------------
 
         template<class ClassName>
-        void TList<ClassName>::Insert(int Index, const ClassName &Item) {
-            if ((Index < 0) || (Index > m_nCount))
-                throw Delphi::Exception::ExceptionFrm(SListIndexError, Index);
+        int TList<ClassName>::Add(ClassName &&Item) {
+            int Result = m_nCount;
+            Insert(Result, std::move(Item));
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
+        template<class ClassName>
+        template<class... Args>
+        ClassName &TList<ClassName>::Emplace(Args&&... AArgs) {
             if (m_nCount == m_nCapacity)
                 Grow();
 
-            if (Index < m_nCount)
-                ::MoveMemory(&m_pList[Index + 1], &m_pList[Index], (m_nCount - Index) * sizeof(PClassName));
+            auto Item = ::new (&m_pList[m_nCount]) ClassName(std::forward<Args>(AArgs)...);
+            m_nCount++;
 
-            m_pList[Index] = new ClassName();
+            Notify(Item, lnAdded);
 
-            *m_pList[Index] = Item;
+            return *Item;
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
-            m_nCount++;
+        template<class ClassName>
+        void TList<ClassName>::Insert(int Index, const ClassName &Item) {
+            if (Contains(Item)) {
+                ClassName Temp;
+                Temp = Item;
+                Insert(Index, std::move(Temp));
+                return;
+            }
+
+            auto Slot = InsertSlot(Index);
+            *Slot = Item;
 
-            Notify(m_pList[Index], lnAdded);
+            Notify(Slot, lnAdded);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassName>
+        void TList<ClassName>::Insert(int Index, ClassName &&Item) {
+            if (Contains(Item)) {
+                ClassName Temp;
+                Temp = std::move(Item);
+                Insert(Index, std::move(Temp));
+                return;
+            }
+
+            auto Slot = InsertSlot(Index);
+            *Slot = std::move(Item);
+
+            Notify(Slot, lnAdded);
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -524,32 +572,36 @@ namespace Delphi {
             if ((Index < 0) || (Index >= m_nCount))
                 throw Delphi::Exception::ExceptionFrm(SListIndexError, Index);
 
-            auto Temp = m_pList[Index];
-            m_nCount--;
-
-            if (Index < m_nCount)
-                MoveMemory(&m_pList[Index], &m_pList[Index + 1], (m_nCount - Index) * sizeof(PClassName));
+            Notify(&m_pList[Index], lnDeleted);
 
-            if (Temp != nullptr)
-                Notify(Temp, lnDeleted);
+            for (int i = Index; i < m_nCount - 1; i++)
+                m_pList[i] = std::move(m_pList[i + 1]);
 
-            delete Temp;
+            m_nCount--;
+            m_pList[m_nCount].~ClassName();
         }
         //--------------------------------------------------------------------------------------------------------------
 
         template<class ClassName>
         void TList<ClassName>::Move(int CurIndex, int NewIndex) {
-            PClassName Item;
-
             if (CurIndex != NewIndex) {
+                if ((CurIndex < 0) || (CurIndex >= m_nCount))
+                    throw Delphi::Exception::ExceptionFrm(SListIndexError, CurIndex);
                 if ((NewIndex < 0) || (NewIndex >= m_nCount))
                     throw Delphi::Exception::ExceptionFrm(SListIndexError, NewIndex);
 
-                Item = m_pList[CurIndex];
-                m_pList[CurIndex] = nullptr;
-                Delete(CurIndex);
-                m_pList[NewIndex] = nullptr;
-                m_pList[NewIndex] = Item;
+                ClassName Item;
+                Item = std::move(m_pList[CurIndex]);
+
+                if (CurIndex < NewIndex) {
+                    for (int i = CurIndex; i < NewIndex; i++)
+                        m_pList[i] = std::move(m_pList[i + 1]);
+                } else {
+                    for (int i = CurIndex; i > NewIndex; i--)
+                        m_pList[i] = std::move(m_pList[i - 1]);
+                }
+
+                m_pList[NewIndex] = std::move(Item);
             }
         }
         //--------------------------------------------------------------------------------------------------------------
@@ -563,18 +615,10 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        template<class ClassName>
-        void TList<ClassName>::Pack() {
-            for (int i = m_nCount - 1; i >= 0; i--)
-                if (m_pList[i] == nullptr)
-                    Delete(i);
-        }
-        //--------------------------------------------------------------------------------------------------------------
-
         template<class ClassName>
         void TList<ClassName>::Sort(ListSortCompare Compare) {
             if ((m_pList != nullptr) && (m_nCount > 0))
-                QuickSort(m_pList, 0, GetCount() - 1, Compare);
+                QuickSort(0, GetCount() - 1, Compare);
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -659,36 +703,366 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         template<class ClassName>
-        void TList<ClassName>::QuickSort(PClassNameList SortList, int L, int R, ListSortCompare SCompare) {
-            int I, J;
-            PClassName P, T;
+        void TList<ClassName>::QuickSort(int L, int R, ListSortCompare SCompare) {
+            int I, J, P;
 
             do {
                 I = L;
                 J = R;
-                P = SortList[(L + R) >> 1];
+                P = (L + R) >> 1;
 
                 do {
-                    while (SCompare(SortList[I], P) < 0)
+                    while (SCompare(&m_pList[I], &m_pList[P]) < 0)
                         I++;
-                    while (SCompare(SortList[J], P) > 0)
+                    while (SCompare(&m_pList[J], &m_pList[P]) > 0)
                         J--;
                     if (I <= J) {
-                        T = SortList[I];
-                        SortList[I] = SortList[J];
-                        SortList[J] = T;
+                        if (I != J) {
+                            Swap(m_pList[I], m_pList[J]);
+                            // the pivot travels with the swapped item
+                            if (P == I)
+                                P = J;
+                            else if (P == J)
+                                P = I;
+                        }
                         I++;
                         J--;
                     }
                 } while (I <= J);
 
                 if (L < J)
-                    QuickSort(SortList, L, J, SCompare);
+                    QuickSort(L, J, SCompare);
 
                 L = I;
             } while (I < R);
         }
         //--------------------------------------------------------------------------------------------------------------
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- THashMap --------------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        #define HashMapMinCapacity 8
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Open-addressing map from strings to ClassValue: Robin Hood probing over a power-of-two table,
+         * backward-shift removal and doubling at 7/8 load. Equal keys may be added more than once; they keep
+         * their insertion order, so Find() returns the first one and Remove() drops it.
+         * When not case-sensitive keys match like strcasecmp() (ASCII letters only).
+         */
+        template<class ClassValue>
+        class THashMap : public CObject, public CHeapComponent {
+            typedef ClassValue *PClassValue;
+
+            struct CHashSlot {
+                uint32_t Hash;
+                uint32_t Distance; // 0 - empty, 1 - in its home slot
+            };
+
+            struct CHashEntry {
+                CString Key;
+                ClassValue Value;
+            };
+
+        private:
+
+            CHashSlot *m_pSlots;
+            CHashEntry *m_pEntries;
+
+            int m_nCount;
+            int m_nCapacity;
+
+            bool m_CaseSensitive;
+
+            static void Swap(CHashEntry &Entry1, CHashEntry &Entry2);
+
+            uint32_t HashOf(LPCTSTR Key, size_t Length) const;
+
+            bool SameKey(const CString &Key1, LPCTSTR Key2, size_t Length) const;
+
+            int IndexOf(LPCTSTR Key, size_t Length) const;
+
+            void Place(uint32_t Hash, CHashEntry &&Entry);
+
+            void DeleteSlot(int Index);
+
+        public:
+
+            explicit THashMap(int ACapacity = 0, bool ACaseSensitive = true);
+
+            THashMap(const THashMap<ClassValue> &) = delete;
+
+            ~THashMap() override;
+
+            THashMap<ClassValue> &operator=(const THashMap<ClassValue> &) = delete;
+
+            void Clear();
+
+            void Add(const CString &Key, const ClassValue &Value);
+            void Add(LPCTSTR Key, size_t Length, const ClassValue &Value);
+
+            bool Remove(const CString &Key) { return Remove(Key.c_str(), Key.Length()); }
+            bool Remove(LPCTSTR Key) { return Remove(Key, Key == nullptr ? 0 : strlen(Key)); }
+            bool Remove(LPCTSTR Key, size_t Length);
+
+            PClassValue Find(const CString &Key) const { return Find(Key.c_str(), Key.Length()); }
+            PClassValue Find(LPCTSTR Key) const { return Find(Key, Key == nullptr ? 0 : strlen(Key)); }
+            PClassValue Find(LPCTSTR Key, size_t Length) const;
+
+            bool Contains(const CString &Key) const { return Find(Key) != nullptr; }
+            bool Contains(LPCTSTR Key) const { return Find(Key) != nullptr; }
+
+            int GetCapacity() const noexcept { return m_nCapacity; }
+
+            /// Rehashes into a table that fits NewCapacity keys; never shrinks below the current count
+            void SetCapacity(int NewCapacity);
+
+            int GetCount() const noexcept { return m_nCount; }
+
+            int Capacity() const noexcept { return GetCapacity(); }
+
+            int Count() const noexcept { return GetCount(); }
+
+            bool CaseSensitive() const noexcept { return m_CaseSensitive; }
+
+        }; // THashMap<ClassValue>
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- THashMap --------------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        THashMap<ClassValue>::THashMap(int ACapacity, bool ACaseSensitive) {
+            m_pSlots = nullptr;
+            m_pEntries = nullptr;
+            m_nCount = 0;
+            m_nCapacity = 0;
+            m_CaseSensitive = ACaseSensitive;
+
+            if (ACapacity > 0)
+                SetCapacity(ACapacity);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        THashMap<ClassValue>::~THashMap() {
+            Clear();
+            if (m_pSlots != nullptr) {
+                GHeap->Free(0, m_pSlots, m_nCapacity * sizeof(CHashSlot));
+                GHeap->Free(0, m_pEntries, m_nCapacity * sizeof(CHashEntry));
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        void THashMap<ClassValue>::Swap(CHashEntry &Entry1, CHashEntry &Entry2) {
+            CHashEntry Temp;
+            Temp = std::move(Entry1);
+            Entry1 = std::move(Entry2);
+            Entry2 = std::move(Temp);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        uint32_t THashMap<ClassValue>::HashOf(LPCTSTR Key, size_t Length) const {
+            return (uint32_t) HashBuffer(Key, Length * sizeof(TCHAR), m_CaseSensitive);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        bool THashMap<ClassValue>::SameKey(const CString &Key1, LPCTSTR Key2, size_t Length) const {
+            if (Key1.Length() != Length)
+                return false;
+            if (Length == 0)
+                return true;
+            if (m_CaseSensitive)
+                return ::memcmp(Key1.Data(), Key2, Length * sizeof(TCHAR)) == 0;
+            return ::strncasecmp(Key1.Data(), Key2, Length) == 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        int THashMap<ClassValue>::IndexOf(LPCTSTR Key, size_t Length) const {
+            if (m_nCount == 0)
+                return -1;
+
+            const uint32_t Hash = HashOf(Key, Length);
+            const int Mask = m_nCapacity - 1;
+
+            int Index = (int) (Hash & Mask);
+            uint32_t Distance = 1;
+
+            // Robin Hood order: once the resident is closer to its home than we would be, the key is absent
+            while (m_pSlots[Index].Distance >= Distance) {
+                if (m_pSlots[Index].Hash == Hash && SameKey(m_pEntries[Index].Key, Key, Length))
+                    return Index;
+                Index = (Index + 1) & Mask;
+                Distance++;
+            }
+
+            return -1;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        void THashMap<ClassValue>::Place(uint32_t Hash, CHashEntry &&Entry) {
+            const int Mask = m_nCapacity - 1;
+
+            int Index = (int) (Hash & Mask);
+            uint32_t Distance = 1;
+            bool Carried = false;
+
+            while (m_pSlots[Index].Distance != 0) {
+                auto &Slot = m_pSlots[Index];
+                // A new entry passes residents as far from home as itself, so equal keys stay in insertion
+                // order; a displaced one takes their place for the same reason.
+                if (Slot.Distance < Distance || (Carried && Slot.Distance == Distance)) {
+                    std::swap(Slot.Hash, Hash);
+                    std::swap(Slot.Distance, Distance);
+                    Swap(m_pEntries[Index], Entry);
+                    Carried = true;
+                }
+                Index = (Index + 1) & Mask;
+                Distance++;
+            }
+
+            m_pSlots[Index].Hash = Hash;
+            m_pSlots[Index].Distance = Distance;
+            ::new (&m_pEntries[Index]) CHashEntry(std::move(Entry));
+
+            m_nCount++;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        void THashMap<ClassValue>::DeleteSlot(int Index) {
+            const int Mask = m_nCapacity - 1;
+
+            int Next = (Index + 1) & Mask;
+
+            // Backward shift: pull the following displaced entries one step closer to home
+            while (m_pSlots[Next].Distance > 1) {
+                m_pSlots[Index].Hash = m_pSlots[Next].Hash;
+                m_pSlots[Index].Distance = m_pSlots[Next].Distance - 1;
+                m_pEntries[Index] = std::move(m_pEntries[Next]);
+                Index = Next;
+                Next = (Next + 1) & Mask;
+            }
+
+            m_pEntries[Index].~CHashEntry();
+            m_pSlots[Index].Distance = 0;
+
+            m_nCount--;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        void THashMap<ClassValue>::SetCapacity(int NewCapacity) {
+            if (NewCapacity < m_nCount)
+                NewCapacity = m_nCount;
+
+            int Capacity = HashMapMinCapacity;
+            while (Capacity - Capacity / 8 < NewCapacity) {
+                if (Capacity > MaxListSize / 2)
+                    throw Delphi::Exception::ExceptionFrm(SListCapacityError, NewCapacity);
+                Capacity <<= 1;
+            }
+
+            if (Capacity == m_nCapacity)
+                return;
+
+            auto OldSlots = m_pSlots;
+            auto OldEntries = m_pEntries;
+            const int OldCapacity = m_nCapacity;
+
+            m_pSlots = (CHashSlot *) GHeap->Alloc(HEAP_ZERO_MEMORY, Capacity * sizeof(CHashSlot));
+            m_pEntries = (CHashEntry *) GHeap->Alloc(0, Capacity * sizeof(CHashEntry));
+            m_nCapacity = Capacity;
+            m_nCount = 0;
+
+            // Walk the old table from an empty slot so that runs wrapping past the end keep their order
+            int Start = 0;
+            while (Start < OldCapacity && OldSlots[Start].Distance != 0)
+                Start++;
+
+            for (int n = 0; n < OldCapacity; n++) {
+                const int i = (Start + n) & (OldCapacity - 1);
+                if (OldSlots[i].Distance != 0) {
+                    Place(OldSlots[i].Hash, std::move(OldEntries[i]));
+                    OldEntries[i].~CHashEntry();
+                }
+            }
+
+            if (OldSlots != nullptr) {
+                GHeap->Free(0, OldSlots, OldCapacity * sizeof(CHashSlot));
+                GHeap->Free(0, OldEntries, OldCapacity * sizeof(CHashEntry));
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        void THashMap<ClassValue>::Clear() {
+            if (m_nCount == 0)
+                return;
+
+            for (int i = 0; i < m_nCapacity; i++) {
+                if (m_pSlots[i].Distance != 0) {
+                    m_pEntries[i].~CHashEntry();
+                    m_pSlots[i].Distance = 0;
+                }
+            }
+
+            m_nCount = 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        void THashMap<ClassValue>::Add(const CString &Key, const ClassValue &Value) {
+            if (m_nCount + 1 > m_nCapacity - m_nCapacity / 8)
+                SetCapacity(m_nCount + 1);
+
+            CHashEntry Entry;
+            Entry.Key = Key;
+            Entry.Value = Value;
+
+            Place(HashOf(Key.c_str(), Key.Length()), std::move(Entry));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        void THashMap<ClassValue>::Add(LPCTSTR Key, size_t Length, const ClassValue &Value) {
+            if (m_nCount + 1 > m_nCapacity - m_nCapacity / 8)
+                SetCapacity(m_nCount + 1);
+
+            CHashEntry Entry;
+            if (Length > 0)
+                Entry.Key.Append(Key, Length);
+            Entry.Value = Value;
+
+            Place(HashOf(Key, Length), std::move(Entry));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        bool THashMap<ClassValue>::Remove(LPCTSTR Key, size_t Length) {
+            const int Index = IndexOf(Key, Length);
+            if (Index == -1)
+                return false;
+            DeleteSlot(Index);
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        template<class ClassValue>
+        ClassValue *THashMap<ClassValue>::Find(LPCTSTR Key, size_t Length) const {
+            const int Index = IndexOf(Key, Length);
+            return Index == -1 ? nullptr : &m_pEntries[Index].Value;
+        }
+        //--------------------------------------------------------------------------------------------------------------
     }
 }
 }
@@ -73,6 +73,8 @@ Author:
 #define vasStr                   varStr
 #define vasCString               varCString
 
+#define VARIANT_INLINE_TEXT      (sizeof(Pointer) / sizeof(TCHAR) - 1)
+
 extern "C++" {
 
 namespace Delphi {
@@ -98,13 +100,21 @@ namespace Delphi {
             vtUInt64        = 14,
             vtWideString    = 15,
             vtInt64         = 16,
-            vtUnicodeString = 17
+            vtUnicodeString = 17,
+            vtText          = 18
         } CVarType;
 
+        /**
+         * A 16-byte tagged value. Scalars are stored inline; vtText owns a copy of its string, kept inline up to
+         * VARIANT_INLINE_TEXT characters and on the heap above that. The other string types only point to
+         * storage the caller keeps alive.
+         */
         typedef struct VarData {
 
             CVarType VType;
 
+            uint32_t VLength; // vtText length
+
             union VarRec {
 
                 int VInteger;
@@ -125,36 +135,29 @@ namespace Delphi {
                 const wchar_t *VWideString;
                 int64_t VInt64;
                 CString *VUnicodeString;
+                TCHAR VInline[VARIANT_INLINE_TEXT + 1];
+                TCHAR *VText;
 
             } VarRec;
 
-            VarData(): VarRec({0}) {
-
-                VType = vtEmpty;
-
-                varInteger = 0;
-                varBoolean = false;
-                varChar = '\0';
-                varDouble = 0.0;
-                varString = nullptr;
-                varPointer = nullptr;
-                varPChar = nullptr;
-                varObject = nullptr;
-                varUnsigned = 0;
-                varWideChar = L'\0';
-                varPWideChar = nullptr;
-                varAnsiString = nullptr;
-                varFloat = 0;
-                varVariant = nullptr;
-                varUInt64 = 0;
-                varWideString = nullptr;
-                varInt64 = 0;
-                varUnicodeString = nullptr;
+            VarData(): VType(vtEmpty), VLength(0) {
+                VarRec.VUInt64 = 0;
             }
 
             VarData(const VarData& Value): VarData() {
-                VType = Value.VType;
-                VarRec = Value.VarRec;
+                Assign(Value);
+            }
+
+            VarData(VarData&& Value) noexcept: VarData() {
+                MoveFrom(Value);
+            }
+
+            explicit VarData(const CString &Value): VarData() {
+                SetText(Value.c_str(), Value.Length());
+            }
+
+            ~VarData() {
+                Clear();
             }
 
             explicit VarData(nullptr_t Value): VarData() {
@@ -248,36 +251,42 @@ namespace Delphi {
             }
 
             VarData& operator= (nullptr_t Value) {
+                Clear();
                 VType = vtPointer;
                 varPointer = Value;
                 return *this;
             }
 
             VarData& operator= (int Value) {
+                Clear();
                 VType = vtInteger;
                 varInteger = Value;
                 return *this;
             }
 
             VarData& operator= (bool Value) {
+                Clear();
                 VType = vtBoolean;
                 varBoolean = Value;
                 return *this;
             }
 
             VarData& operator= (char Value) {
+                Clear();
                 VType = vtChar;
                 varChar = Value;
                 return *this;
             }
 
             VarData& operator= (double Value) {
+                Clear();
                 VType = vtDouble;
                 varDouble = Value;
                 return *this;
             }
 
             VarData& operator= (CString *Value) {
+                Clear();
 #ifdef UNICODE
                 VType = vtUnicodeString;
 #else
@@ -288,86 +297,145 @@ namespace Delphi {
             }
 
             VarData& operator= (Pointer Value) {
+                Clear();
                 VType = vtPointer;
                 varPointer = Value;
                 return *this;
             }
 
             VarData& operator= (char *Value) {
+                Clear();
                 VType = vtPChar;
                 varPChar = Value;
                 return *this;
             }
 
             VarData& operator= (CObject *Value) {
+                Clear();
                 VType = vtObject;
                 varObject = Value;
                 return *this;
             }
 
             VarData& operator= (uint32_t Value) {
+                Clear();
                 VType = vtUnsigned;
                 varUnsigned = Value;
                 return *this;
             }
 
             VarData& operator= (wchar_t Value) {
+                Clear();
                 VType = vtWideChar;
                 varWideChar = Value;
                 return *this;
             }
 
             VarData& operator= (wchar_t *Value) {
+                Clear();
                 VType = vtPWideChar;
                 varPWideChar = Value;
                 return *this;
             }
 
             VarData& operator= (LPCSTR Value) {
+                Clear();
                 VType = vtAnsiString;
                 varAnsiString = Value;
                 return *this;
             }
 
             VarData& operator= (float Value) {
+                Clear();
                 VType = vtFloat;
                 varFloat = Value;
                 return *this;
             }
 
             VarData& operator= (VarData *Value) {
+                Clear();
                 VType = vtVariant;
                 varVariant = Value;
                 return *this;
             }
 
             VarData& operator= (uint64_t Value) {
+                Clear();
                 VType = vtUInt64;
                 varUInt64 = Value;
                 return *this;
             }
 
             VarData& operator= (const wchar_t *Value) {
+                Clear();
                 VType = vtWideString;
                 varWideString = Value;
                 return *this;
             }
 
             VarData& operator= (int64_t Value) {
+                Clear();
                 VType = vtInt64;
                 varInt64 = Value;
                 return *this;
             }
 
+            VarData& operator= (const CString &Value) {
+                SetText(Value.c_str(), Value.Length());
+                return *this;
+            }
+
             VarData& operator= (const VarData& Value) {
+                if (this != &Value)
+                    Assign(Value);
+                return *this;
+            };
+
+            VarData& operator= (VarData&& Value) noexcept {
                 if (this != &Value) {
-                    VType = Value.VType;
-                    VarRec = Value.VarRec;
+                    Clear();
+                    MoveFrom(Value);
                 }
                 return *this;
             };
 
+            void Assign(const VarData &Value);
+
+            /// Releases owned text and makes the value vtEmpty
+            void Clear();
+
+            /// Makes the value vtText holding a copy of Length characters of Value
+            void SetText(LPCTSTR Value, size_t Length);
+
+            bool IsEmpty() const { return VType == vtEmpty; }
+
+            bool IsText() const;
+
+            /// Characters of a string value without copying them (vtChar is not null-terminated), or nullptr
+            LPCTSTR Text() const;
+            size_t TextLength() const;
+
+            int64_t AsInt64() const;
+            double AsDouble() const;
+            bool AsBoolean() const;
+
+            CString AsString() const;
+
+        private:
+
+            void MoveFrom(VarData &Value) noexcept {
+                VType = Value.VType;
+                VLength = Value.VLength;
+                VarRec = Value.VarRec;
+
+                Value.VType = vtEmpty;
+                Value.VLength = 0;
+                Value.VarRec.VUInt64 = 0;
+            }
+
         } CVariant, *PVariant;
+
+        static_assert(sizeof(CVariant) == 16, "CVariant must stay a 16-byte tagged value");
     }
 }
 
@@ -488,6 +488,25 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        struct CCURLMetrics {
+            CMetricCounter *Requests;
+            CMetricCounter *Failures;
+            CMetricGauge *InFlight;
+            CMetricHistogram *Duration;
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        static const CCURLMetrics &CURLMetrics() {
+            static const CCURLMetrics Metrics = {
+                CMetricsRegistry::Default().Counter("delphi_curl_requests_total", "Transfers completed by the CURL client."),
+                CMetricsRegistry::Default().Counter("delphi_curl_failures_total", "Transfers finished with a CURL error."),
+                CMetricsRegistry::Default().Gauge("delphi_curl_in_flight", "Transfers currently running."),
+                CMetricsRegistry::Default().Histogram("delphi_curl_request_duration_seconds", "Total transfer time reported by CURL.")
+            };
+            return Metrics;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         void CCURLClient::MultiInfo() const {
             CCurlAsyncFetch *pFetch;
             CURLMsg *msg;
@@ -504,6 +523,18 @@ namespace Delphi {
 
                     curl_multi_remove_handle(m_Handle, easy);
 
+                    const auto &Metrics = CURLMetrics();
+                    curl_off_t total = 0;
+
+                    Metrics.InFlight->Dec();
+                    Metrics.Requests->Inc();
+
+                    if (code != CURLE_OK)
+                        Metrics.Failures->Inc();
+
+                    if (curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &total) == CURLE_OK)
+                        Metrics.Duration->Observe((uint64_t) total);
+
                     pFetch->CurlInfo();
 
                     if (code == CURLE_OK) {
@@ -575,8 +606,11 @@ namespace Delphi {
             const auto code = curl_multi_add_handle(m_Handle, pFetch->Handle());
             try {
                 ErrorCheck("Perform", code);
+                CURLMetrics().InFlight->Inc();
                 UpdateTimer(0);
             } catch (Delphi::Exception::Exception &E) {
+                if (code == CURLM_OK)
+                    CURLMetrics().InFlight->Dec();
                 DoException(E);
                 delete pFetch;
             }
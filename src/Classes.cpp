@@ -53,6 +53,9 @@ namespace Delphi {
         LIB_DELPHI CDefaultLocale DefaultLocale;
         //--------------------------------------------------------------------------------------------------------------
 
+        static pthread_mutex_t GThreadLock;
+        //--------------------------------------------------------------------------------------------------------------
+
         inline void InitThreadSynchronization() {
 //            pthread_mutexattr_t attr;
 //            pthread_mutexattr_init(&attr);
@@ -1374,16 +1377,30 @@ namespace Delphi {
             Pointer P = m_Data;
 
             if (NewCapacity != m_Capacity) {
+                const bool bInline = m_Data == m_Inline;
+
                 if (NewCapacity == 0) {
-                    P = GHeap->Free(0, m_Data, m_Capacity);
+                    P = bInline ? nullptr : GHeap->Free(0, m_Data, m_Capacity);
+                } else if (NewCapacity <= STRING_INLINE_SIZE) {
+                    if (!bInline) {
+                        ::ZeroMemory(m_Inline, sizeof(m_Inline));
+                        if (m_Capacity != 0) {
+                            ::CopyMemory(m_Inline, m_Data, m_Size < NewCapacity ? m_Size : NewCapacity);
+                            GHeap->Free(0, m_Data, m_Capacity);
+                        }
+                    }
+                    P = m_Inline;
                 } else {
-                    if (m_Capacity == 0)
+                    if (m_Capacity == 0 || bInline)
                         P = GHeap->Alloc(HEAP_ZERO_MEMORY, NewCapacity);
                     else
                         P = GHeap->ReAlloc(0, m_Data, NewCapacity, m_Capacity);
 
                     if (P == nullptr)
                         throw EStreamError(_T("Out of memory while expanding memory stream"));
+
+                    if (bInline)
+                        ::CopyMemory(P, m_Inline, m_Capacity);
                 }
             }
 
@@ -1391,6 +1408,27 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CStringStream::MoveFrom(CStringStream &Source) noexcept {
+            CStringStream::Clear();
+
+            if (Source.m_Data == Source.m_Inline) {
+                ::CopyMemory(m_Inline, Source.m_Inline, sizeof(m_Inline));
+                m_Data = m_Inline;
+            } else {
+                m_Data = Source.m_Data;
+            }
+
+            m_Size = Source.m_Size;
+            m_Position = Source.m_Position;
+            m_Capacity = Source.m_Capacity;
+
+            Source.m_Data = nullptr;
+            Source.m_Size = 0;
+            Source.m_Position = 0;
+            Source.m_Capacity = 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         size_t CStringStream::Write(const void *Buffer, size_t Count) {
             size_t Pos;
             if ((m_Position >= 0) && (Count >= 0)) {
@@ -1426,6 +1464,14 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CCustomString::MoveFrom(CCustomString &Source) noexcept {
+            inherited::MoveFrom(Source);
+
+            m_Length = Source.m_Length;
+            Source.m_Length = 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         void CCustomString::SetLength(size_t NewLength) {
             if ((NewLength > 0) && (NewLength != m_Length)) {
                 if (NewLength > 0)
@@ -1521,6 +1567,12 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        CString::CString(CString &&S) noexcept: CString() {
+            m_MaxFormatSize = S.MaxFormatSize();
+            MoveFrom(S);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         CString::CString(const std::string &str): CString() {
             Create(str.data(), str.size());
         }
@@ -2491,7 +2543,7 @@ namespace Delphi {
         CStringList::~CStringList() {
             CStringList::Clear();
             if (m_pList != nullptr)
-                GHeap->Free(0, m_pList, m_nCapacity * sizeof(PStringItem));
+                GHeap->Free(0, m_pList, m_nCapacity * sizeof(CStringItem));
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -2513,7 +2565,7 @@ namespace Delphi {
             if ((Index < 0) || (Index >= m_nCount))
                 throw ExceptionFrm(SListIndexError, Index);
 
-            return m_pList[Index]->String;
+            return m_pList[Index].String;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -2521,7 +2573,7 @@ namespace Delphi {
             if ((Index < 0) || (Index >= m_nCount))
                 throw ExceptionFrm(SListIndexError, Index);
 
-            return m_pList[Index]->String;
+            return m_pList[Index].String;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -2529,7 +2581,7 @@ namespace Delphi {
             if ((Index < 0) || (Index >= m_nCount))
                 throw ExceptionFrm(SListIndexError, Index);
 
-            m_pList[Index]->String = S;
+            m_pList[Index].String = S;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -2537,7 +2589,7 @@ namespace Delphi {
             if ((Index < 0) || (Index >= m_nCount))
                 throw ExceptionFrm(SListIndexError, Index);
 
-            m_pList[Index]->String = Str;
+            m_pList[Index].String = Str;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -2545,7 +2597,7 @@ namespace Delphi {
             if ((Index < 0) || (Index >= m_nCount))
                 throw ExceptionFrm(SListIndexError, Index);
 
-            m_pList[Index]->Object = AObject;
+            m_pList[Index].Object = AObject;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -2553,7 +2605,7 @@ namespace Delphi {
             if ((Index < 0) || (Index >= m_nCount))
                 throw ExceptionFrm(SListIndexError, Index);
 
-            return m_pList[Index]->Object;
+            return m_pList[Index].Object;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -2562,7 +2614,7 @@ namespace Delphi {
                 throw ExceptionFrm(SListIndexError, Index);
 
             size_t L = CString::npos;
-            CStringItem *R = m_pList[Index];
+            const CStringItem *R = &m_pList[Index];
 
             CString Name;
             if (!R->String.IsEmpty())
@@ -2580,13 +2632,13 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         CString CStringList::GetValue(const CString &Name) const {
-            CStringItem *P;
+            const CStringItem *P;
             size_t Length, SepLen;
             CString Value;
 
             int Index = IndexOfName(Name);
             if (Index != -1) {
-                P = m_pList[Index];
+                P = &m_pList[Index];
                 SepLen = strlen(NameValueSeparator());
                 Length = P->String.Length() - Name.Length();
                 if (Length > 0) {
@@ -2603,7 +2655,7 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         CString CStringList::GetValue(reference Name) const {
-            CStringItem *P;
+            const CStringItem *P;
             size_t NameLength, Length;
             CString Value;
 
@@ -2611,7 +2663,7 @@ namespace Delphi {
 
             int Index = IndexOfName(Name);
             if (Index != -1) {
-                P = m_pList[Index];
+                P = &m_pList[Index];
                 Length = P->String.Length() - NameLength;
                 if (Length > 0) {
                     if (P->String.at(NameLength + 1) == QuoteChar() && P->String.back() == QuoteChar())
@@ -2643,13 +2695,13 @@ namespace Delphi {
                 if (OwnsObjects()) {
                     Temp = new CObject* [m_nCount];
                     for (i = 0; i < m_nCount; ++i) {
-                        Temp[i] = m_pList[i]->Object;
+                        Temp[i] = m_pList[i].Object;
                         TempCount++;
                     }
                 }
 
                 for (i = 0; i < m_nCount; ++i)
-                    delete m_pList[i];
+                    m_pList[i].~CStringItem();
 
                 m_nCount = 0;
                 SetCapacity(0);
@@ -2669,21 +2721,20 @@ namespace Delphi {
                 throw ExceptionFrm(SListCapacityError, NewCapacity);
 
             if (NewCapacity != m_nCapacity) {
-                if (NewCapacity == 0) {
-                    m_pList = (PStringItemList) GHeap->Free(0, (PStringItemList) m_pList,
-                            m_nCapacity * sizeof(PStringItem));
-                } else {
-                    if (m_nCapacity == 0) {
-                        m_pList = (PStringItemList) GHeap->Alloc(0, NewCapacity * sizeof(PStringItem));
-                    } else {
-                        m_pList = (PStringItemList) GHeap->ReAlloc(0, (PStringItemList) m_pList,
-                                NewCapacity * sizeof(PStringItem), m_nCapacity * sizeof(PStringItem));
-                    }
+                PStringItem List = nullptr;
 
-                    if (m_pList == nullptr)
-                        throw Delphi::Exception::Exception(_T("Out of memory while expanding memory heap"));
+                if (NewCapacity > 0) {
+                    List = (PStringItem) GHeap->Alloc(0, NewCapacity * sizeof(CStringItem));
+                    for (int i = 0; i < m_nCount; ++i) {
+                        ::new (&List[i]) CStringItem(std::move(m_pList[i]));
+                        m_pList[i].~CStringItem();
+                    }
                 }
 
+                if (m_pList != nullptr)
+                    GHeap->Free(0, m_pList, m_nCapacity * sizeof(CStringItem));
+
+                m_pList = List;
                 m_nCapacity = NewCapacity;
             }
         }
@@ -2704,15 +2755,15 @@ namespace Delphi {
 
             // If this list owns its objects then free the associated TObject with this index
             if (OwnsObjects())
-                Obj = m_pList[Index]->Object;
+                Obj = m_pList[Index].Object;
             else
                 Obj = nullptr;
 
-            delete m_pList[Index];
-            m_nCount--;
+            for (int i = Index; i < m_nCount - 1; ++i)
+                m_pList[i] = std::move(m_pList[i + 1]);
 
-            if (Index < m_nCount)
-                MoveMemory(&m_pList[Index], &m_pList[Index + 1], (m_nCount - Index) * sizeof(PStringItem));
+            m_nCount--;
+            m_pList[m_nCount].~CStringItem();
 
             if (Obj != nullptr)
                 FreeAndNil(Obj);
@@ -2734,6 +2785,13 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        int CStringList::Add(CString &&S) {
+            int Index = GetCount();
+            Insert(Index, std::move(S));
+            return Index;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         int CStringList::AddObject(const CString &S, CObject *AObject) {
             int Index = GetCount();
             InsertItem(Index, S, AObject);
@@ -2770,6 +2828,17 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CStringList::Insert(int Index, CString &&S) {
+            if ((Index < 0) || (Index > m_nCount))
+                throw ExceptionFrm(SListIndexError, Index);
+
+            CStringItem Item;
+            Item.String = std::move(S);
+
+            InsertItem(Index, std::move(Item));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         void CStringList::InsertObject(int Index, const CString &S, CObject *AObject) {
             if ((Index < 0) || (Index > m_nCount))
                 throw ExceptionFrm(SListIndexError, Index);
@@ -2791,51 +2860,53 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        void CStringList::InsertItem(int Index, const CString &S, CObject *AObject) {
+        void CStringList::InsertItem(int Index, CStringItem &&Item) {
             if (m_nCount == m_nCapacity)
                 Grow();
 
-            if (Index < m_nCount)
-                MoveMemory(&m_pList[Index], &m_pList[Index + 1], (m_nCount - Index) * sizeof(PStringItem));
+            if (Index < m_nCount) {
+                ::new (&m_pList[m_nCount]) CStringItem(std::move(m_pList[m_nCount - 1]));
 
-            m_pList[Index] = new CStringItem;
+                for (int i = m_nCount - 1; i > Index; --i)
+                    m_pList[i] = std::move(m_pList[i - 1]);
 
-            m_pList[Index]->String = S;
-            m_pList[Index]->Object = AObject;
+                m_pList[Index] = std::move(Item);
+            } else {
+                ::new (&m_pList[Index]) CStringItem(std::move(Item));
+            }
 
             m_nCount++;
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        void CStringList::InsertItem(int Index, reference Str, CObject *AObject) {
-            if (m_nCount == m_nCapacity)
-                Grow();
+        void CStringList::InsertItem(int Index, const CString &S, CObject *AObject) {
+            // Built aside first: S may be an item of this list, and growing the list moves the items
+            CStringItem Item;
 
-            if (Index < m_nCount)
-                MoveMemory(&m_pList[Index], &m_pList[Index + 1], (m_nCount - Index) * sizeof(PStringItem));
+            Item.String = S;
+            Item.Object = AObject;
 
-            m_pList[Index] = new CStringItem;
+            InsertItem(Index, std::move(Item));
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
-            m_pList[Index]->String = Str;
-            m_pList[Index]->Object = AObject;
+        void CStringList::InsertItem(int Index, reference Str, CObject *AObject) {
+            CStringItem Item;
 
-            m_nCount++;
+            Item.String = Str;
+            Item.Object = AObject;
+
+            InsertItem(Index, std::move(Item));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CStringList::InsertItem(int Index, TCHAR C, CObject *AObject) {
-            if (m_nCount == m_nCapacity)
-                Grow();
+            CStringItem Item;
 
-            if (Index < m_nCount)
-                MoveMemory(&m_pList[Index], &m_pList[Index + 1], (m_nCount - Index) * sizeof(PStringItem));
-
-            m_pList[Index] = new CStringItem;
+            Item.String = C;
+            Item.Object = AObject;
 
-            m_pList[Index]->String = C;
-            m_pList[Index]->Object = AObject;
-
-            m_nCount++;
+            InsertItem(Index, std::move(Item));
         }
 
         //--------------------------------------------------------------------------------------------------------------
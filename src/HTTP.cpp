@@ -2051,6 +2051,7 @@ namespace Delphi {
             m_TimeOut = 0;
             m_State = Request::method_start;
             m_ContentLength = 0;
+            m_RequestStart = 0;
 
             m_Reply.ServerName = AServer->ServerName();
             m_Reply.AllowedMethods = AServer->AllowedMethods();
@@ -2064,6 +2065,9 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        DEFINE_FREE_LIST_ALLOCATOR(CHTTPServerConnection)
+        //--------------------------------------------------------------------------------------------------------------
+
         void CHTTPServerConnection::Clear() {
             CWebSocketConnection::Clear();
 
@@ -2085,7 +2089,12 @@ namespace Delphi {
                     break;
 
                 case 1:
+                    // A client may send its first tunnel bytes right behind CONNECT: keep them for the tunnel.
+                    if (Context.Begin != Context.End && m_Request.Method == "CONNECT")
+                        InputBuffer().WriteBuffer(Context.Begin, Context.End - Context.Begin);
+
                     m_ConnectionStatus = csRequestOk;
+                    m_RequestStart = MetricsTime();
                     DoRequest();
                     OnExecute(this);
                     break;
@@ -2233,6 +2242,7 @@ namespace Delphi {
 
             m_ContentLength = 0;
             m_ChunkedLength = 0;
+            m_RequestStart = 0;
 
             m_CloseConnection = true;
 
@@ -2336,6 +2346,7 @@ namespace Delphi {
             m_Request.ToBuffers(OutputBuffer());
 
             m_ConnectionStatus = csRequestReady;
+            m_RequestStart = MetricsTime();
 
             DoRequest();
 
@@ -2346,6 +2357,343 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        //-- CHTTPRoute ------------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPRoute::CHTTPRoute(int Methods, const CString &Pattern, COnHTTPRouteEvent && OnRoute): CObject(),
+                m_Methods(Methods), m_Pattern(Pattern), m_Data(nullptr), m_OnRoute(OnRoute) {
+
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CHTTPRouteNode --------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CHTTPRouteNode: public CObject {
+        public:
+
+            CString Param;
+            int ParamChild;
+
+            CString Wildcard;
+            int WildcardChild;
+
+            int Methods;
+
+            CList Routes;
+
+            CHTTPRouteNode(): CObject(), ParamChild(-1), WildcardChild(-1), Methods(hmUnknown) {
+
+            };
+
+            CHTTPRoute *RouteOf(int Method) const {
+                if ((Methods & Method) != 0) {
+                    for (int i = 0; i < Routes.Count(); i++) {
+                        const auto pRoute = static_cast<CHTTPRoute *> (Routes.Items(i));
+                        if ((pRoute->Methods() & Method) != 0)
+                            return pRoute;
+                    }
+                }
+                return nullptr;
+            }
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CHTTPRouter -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        static const struct {
+            LPCTSTR Name;
+            CHTTPMethod Method;
+        } HTTPMethods[] = {
+            { _T("GET"), hmGet },
+            { _T("HEAD"), hmHead },
+            { _T("POST"), hmPost },
+            { _T("PUT"), hmPut },
+            { _T("DELETE"), hmDelete },
+            { _T("PATCH"), hmPatch },
+            { _T("OPTIONS"), hmOptions },
+            { _T("CONNECT"), hmConnect },
+            { _T("TRACE"), hmTrace }
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPRouter::CHTTPRouter(): CObject(), m_Children(1024) {
+            AddNode();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPRouter::~CHTTPRouter() {
+            Clear();
+            delete GetNode(0);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPRouteNode *CHTTPRouter::GetNode(int Index) const {
+            return static_cast<CHTTPRouteNode *> (m_Nodes.Items(Index));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CHTTPRouter::AddNode() {
+            return m_Nodes.Add(new CHTTPRouteNode());
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CHTTPRouter::FindChild(int Index, LPCTSTR Segment, size_t Length) {
+            TCHAR szIndex[_INT_T_LEN + 1] = {0};
+
+            CString Key(IntToStr(Index, szIndex, sizeof(szIndex)));
+            Key.Append('/');
+            if (Length > 0)
+                Key.Append(Segment, Length);
+
+            return m_Children.ValueOf(Key);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPRouter::Clear() {
+            for (int i = 0; i < m_Routes.Count(); i++)
+                delete Routes(i);
+            m_Routes.Clear();
+
+            // The root node stays so that the router is usable right after.
+            for (int i = m_Nodes.Count() - 1; i > 0; i--) {
+                delete GetNode(i);
+                m_Nodes.Delete(i);
+            }
+
+            const auto pRoot = GetNode(0);
+            pRoot->Param.Clear();
+            pRoot->ParamChild = -1;
+            pRoot->Wildcard.Clear();
+            pRoot->WildcardChild = -1;
+            pRoot->Methods = hmUnknown;
+            pRoot->Routes.Clear();
+
+            m_Children.Clear();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPRoute *CHTTPRouter::Add(int Methods, const CString &Pattern, COnHTTPRouteEvent && OnRoute) {
+            if (Pattern.IsEmpty() || Pattern.front() != '/')
+                throw ExceptionFrm(_T("Invalid route pattern: \"%s\"."), Pattern.c_str());
+
+            if ((Methods & hmAny) == 0)
+                throw ExceptionFrm(_T("Route \"%s\" has no methods."), Pattern.c_str());
+
+            int Index = 0;
+
+            LPCTSTR Path = Pattern.c_str() + 1;
+            size_t Length = Pattern.Size() - 1;
+
+            bool bEnd = Length == 0;
+
+            while (!bEnd) {
+                size_t Size = 0;
+                while (Size < Length && Path[Size] != '/')
+                    Size++;
+
+                bEnd = Size == Length;
+
+                const auto pNode = GetNode(Index);
+
+                if (Size > 1 && Path[0] == ':') {
+                    const CString Name(Path + 1, Size - 1);
+                    if (pNode->ParamChild == -1) {
+                        pNode->ParamChild = AddNode();
+                        pNode->Param = Name;
+                    } else if (pNode->Param != Name) {
+                        throw ExceptionFrm(_T("Route \"%s\": capture \":%s\" conflicts with \":%s\"."), Pattern.c_str(),
+                                           Name.c_str(), pNode->Param.c_str());
+                    }
+                    Index = pNode->ParamChild;
+                } else if (Size > 1 && Path[0] == '*') {
+                    if (!bEnd)
+                        throw ExceptionFrm(_T("Route \"%s\": catch-all must be the last segment."), Pattern.c_str());
+
+                    const CString Name(Path + 1, Size - 1);
+                    if (pNode->WildcardChild == -1) {
+                        pNode->WildcardChild = AddNode();
+                        pNode->Wildcard = Name;
+                    } else if (pNode->Wildcard != Name) {
+                        throw ExceptionFrm(_T("Route \"%s\": catch-all \"*%s\" conflicts with \"*%s\"."), Pattern.c_str(),
+                                           Name.c_str(), pNode->Wildcard.c_str());
+                    }
+                    Index = pNode->WildcardChild;
+                } else {
+                    int Child = FindChild(Index, Path, Size);
+                    if (Child == -1) {
+                        Child = AddNode();
+
+                        TCHAR szIndex[_INT_T_LEN + 1] = {0};
+                        CString Key(IntToStr(Index, szIndex, sizeof(szIndex)));
+                        Key.Append('/');
+                        if (Size > 0)
+                            Key.Append(Path, Size);
+
+                        m_Children.Add(Key, Child);
+                    }
+                    Index = Child;
+                }
+
+                if (!bEnd) {
+                    Path += Size + 1;
+                    Length -= Size + 1;
+                }
+            }
+
+            const auto pNode = GetNode(Index);
+
+            if ((pNode->Methods & Methods) != 0)
+                throw ExceptionFrm(_T("Route \"%s %s\" is already defined."), MethodsToString(pNode->Methods & Methods).c_str(), Pattern.c_str());
+
+            const auto pRoute = new CHTTPRoute(Methods & hmAny, Pattern, std::move(OnRoute));
+
+            m_Routes.Add(pRoute);
+
+            pNode->Routes.Add(pRoute);
+            pNode->Methods |= pRoute->Methods();
+
+            return pRoute;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CHTTPRouter::Match(int Index, LPCTSTR Path, size_t Length, bool AEnd, int Method, CStringList &Params,
+                CHTTPRoute *&ARoute, int &Allowed) {
+
+            const auto pNode = GetNode(Index);
+
+            if (AEnd) {
+                Allowed |= pNode->Methods;
+                ARoute = pNode->RouteOf(Method);
+                return ARoute != nullptr;
+            }
+
+            size_t Size = 0;
+            while (Size < Length && Path[Size] != '/')
+                Size++;
+
+            const bool bEnd = Size == Length;
+
+            LPCTSTR Next = bEnd ? Path + Size : Path + Size + 1;
+            const size_t NextLength = bEnd ? 0 : Length - Size - 1;
+
+            // Literals win over captures, captures over a catch-all; a dead end falls back to the next kind.
+            const int Child = FindChild(Index, Path, Size);
+            if (Child != -1 && Match(Child, Next, NextLength, bEnd, Method, Params, ARoute, Allowed))
+                return true;
+
+            if (pNode->ParamChild != -1 && Size > 0) {
+                Params.AddPair(pNode->Param, CHTTPServer::URLDecode(CString(Path, Size)));
+                if (Match(pNode->ParamChild, Next, NextLength, bEnd, Method, Params, ARoute, Allowed))
+                    return true;
+                Params.Delete(Params.Count() - 1);
+            }
+
+            if (pNode->WildcardChild != -1) {
+                const auto pWildcard = GetNode(pNode->WildcardChild);
+
+                Allowed |= pWildcard->Methods;
+                ARoute = pWildcard->RouteOf(Method);
+
+                if (ARoute != nullptr) {
+                    Params.AddPair(pNode->Wildcard, Length == 0 ? CString() : CHTTPServer::URLDecode(CString(Path, Length)));
+                    return true;
+                }
+            }
+
+            return false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPRoute *CHTTPRouter::Find(const CString &Method, const CString &URI, CStringList &Params, int *Allowed) {
+            CHTTPRoute *pRoute = nullptr;
+            int AllowedMethods = hmUnknown;
+
+            size_t Length = URI.Find('?');
+            if (Length == CString::npos)
+                Length = URI.Size();
+
+            if (Length > 0 && URI.at(0) == '/') {
+                Match(0, URI.c_str() + 1, Length - 1, Length == 1, MethodOf(Method), Params, pRoute, AllowedMethods);
+            }
+
+            if (Allowed != nullptr)
+                *Allowed = AllowedMethods;
+
+            return pRoute;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CHTTPRouter::Dispatch(CHTTPServerConnection *AConnection) {
+            const auto &caRequest = AConnection->Request();
+
+            CStringList Params;
+            int Allowed = hmUnknown;
+
+            const auto pRoute = Find(caRequest.Method, caRequest.URI, Params, &Allowed);
+
+            if (pRoute != nullptr) {
+                if (pRoute->OnRoute() != nullptr)
+                    pRoute->OnRoute()(AConnection, pRoute, Params);
+                return true;
+            }
+
+            if (Allowed != hmUnknown) {
+                auto &Reply = AConnection->Reply();
+                const CString AllowedMethods(Reply.AllowedMethods);
+
+                Reply.AllowedMethods = MethodsToString(Allowed);
+                AConnection->SendStockReply(CHTTPReply::not_allowed, true);
+                Reply.AllowedMethods = AllowedMethods;
+
+                return true;
+            }
+
+            return false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPRouter::Dump(CStringList &Lines) const {
+            for (int i = 0; i < m_Routes.Count(); i++) {
+                const auto pRoute = Routes(i);
+                CString Line(MethodsToString(pRoute->Methods()));
+                Line.Append(' ');
+                Line.Append(pRoute->Pattern());
+                Lines.Add(Line);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CHTTPRouter::MethodOf(const CString &Method) {
+            for (const auto &Item : HTTPMethods) {
+                if (Method == Item.Name)
+                    return Item.Method;
+            }
+            return hmUnknown;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CString CHTTPRouter::MethodsToString(int Methods) {
+            CString Result;
+            for (const auto &Item : HTTPMethods) {
+                if ((Methods & Item.Method) != 0) {
+                    if (!Result.IsEmpty())
+                        Result.Append(_T(", "));
+                    Result.Append(Item.Name);
+                }
+            }
+            return Result;
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
         //-- CHTTPServer -----------------------------------------------------------------------------------------------
 
         //--------------------------------------------------------------------------------------------------------------
@@ -2448,9 +2796,10 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CHTTPServer::DoTimeOut(CPollEventHandler *AHandler) {
-            const auto pConnection = dynamic_cast<CHTTPServerConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = Contains(pBinding) ? static_cast<CHTTPServerConnection *> (pBinding) : nullptr;
 
-            if (IndexOfConnection(pConnection) != -1) {
+            if (pConnection != nullptr) {
                 try {
                     if (pConnection->Connected()) {
                         if (pConnection->Protocol() == pHTTP) {
@@ -2472,14 +2821,44 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        struct CHTTPServerMetrics {
+            CMetricHistogram *Duration;
+            CMetricCounter *Requests[5];
+            CMetricCounter *Errors;
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        static const CHTTPServerMetrics &HTTPServerMetrics() {
+            static const CHTTPServerMetrics Metrics = {
+                CMetricsRegistry::Default().Histogram("delphi_http_server_request_duration_seconds", "Time from a parsed request to its reply."),
+                {
+                    CMetricsRegistry::Default().Counter("delphi_http_server_requests_total", "HTTP requests answered.", "code=\"1xx\""),
+                    CMetricsRegistry::Default().Counter("delphi_http_server_requests_total", "HTTP requests answered.", "code=\"2xx\""),
+                    CMetricsRegistry::Default().Counter("delphi_http_server_requests_total", "HTTP requests answered.", "code=\"3xx\""),
+                    CMetricsRegistry::Default().Counter("delphi_http_server_requests_total", "HTTP requests answered.", "code=\"4xx\""),
+                    CMetricsRegistry::Default().Counter("delphi_http_server_requests_total", "HTTP requests answered.", "code=\"5xx\"")
+                },
+                CMetricsRegistry::Default().Counter("delphi_http_server_parse_errors_total", "Malformed HTTP requests.")
+            };
+            return Metrics;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         void CHTTPServer::DoAccept(CPollEventHandler *AHandler) {
-            CHTTPServerConnection *pConnection = nullptr;
+            for (int Count = 0; Count < AcceptBudget() || Count == 0; ++Count) {
+                CHTTPServerConnection *pConnection = nullptr;
 
-            try {
-                CIOHandlerSocket *pIOHandler = nullptr;
-                pIOHandler = CServerIOHandler::Accept(AHandler->Socket(), SOCK_NONBLOCK);
+                try {
+                    CIOHandlerSocket *pIOHandler = nullptr;
+#ifdef WITH_SSL
+                    pIOHandler = CServerIOHandler::Accept(AHandler->Socket(), SOCK_NONBLOCK, &m_SSLContext);
+#else
+                    pIOHandler = CServerIOHandler::Accept(AHandler->Socket(), SOCK_NONBLOCK);
+#endif
+
+                    if (pIOHandler == nullptr)
+                        break;
 
-                if (Assigned(pIOHandler)) {
                     pConnection = new CHTTPServerConnection(this);
 
                     pConnection->OnParse() = m_OnParse;
@@ -2501,10 +2880,11 @@ namespace Delphi {
                     pEventHandler->Start(etIO);
 
                     DoConnected(pConnection);
+                } catch (Delphi::Exception::Exception &E) {
+                    delete pConnection;
+                    DoListenException(E);
+                    break;
                 }
-            } catch (Delphi::Exception::Exception &E) {
-                delete pConnection;
-                DoListenException(E);
             }
         }
         //--------------------------------------------------------------------------------------------------------------
@@ -2515,12 +2895,14 @@ namespace Delphi {
                 return DoExecute(AConnection);
             };
 
-            const auto pConnection = dynamic_cast<CHTTPServerConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = Contains(pBinding) ? static_cast<CHTTPServerConnection *> (pBinding) : nullptr;
 
-            if (IndexOfConnection(pConnection) != -1) {
+            if (pConnection != nullptr) {
                 try {
                     pConnection->ParseInput(OnExecuted);
                     if (pConnection->ConnectionStatus() == csRequestError) {
+                        HTTPServerMetrics().Errors->Inc();
                         pConnection->CloseConnection(true);
                         if (pConnection->Protocol() == pHTTP)
                             pConnection->SendStockReply(CHTTPReply::bad_request);
@@ -2539,9 +2921,10 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CHTTPServer::DoWrite(CPollEventHandler *AHandler) {
-            const auto pConnection = dynamic_cast<CHTTPServerConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = Contains(pBinding) ? static_cast<CHTTPServerConnection *> (pBinding) : nullptr;
 
-            if (IndexOfConnection(pConnection) != -1) {
+            if (pConnection != nullptr) {
                 try {
                     if (pConnection->ConnectionStatus() == csReplyReady) {
                         if (pConnection->WriteAsync()) {
@@ -2566,6 +2949,16 @@ namespace Delphi {
             chASSERT(pConnection);
             const auto &caRequest = pConnection->Request();
 
+            if (m_Router.Count() > 0) {
+                try {
+                    if (m_Router.Dispatch(pConnection))
+                        return true;
+                } catch (Delphi::Exception::Exception &E) {
+                    DoException(AConnection, E);
+                    return true;
+                }
+            }
+
             const bool Result = CommandHandlers().Count() > 0;
 
             if (Result) {
@@ -2601,104 +2994,404 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CHTTPServer::DoReply(CObject *Sender) {
-            DoAccessLog(dynamic_cast<CHTTPServerConnection *> (Sender));
-        }
-
-        //--------------------------------------------------------------------------------------------------------------
+            const auto pConnection = dynamic_cast<CHTTPServerConnection *> (Sender);
 
-        //-- CHTTPClient -----------------------------------------------------------------------------------------------
+            if (pConnection != nullptr) {
+                const auto &Metrics = HTTPServerMetrics();
+                const int Class = pConnection->Reply().Status / 100;
 
-        //--------------------------------------------------------------------------------------------------------------
+                if (Class >= 1 && Class <= 5)
+                    Metrics.Requests[Class - 1]->Inc();
 
-        CHTTPClient::CHTTPClient(): CHTTPClient("localhost", 80) {
+                if (pConnection->RequestStart() != 0) {
+                    Metrics.Duration->ObserveSince(pConnection->RequestStart());
+                    pConnection->RequestStart(0);
+                }
+            }
 
+            DoAccessLog(pConnection);
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        CHTTPClient::CHTTPClient(const CString &Host, unsigned short Port): CAsyncClient(Host, Port) {
+        CHTTPRoute *CHTTPServer::MountMetrics(const CString &Path, CMetricsRegistry *ARegistry) {
+            CMetricsRegistry &Registry = ARegistry == nullptr ? CMetricsRegistry::Default() : *ARegistry;
 
+            return m_Router.Add(hmGet, Path, [&Registry](CHTTPServerConnection *AConnection, CHTTPRoute *, const CStringList &) {
+                auto &Reply = AConnection->Reply();
+
+                Reply.Content = Registry.Text();
+                AConnection->SendReply(CHTTPReply::ok, _T(METRICS_CONTENT_TYPE), true);
+            });
         }
+
         //--------------------------------------------------------------------------------------------------------------
 
-        void CHTTPClient::DoConnectStart(CIOHandlerSocket *AIOHandler, CPollEventHandler *AHandler) {
-            const auto pConnection = new CHTTPClientConnection(this);
-            pConnection->IOHandler(AIOHandler);
-            pConnection->AutoFree(true);
-            AHandler->Binding(pConnection);
-        }
+        //-- CHTTPConnectionPool ---------------------------------------------------------------------------------------
+
         //--------------------------------------------------------------------------------------------------------------
 
-        void CHTTPClient::DoConnect(CPollEventHandler *AHandler) {
-            const auto pConnection = dynamic_cast<CHTTPClientConnection *> (AHandler->Binding());
+        CHTTPConnectionPool::CHTTPConnectionPool(): CObject() {
+            m_MaxIdle = HTTP_POOL_MAX_IDLE;
+            m_MaxIdlePerHost = HTTP_POOL_MAX_IDLE_PER_HOST;
+            m_IdleTimeOut = HTTP_POOL_IDLE_TIMEOUT;
 
-            if (pConnection == nullptr) {
-                AHandler->Stop();
-                return;
-            }
+            m_Hits = 0;
+            m_Misses = 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
-            try {
-                const auto pIOHandler = dynamic_cast<CIOHandlerSocket *> (pConnection->IOHandler());
+        CHTTPConnectionPool::~CHTTPConnectionPool() {
+            Clear();
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
-                if (pIOHandler != nullptr && pIOHandler->Binding()->CheckConnection()) {
-#if defined(_GLIBCXX_RELEASE) && (_GLIBCXX_RELEASE >= 9)
-                    pConnection->OnDisconnected([this](auto && Sender) { DoDisconnected(Sender); });
+        CString CHTTPConnectionPool::GetKey(CHTTPClient *AClient) {
+            CString Key;
+#ifdef WITH_SSL
+            LPCSTR lpszScheme = AClient->UsedSSL() ? HTTPS_PREFIX : HTTP_PREFIX;
 #else
-                    pConnection->OnDisconnected(std::bind(&CHTTPClient::DoDisconnected, this, _1));
+            LPCSTR lpszScheme = HTTP_PREFIX;
 #endif
-                    DoConnected(pConnection);
-                    DoRequest(pConnection);
-
-                    AHandler->Start(etIO);
-                }
-            } catch (Delphi::Exception::Exception &E) {
-                DoException(pConnection, E);
-                AHandler->Stop();
-            }
+            Key.Format("%s://%s:%u", lpszScheme, AClient->Host().c_str(), AClient->Port());
+            return Key;
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        void CHTTPClient::DoRead(CPollEventHandler *AHandler) {
+        bool CHTTPConnectionPool::KeepAlive(const CHTTPReply &Reply) {
+            const int StatusCode = StrToIntDef(Reply.StatusString.c_str(), 0);
 
-            auto OnExecuted = [this](CTCPConnection *AConnection) {
-                return DoExecute(AConnection);
-            };
+            if (StatusCode < 200)
+                return false;
 
-            const auto pConnection = dynamic_cast<CHTTPClientConnection *> (AHandler->Binding());
+            const CString Connection(Reply.Headers[_T("Connection")].Lower());
 
-            if (pConnection == nullptr) {
-                AHandler->Stop();
-                return;
-            }
+            if (Connection.Find("close") != CString::npos)
+                return false;
 
-            try {
-                if (pConnection->ParseInput(OnExecuted)) {
-                    switch (pConnection->ConnectionStatus()) {
-                        case csReplyError:
-                            pConnection->Clear();
-                            break;
+            if ((Reply.VMajor < 1 || (Reply.VMajor == 1 && Reply.VMinor == 0)) && Connection.Find("keep-alive") == CString::npos)
+                return false;
 
-                        case csReplyOk:
-                            pConnection->Clear();
+            if (StatusCode == 204 || StatusCode == 304)
+                return true;
 
-                            if (pConnection->CloseConnection()) {
-                                pConnection->Disconnect();
-                            }
+            // Without a length or chunked framing the reply ends with the connection.
+            return !Reply.Headers[_T("Content-Length")].IsEmpty() || Reply.Headers[_T("Transfer-Encoding")] == "chunked";
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
-                            break;
+        int CHTTPConnectionPool::IdleCount(const CString &Key) {
+            int Result = 0;
+            for (int i = 0; i < m_Connections.Count(); i++) {
+                const auto pConnection = static_cast<CHTTPClientConnection *> (m_Connections.Items(i));
+                if (pConnection->PoolKey() == Key)
+                    Result++;
+            }
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
-                        default:
-                            break;
-                    }
-                }
-            } catch (Delphi::Exception::Exception &E) {
-                DoException(pConnection, E);
-                AHandler->Stop();
+        void CHTTPConnectionPool::Evict(CHTTPClientConnection *AConnection) {
+            const auto pHandler = AConnection->EventHandler();
+
+            AConnection->Collection(nullptr);
+
+            if (pHandler != nullptr) {
+                pHandler->Stop();
+            } else if (AConnection->AutoFree()) {
+                delete AConnection;
             }
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        void CHTTPClient::DoWrite(CPollEventHandler *AHandler) {
-            auto pConnection = dynamic_cast<CHTTPClientConnection *> (AHandler->Binding());
+        void CHTTPConnectionPool::Clear() {
+            for (int i = m_Connections.Count() - 1; i >= 0; i--) {
+                Evict(static_cast<CHTTPClientConnection *> (m_Connections.Items(i)));
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPConnectionPool::DoRead(CPollEventHandler *AHandler) {
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CHTTPClientConnection *> (pBinding) : nullptr;
+
+            if (pConnection == nullptr) {
+                AHandler->Stop();
+                return;
+            }
+
+            // An idle upstream has nothing to say: data, EOF or an error all end its life.
+            char ch;
+            if (::recv(AHandler->Socket(), &ch, sizeof(ch), MSG_PEEK | MSG_DONTWAIT) == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return;
+
+            Evict(pConnection);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPConnectionPool::DoTimeOut(CPollEventHandler *AHandler) {
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CHTTPClientConnection *> (pBinding) : nullptr;
+
+            if (pConnection == nullptr) {
+                AHandler->Stop();
+                return;
+            }
+
+            Evict(pConnection);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPClientConnection *CHTTPConnectionPool::Acquire(CHTTPClient *AClient) {
+            if (AClient->ExternalEventHandlers() && m_Connections.Count() > 0) {
+                const auto &Key = GetKey(AClient);
+                const auto DateTime = Now();
+
+                // Most recently parked first: it is the least likely to have been closed by the peer.
+                for (int i = m_Connections.Count() - 1; i >= 0; i--) {
+                    const auto pConnection = static_cast<CHTTPClientConnection *> (m_Connections.Items(i));
+                    const auto pHandler = pConnection->EventHandler();
+
+                    if (pConnection->PoolKey() != Key || pHandler == nullptr || pHandler->Collection() != AClient->EventHandlers())
+                        continue;
+
+                    if (pHandler->Stopped() || !pConnection->Connected() || DateTime >= pConnection->TimeOut()) {
+                        Evict(pConnection);
+                        continue;
+                    }
+
+                    pConnection->Collection(AClient->ptrConnections());
+                    pConnection->Client(AClient);
+                    pConnection->PoolKey(CString());
+
+                    m_Hits++;
+
+                    return pConnection;
+                }
+            }
+
+            m_Misses++;
+
+            return nullptr;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CHTTPConnectionPool::Release(CHTTPClient *AClient, CHTTPClientConnection *AConnection) {
+            if (!AClient->ExternalEventHandlers() || m_MaxIdle <= 0)
+                return false;
+
+            const auto pHandler = AConnection->EventHandler();
+
+            if (pHandler == nullptr || pHandler->Stopped() || !AConnection->Connected())
+                return false;
+
+            const auto &Key = GetKey(AClient);
+
+            if (IdleCount(Key) >= m_MaxIdlePerHost)
+                return false;
+
+            if (m_Connections.Count() >= m_MaxIdle)
+                Evict(static_cast<CHTTPClientConnection *> (m_Connections.Items(0)));
+
+            AConnection->Collection(&m_Connections);
+            AConnection->Client(nullptr);
+            AConnection->PoolKey(Key);
+            AConnection->OnDisconnected(nullptr);
+#ifdef WITH_SSL
+            // The owning client, and with it its context, may be gone before the connection is reused.
+            const auto pIOHandler = dynamic_cast<CIOHandlerSocket *> (AConnection->IOHandler());
+            if (pIOHandler != nullptr)
+                pIOHandler->Binding()->SSLContext(nullptr);
+#endif
+#if defined(_GLIBCXX_RELEASE) && (_GLIBCXX_RELEASE >= 9)
+            pHandler->OnTimeOutEvent([this](auto && AHandler) { DoTimeOut(AHandler); });
+            pHandler->OnReadEvent([this](auto && AHandler) { DoRead(AHandler); });
+            pHandler->OnWriteEvent([this](auto && AHandler) { DoWrite(AHandler); });
+#else
+            pHandler->OnTimeOutEvent(std::bind(&CHTTPConnectionPool::DoTimeOut, this, _1));
+            pHandler->OnReadEvent(std::bind(&CHTTPConnectionPool::DoRead, this, _1));
+            pHandler->OnWriteEvent(std::bind(&CHTTPConnectionPool::DoWrite, this, _1));
+#endif
+            AConnection->TimeOutInterval(m_IdleTimeOut);
+            AConnection->TimeOut(Now() + (CDateTime) m_IdleTimeOut / MSecsPerDay);
+
+            return true;
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CHTTPClient -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPClient::CHTTPClient(): CHTTPClient("localhost", 80) {
+
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPClient::CHTTPClient(const CString &Host, unsigned short Port): CAsyncClient(Host, Port) {
+            m_pPool = nullptr;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPClient::ConnectStart() {
+            const auto pConnection = m_pPool == nullptr ? nullptr : m_pPool->Acquire(this);
+
+            if (pConnection == nullptr) {
+                CAsyncClient::ConnectStart();
+                return;
+            }
+
+            const auto pHandler = pConnection->EventHandler();
+#if defined(_GLIBCXX_RELEASE) && (_GLIBCXX_RELEASE >= 9)
+            pHandler->OnTimeOutEvent([this](auto && AHandler) { DoTimeOut(AHandler); });
+            pHandler->OnReadEvent([this](auto && AHandler) { DoRead(AHandler); });
+            pHandler->OnWriteEvent([this](auto && AHandler) { DoWrite(AHandler); });
+            pConnection->OnDisconnected([this](auto && Sender) { DoDisconnected(Sender); });
+#else
+            pHandler->OnTimeOutEvent(std::bind(&CHTTPClient::DoTimeOut, this, _1));
+            pHandler->OnReadEvent(std::bind(&CHTTPClient::DoRead, this, _1));
+            pHandler->OnWriteEvent(std::bind(&CHTTPClient::DoWrite, this, _1));
+            pConnection->OnDisconnected(std::bind(&CHTTPClient::DoDisconnected, this, _1));
+#endif
+            pConnection->TimeOutInterval(m_pEventHandlers->PollStack().TimeOut());
+            pConnection->UpdateTimeOut(Now());
+#ifdef WITH_SSL
+            const auto pIOHandler = dynamic_cast<CIOHandlerSocket *> (pConnection->IOHandler());
+            if (pIOHandler != nullptr)
+                pIOHandler->Binding()->SSLContext(&m_SSLContext);
+#endif
+            auto &Request = pConnection->Request();
+
+            Request.Location.hostname = m_Host;
+            Request.Location.port = m_Port;
+            Request.UserAgent = m_ClientName;
+
+            try {
+                DoConnected(pConnection);
+                DoRequest(pConnection);
+            } catch (Delphi::Exception::Exception &E) {
+                DoException(pConnection, E);
+                pHandler->Stop();
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPClient::DoConnectStart(CIOHandlerSocket *AIOHandler, CPollEventHandler *AHandler) {
+            const auto pConnection = new CHTTPClientConnection(this);
+            pConnection->IOHandler(AIOHandler);
+            pConnection->AutoFree(true);
+            pConnection->CloseConnection(m_pPool == nullptr);
+            AHandler->Binding(pConnection);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPClient::DoConnect(CPollEventHandler *AHandler) {
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CHTTPClientConnection *> (pBinding) : nullptr;
+
+            if (pConnection == nullptr) {
+                AHandler->Stop();
+                return;
+            }
+
+            try {
+                const auto pIOHandler = dynamic_cast<CIOHandlerSocket *> (pConnection->IOHandler());
+
+                if (pIOHandler != nullptr && pIOHandler->Binding()->CheckConnection()) {
+#if defined(_GLIBCXX_RELEASE) && (_GLIBCXX_RELEASE >= 9)
+                    pConnection->OnDisconnected([this](auto && Sender) { DoDisconnected(Sender); });
+#else
+                    pConnection->OnDisconnected(std::bind(&CHTTPClient::DoDisconnected, this, _1));
+#endif
+                    DoConnected(pConnection);
+                    DoRequest(pConnection);
+
+                    AHandler->Start(etIO);
+                }
+            } catch (Delphi::Exception::Exception &E) {
+                DoException(pConnection, E);
+                AHandler->Stop();
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        struct CHTTPClientMetrics {
+            CMetricHistogram *Duration;
+            CMetricCounter *Replies;
+            CMetricCounter *Errors;
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        static const CHTTPClientMetrics &HTTPClientMetrics() {
+            static const CHTTPClientMetrics Metrics = {
+                CMetricsRegistry::Default().Histogram("delphi_http_client_request_duration_seconds", "Time from sending a request to its parsed reply."),
+                CMetricsRegistry::Default().Counter("delphi_http_client_replies_total", "HTTP replies received."),
+                CMetricsRegistry::Default().Counter("delphi_http_client_errors_total", "HTTP client requests failed on a malformed reply or a socket error.")
+            };
+            return Metrics;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPClient::DoRead(CPollEventHandler *AHandler) {
+
+            auto OnExecuted = [this](CTCPConnection *AConnection) {
+                return DoExecute(AConnection);
+            };
+
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CHTTPClientConnection *> (pBinding) : nullptr;
+
+            if (pConnection == nullptr) {
+                AHandler->Stop();
+                return;
+            }
+
+            try {
+                if (pConnection->ParseInput(OnExecuted)) {
+                    switch (pConnection->ConnectionStatus()) {
+                        case csReplyError:
+                            HTTPClientMetrics().Errors->Inc();
+                            pConnection->Clear();
+                            break;
+
+                        case csReplyOk: {
+                            HTTPClientMetrics().Replies->Inc();
+                            if (pConnection->RequestStart() != 0)
+                                HTTPClientMetrics().Duration->ObserveSince(pConnection->RequestStart());
+
+                            const bool bKeepAlive = m_pPool != nullptr && pConnection->Protocol() == pHTTP &&
+                                CHTTPConnectionPool::KeepAlive(pConnection->Reply());
+
+                            pConnection->Clear();
+
+                            if (pConnection->CloseConnection()) {
+                                pConnection->Disconnect();
+                            } else if (m_pPool != nullptr) {
+                                if (bKeepAlive && m_pPool->Release(this, pConnection)) {
+                                    DoDisconnected(pConnection);
+                                } else {
+                                    pConnection->Disconnect();
+                                }
+                            }
+
+                            break;
+                        }
+
+                        default:
+                            break;
+                    }
+                }
+            } catch (Delphi::Exception::Exception &E) {
+                HTTPClientMetrics().Errors->Inc();
+                DoException(pConnection, E);
+                AHandler->Stop();
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPClient::DoWrite(CPollEventHandler *AHandler) {
+            const auto pBinding = AHandler->Binding();
+            auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CHTTPClientConnection *> (pBinding) : nullptr;
 
             if (pConnection == nullptr) {
                 AHandler->Stop();
@@ -2763,6 +3456,9 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CHTTPClient::DoRequest(CHTTPClientConnection *AConnection) {
+            if (m_pPool != nullptr)
+                AConnection->Request().CloseConnection = false;
+
             if (m_OnRequest != nullptr) {
                 m_OnRequest(this, AConnection->Request());
                 AConnection->SendRequest(true);
@@ -2776,13 +3472,13 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         CHTTPClientItem::CHTTPClientItem(CHTTPClientManager *AManager): CCollectionItem(AManager), CHTTPClient() {
-
+            m_pPool = AManager->Pool();
         }
         //--------------------------------------------------------------------------------------------------------------
 
         CHTTPClientItem::CHTTPClientItem(CHTTPClientManager *AManager, const CString &Host, unsigned short Port):
             CCollectionItem(AManager), CHTTPClient(Host, Port) {
-
+            m_pPool = AManager->Pool();
         }
 
         //--------------------------------------------------------------------------------------------------------------
@@ -2802,6 +3498,469 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        //-- CHTTPLoadSession ------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        /// Timing of the request in flight on one load connection, in MetricsTime() units
+        class CHTTPLoadSession: public CObject {
+        public:
+
+            uint64_t Intended = 0;
+            uint64_t Sent = 0;
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CHTTPLoadClient -------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPLoadClient::CHTTPLoadClient(CHTTPLoadGenerator *AGenerator, int Connections, double Rate):
+                CHTTPClient(AGenerator->Host(), AGenerator->Port()) {
+
+            m_pGenerator = AGenerator;
+            m_pTimer = nullptr;
+
+            m_ConnectionCount = Connections;
+            m_Reconnect = 0;
+
+            m_Start = 0;
+            m_Stop = 0;
+            m_Armed = 0;
+            m_Issued = 0;
+
+            m_Interval = Rate > 0 ? 1e6 / Rate : 0;
+
+            m_Replies = 0;
+            m_Errors = 0;
+
+            m_AutoConnect = false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPLoadClient::~CHTTPLoadClient() {
+            for (int i = 0; i < m_Sessions.Count(); ++i)
+                delete static_cast<CHTTPLoadSession *> (m_Sessions.Items(i));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::Start(uint64_t Start) {
+            CHTTPRequest Request;
+
+            Request.Location.hostname = m_Host;
+            Request.Location.port = m_Port;
+            Request.UserAgent = m_ClientName;
+            Request.CloseConnection = false;
+
+            if (m_pGenerator->OnRequest() != nullptr) {
+                m_pGenerator->OnRequest()(this, Request);
+            } else {
+                CHTTPRequest::Prepare(Request, "GET", "/");
+            }
+
+            m_Request.Clear();
+            Request.ToBuffers(m_Request);
+
+            m_Start = Start;
+
+            EventHandlers()->PollStack().TimeOut(HTTP_LOAD_POLL_TIMEOUT);
+
+            Active(true);
+
+            if (m_Interval > 0) {
+                m_pTimer = CEPollTimer::CreateTimer(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+                m_pTimer->AllocateTimer(m_pEventHandlers, 0);
+#if defined(_GLIBCXX_RELEASE) && (_GLIBCXX_RELEASE >= 9)
+                m_pTimer->OnTimer([this](auto && AHandler) { DoTimer(AHandler); });
+#else
+                m_pTimer->OnTimer(std::bind(&CHTTPLoadClient::DoTimer, this, _1));
+#endif
+            }
+
+            for (int i = 0; i < m_ConnectionCount; ++i)
+                ConnectStart();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::Poll() {
+            try {
+                Wait();
+            } catch (Delphi::Exception::Exception &E) {
+                DoException(nullptr, E);
+            }
+
+            for (; m_Reconnect > 0; m_Reconnect--)
+                ConnectStart();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint64_t CHTTPLoadClient::Due(uint64_t Now) const {
+            if (Now < m_Start)
+                return 0;
+            return (uint64_t) ((double) (Now - m_Start) / m_Interval) + 1;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::Stop() {
+            m_Stop = MetricsTime();
+            Active(false);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint64_t CHTTPLoadClient::Backlog() const {
+            if (m_Interval == 0)
+                return 0;
+            const auto Count = Due(m_Stop == 0 ? MetricsTime() : m_Stop);
+            return Count > m_Issued ? Count - m_Issued : 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::Send(CHTTPClientConnection *AConnection, uint64_t Intended) {
+            const auto pSession = static_cast<CHTTPLoadSession *> (AConnection->Object());
+
+            pSession->Intended = Intended;
+            pSession->Sent = MetricsTime();
+
+            AConnection->OutputBuffer().Write(m_Request.Memory(), m_Request.Size());
+            AConnection->ConnectionStatus(csRequestReady);
+
+            if (AConnection->WriteAsync()) {
+                AConnection->ConnectionStatus(csRequestSent);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::Next(CHTTPClientConnection *AConnection, uint64_t Now) {
+            if (m_Interval == 0) {
+                Send(AConnection, Now);
+                return;
+            }
+
+            // A backlogged request goes out at once and keeps its original due time
+            if (m_Issued < Due(Now)) {
+                Send(AConnection, Intended(m_Issued++));
+                return;
+            }
+
+            m_Idle.Add(AConnection);
+            Arm(Now);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::Complete(CHTTPClientConnection *AConnection) {
+            const auto pSession = static_cast<CHTTPLoadSession *> (AConnection->Object());
+            const auto Now = MetricsTime();
+
+            if (AConnection->Reply().Status >= CHTTPReply::bad_request)
+                m_Errors++;
+
+            if (m_pGenerator->Recording()) {
+                m_pGenerator->Latency().Observe(Now - pSession->Intended);
+                m_pGenerator->ServiceTime().Observe(Now - pSession->Sent);
+                m_Replies++;
+            }
+
+            AConnection->Clear();
+
+            Next(AConnection, Now);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::Schedule(uint64_t Now) {
+            const auto Count = Due(Now);
+
+            while (m_Issued < Count && m_Idle.Count() > 0) {
+                const auto pConnection = static_cast<CHTTPClientConnection *> (m_Idle.Last());
+                m_Idle.Delete(m_Idle.Count() - 1);
+                Send(pConnection, Intended(m_Issued++));
+            }
+
+            if (m_Idle.Count() > 0)
+                Arm(Now);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::Arm(uint64_t Now) {
+            const auto Next = Intended(m_Issued);
+
+            if (Next == m_Armed)
+                return;
+
+            m_Armed = Next;
+
+            // A zero it_value disarms the timer, so an overdue request gets the shortest delay instead
+            const auto Delay = Next > Now ? Next - Now : 0;
+
+            struct itimerspec ts = {{0, 0}, {0, 0}};
+
+            ts.it_value.tv_sec = (time_t) (Delay / 1000000);
+            ts.it_value.tv_nsec = (long) (Delay % 1000000) * 1000 + 1;
+
+            m_pTimer->SetTime(0, &ts);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::DoTimer(CPollEventHandler *AHandler) {
+            uint64_t exp;
+
+            const auto pTimer = dynamic_cast<CEPollTimer *> (AHandler->Binding());
+            pTimer->Read(&exp, sizeof(uint64_t));
+
+            m_Armed = 0;
+
+            try {
+                Schedule(MetricsTime());
+            } catch (Delphi::Exception::Exception &E) {
+                DoException(nullptr, E);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::DoConnectStart(CIOHandlerSocket *AIOHandler, CPollEventHandler *AHandler) {
+            CHTTPClient::DoConnectStart(AIOHandler, AHandler);
+            static_cast<CHTTPClientConnection *> (AHandler->Binding())->CloseConnection(false);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::DoRead(CPollEventHandler *AHandler) {
+
+            auto OnExecuted = [this](CTCPConnection *AConnection) {
+                return DoExecute(AConnection);
+            };
+
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CHTTPClientConnection *> (pBinding) : nullptr;
+
+            if (pConnection == nullptr) {
+                AHandler->Stop();
+                return;
+            }
+
+            try {
+                if (pConnection->ParseInput(OnExecuted)) {
+                    switch (pConnection->ConnectionStatus()) {
+                        case csReplyError:
+                            throw Delphi::Exception::Exception("Invalid HTTP reply.");
+
+                        case csReplyOk:
+                            Complete(pConnection);
+                            break;
+
+                        default:
+                            break;
+                    }
+                }
+            } catch (Delphi::Exception::Exception &E) {
+                DoException(pConnection, E);
+                pConnection->Disconnect();
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CHTTPLoadClient::DoExecute(CTCPConnection *) {
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::DoRequest(CHTTPClientConnection *AConnection) {
+            const auto pSession = new CHTTPLoadSession();
+
+            m_Sessions.Add(pSession);
+            AConnection->Object(pSession);
+
+            const auto Now = MetricsTime();
+
+            if (m_Interval == 0) {
+                Send(AConnection, Now);
+            } else {
+                m_Idle.Add(AConnection);
+                Schedule(Now);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::DoDisconnected(CObject *Sender) {
+            const auto pConnection = dynamic_cast<CHTTPClientConnection *> (Sender);
+
+            // Only connections that got as far as a request are reopened, so a refusing server is not hammered
+            if (pConnection != nullptr && pConnection->Object() != nullptr) {
+                pConnection->Object(nullptr);
+                m_Idle.Remove(pConnection);
+                m_Reconnect++;
+            }
+
+            CHTTPClient::DoDisconnected(Sender);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadClient::DoException(CTCPConnection *AConnection, const Delphi::Exception::Exception &E) {
+            m_Errors++;
+            CHTTPClient::DoException(AConnection, E);
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CHTTPLoadThread -------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPLoadThread::CHTTPLoadThread(CHTTPLoadClient *AClient): CThread(true) {
+            m_pClient = AClient;
+
+            FreeOnTerminate(false);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadThread::Execute() {
+            while (!Terminated()) {
+                m_pClient->Poll();
+            }
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CHTTPLoadGenerator ----------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPLoadGenerator::CHTTPLoadGenerator(const CString &Host, unsigned short Port): CObject(),
+                m_Latency("delphi_http_load_latency_microseconds", "Time from the intended send to the parsed reply.", CString()),
+                m_ServiceTime("delphi_http_load_service_time_microseconds", "Time from the actual send to the parsed reply.", CString()) {
+
+            m_Host = Host;
+            m_Port = Port;
+
+            m_Connections = 64;
+            m_Threads = 1;
+
+            m_Rate = 0;
+
+            m_Active = false;
+            m_Recording = false;
+
+            m_OnRequest = nullptr;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPLoadGenerator::~CHTTPLoadGenerator() {
+            Stop();
+            Clear();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadGenerator::Clear() {
+            for (int i = 0; i < m_Clients.Count(); ++i)
+                delete static_cast<CHTTPLoadClient *> (m_Clients.Items(i));
+            m_Clients.Clear();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadGenerator::Start() {
+            if (m_Active)
+                return;
+
+            Clear();
+
+            const int Threads = m_Threads < 1 ? 1 : (m_Threads > m_Connections ? m_Connections : m_Threads);
+
+            // Connections are opened here, before any reactor thread runs, so each client is only ever touched by
+            // one thread at a time
+            const auto Start = MetricsTime();
+
+            for (int i = 0; i < Threads; ++i) {
+                const int Connections = m_Connections / Threads + (i < m_Connections % Threads ? 1 : 0);
+                const auto pClient = new CHTTPLoadClient(this, Connections, m_Rate / Threads);
+                m_Clients.Add(pClient);
+                pClient->Start(Start);
+            }
+
+            for (int i = 0; i < m_Clients.Count(); ++i) {
+                const auto pThread = new CHTTPLoadThread(static_cast<CHTTPLoadClient *> (m_Clients.Items(i)));
+                m_ThreadList.Add(pThread);
+                pThread->Resume();
+            }
+
+            m_Active = true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPLoadGenerator::Stop() {
+            if (!m_Active)
+                return;
+
+            Recording(false);
+
+            for (int i = 0; i < m_ThreadList.Count(); ++i)
+                static_cast<CHTTPLoadThread *> (m_ThreadList.Items(i))->Terminate();
+
+            for (int i = 0; i < m_ThreadList.Count(); ++i) {
+                const auto pThread = static_cast<CHTTPLoadThread *> (m_ThreadList.Items(i));
+                pThread->WaitFor();
+                delete pThread;
+            }
+
+            m_ThreadList.Clear();
+
+            for (int i = 0; i < m_Clients.Count(); ++i)
+                static_cast<CHTTPLoadClient *> (m_Clients.Items(i))->Stop();
+
+            m_Active = false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static void LoadSleep(double Seconds) {
+            struct timespec ts = {(time_t) Seconds, (long) ((Seconds - (double) (time_t) Seconds) * 1e9)};
+            while (::nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        double CHTTPLoadGenerator::Run(double Warmup, double Duration) {
+            Start();
+
+            LoadSleep(Warmup);
+
+            Recording(true);
+            const auto Start = MetricsTime();
+
+            LoadSleep(Duration);
+
+            Recording(false);
+            const auto Elapsed = (double) (MetricsTime() - Start) / 1e6;
+
+            Stop();
+
+            return Elapsed;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint64_t CHTTPLoadGenerator::Replies() const {
+            uint64_t Result = 0;
+            for (int i = 0; i < m_Clients.Count(); ++i)
+                Result += static_cast<CHTTPLoadClient *> (m_Clients.Items(i))->Replies();
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint64_t CHTTPLoadGenerator::Errors() const {
+            uint64_t Result = 0;
+            for (int i = 0; i < m_Clients.Count(); ++i)
+                Result += static_cast<CHTTPLoadClient *> (m_Clients.Items(i))->Errors();
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint64_t CHTTPLoadGenerator::Backlog() const {
+            uint64_t Result = 0;
+            for (int i = 0; i < m_Clients.Count(); ++i)
+                Result += static_cast<CHTTPLoadClient *> (m_Clients.Items(i))->Backlog();
+            return Result;
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
         //-- CHTTPProxy ------------------------------------------------------------------------------------------------
 
         //--------------------------------------------------------------------------------------------------------------
@@ -2810,19 +3969,42 @@ namespace Delphi {
             m_ProxyType = ptHTTP;
             m_pProxyConnection = nullptr;
             m_pConnection = AConnection;
+
+            m_Tunnel = false;
+            m_Tunnelling = false;
+            m_Splice = false;
             m_ClientName = Server()->ServerName();
 
             m_Request.Location.hostname = Host();
             m_Request.Location.port = Port();
             m_Request.UserAgent = ClientName();
+            m_Request.CloseConnection = m_pPool == nullptr;
 
             AllocateEventHandlers(Server());
         }
         //--------------------------------------------------------------------------------------------------------------
+
+        CHTTPProxy::~CHTTPProxy() {
+            // The downstream peer cannot be served by anyone else once its bytes were relayed.
+            if (m_Tunnelling)
+                m_pConnection->Disconnect();
+            ClosePipes();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPProxy::ConnectStart() {
+            // A SOCKS5 or raw tunnel is bound to its target and cannot be handed to another request.
+            if (m_ProxyType == ptHTTP && !m_Tunnel) {
+                CHTTPClient::ConnectStart();
+            } else {
+                CAsyncClient::ConnectStart();
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
 #ifdef WITH_SSL
         void CHTTPProxy::SetUsedSSL(bool Value) {
             CAsyncClient::SetUsedSSL(Value);
-            if (m_pProxyConnection != nullptr) {
+            if (m_Connections.Contains(m_pProxyConnection)) {
                 auto pIOHandler = dynamic_cast<CIOHandlerSocket *> (m_pProxyConnection->IOHandler());
                 auto pBinding = pIOHandler->Binding();
                 pBinding->SSLMethod(Value ? sslClient : sslNotUsed);
@@ -2841,12 +4023,14 @@ namespace Delphi {
             m_pProxyConnection = new CHTTPClientConnection(this);
             m_pProxyConnection->IOHandler(AIOHandler);
             m_pProxyConnection->AutoFree(true);
+            m_pProxyConnection->CloseConnection(m_pPool == nullptr || m_ProxyType != ptHTTP || m_Tunnel);
             AHandler->Binding(m_pProxyConnection);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CHTTPProxy::DoConnect(CPollEventHandler *AHandler) {
-            auto pConnection = dynamic_cast<CHTTPClientConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CHTTPClientConnection *> (pBinding) : nullptr;
 
             if (pConnection == nullptr) {
                 AHandler->Stop();
@@ -2875,10 +4059,13 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CHTTPProxy::DoRead(CPollEventHandler *AHandler) {
-            if (m_ProxyType == ptHTTP) {
+            if (m_Tunnelling) {
+                DoTunnel(AHandler);
+            } else if (m_ProxyType == ptHTTP) {
                 CHTTPClient::DoRead(AHandler);
             } else {
-                const auto pConnection = dynamic_cast<CHTTPClientConnection *> (AHandler->Binding());
+                const auto pBinding = AHandler->Binding();
+                const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CHTTPClientConnection *> (pBinding) : nullptr;
 
                 if (pConnection == nullptr) {
                     AHandler->Stop();
@@ -2893,6 +4080,24 @@ namespace Delphi {
                     if (frame[0] == 0x05 && (frame[1] == 0x00 || frame[1] == 0x06)) {
                         if (Stream.Size() == 2) {
                             SOCKS5(pConnection);
+                        } else if (m_Tunnel) {
+                            // The target may speak first: whatever follows the connect reply belongs to the tunnel.
+                            const auto Reply = (LPCBYTE) Stream.Memory();
+                            size_t Size = 0;
+
+                            if (Stream.Size() > 4) {
+                                switch (Reply[3]) {
+                                    case 0x01: Size = 10; break;
+                                    case 0x03: Size = 7 + Reply[4]; break;
+                                    case 0x04: Size = 22; break;
+                                    default: break;
+                                }
+                            }
+
+                            if (Size > 0 && Size < Stream.Size())
+                                pConnection->InputBuffer().WriteBuffer(Reply + Size, Stream.Size() - Size);
+
+                            StartTunnel(pConnection);
                         } else {
                             m_ProxyType = ptHTTP;
 #ifdef WITH_SSL
@@ -2909,10 +4114,13 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CHTTPProxy::DoWrite(CPollEventHandler *AHandler) {
-            if (m_ProxyType == ptHTTP) {
+            if (m_Tunnelling) {
+                DoTunnel(AHandler);
+            } else if (m_ProxyType == ptHTTP) {
                 CHTTPClient::DoWrite(AHandler);
             } else {
-                auto pConnection = dynamic_cast<CHTTPClientConnection *> (AHandler->Binding());
+                const auto pBinding = AHandler->Binding();
+                auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CHTTPClientConnection *> (pBinding) : nullptr;
 
                 if (pConnection == nullptr) {
                     AHandler->Stop();
@@ -2961,6 +4169,8 @@ namespace Delphi {
         void CHTTPProxy::DoHandshake(CHTTPClientConnection *AConnection) {
             if (m_ProxyType == ptSOCKS5) {
                 Auth(AConnection);
+            } else if (m_Tunnel) {
+                StartTunnel(AConnection);
             } else {
                 DoRequest(AConnection);
             }
@@ -2972,6 +4182,195 @@ namespace Delphi {
             Request = m_Request;
             AConnection->SendRequest(true);
         }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPProxy::Relay(CTCPConnection *AFrom, CTCPConnection *ATo, CTunnelChannel &Channel) {
+            if (!Channel.Eof) {
+                AFrom->ReadAsync(false);
+
+                auto &Input = AFrom->InputBuffer();
+                const auto Count = Input.Size();
+                if (Count > 0) {
+                    ATo->OutputBuffer().WriteBuffer(Input.Memory(), Count);
+                    Input.Remove(Count);
+                    Channel.Bytes += Count;
+                }
+                Channel.Eof = AFrom->ClosedGracefully();
+            }
+
+            if (ATo->OutputBuffer().Size() > 0)
+                ATo->WriteAsync();
+
+            Channel.Pending = ATo->OutputBuffer().Size();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPProxy::Splice(CTCPConnection *AFrom, CTCPConnection *ATo, CTunnelChannel &Channel) {
+            // Whatever was queued the usual way (the CONNECT reply) goes out before spliced bytes.
+            if (ATo->OutputBuffer().Size() > 0 && !ATo->WriteAsync())
+                return;
+
+            const auto hFrom = AFrom->Socket()->Binding()->Handle();
+            const auto hTo = ATo->Socket()->Binding()->Handle();
+
+            while (true) {
+                if (Channel.Pending > 0) {
+                    const auto Count = ::splice(Channel.Pipe[0], nullptr, hTo, nullptr, Channel.Pending, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                    if (Count == -1) {
+                        if (errno == EAGAIN)
+                            return;
+                        throw EOSError(errno, _T("splice() to socket failed: "));
+                    }
+                    Channel.Pending -= Count;
+                    continue;
+                }
+
+                if (Channel.Eof)
+                    return;
+
+                const auto Count = ::splice(hFrom, nullptr, Channel.Pipe[1], nullptr, HTTP_TUNNEL_SPLICE_SIZE, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+                if (Count == -1) {
+                    if (errno == EAGAIN)
+                        return;
+                    throw EOSError(errno, _T("splice() from socket failed: "));
+                }
+
+                if (Count == 0) {
+                    Channel.Eof = true;
+                } else {
+                    Channel.Pending += Count;
+                    Channel.Bytes += Count;
+                }
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPProxy::ClosePipes() {
+            for (auto &Channel : m_Channels) {
+                for (auto &Pipe : Channel.Pipe) {
+                    if (Pipe != -1) {
+                        ::close(Pipe);
+                        Pipe = -1;
+                    }
+                }
+                Channel.Pending = 0;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPProxy::StartTunnel(CHTTPClientConnection *AConnection) {
+            m_pProxyConnection = AConnection;
+            m_Tunnelling = true;
+
+            if (m_pConnection->Request().Method == "CONNECT") {
+                constexpr char Reply[] = "HTTP/1.1 200 Connection established\r\n\r\n";
+                m_pConnection->OutputBuffer().WriteBuffer(Reply, sizeof(Reply) - 1);
+
+                // Without a Content-Length the parser takes the client's first tunnel bytes for a body.
+                const auto &Content = m_pConnection->Request().Content;
+                if (!Content.IsEmpty()) {
+                    AConnection->OutputBuffer().WriteBuffer(Content.Data(), Content.Size());
+                    m_Channels[0].Bytes += Content.Size();
+                }
+            }
+
+            // Bytes move between the sockets inside the kernel unless one side has to be decrypted.
+            m_Splice = !AConnection->UsedSSL() && !m_pConnection->UsedSSL();
+
+            if (m_Splice) {
+                for (auto &Channel : m_Channels) {
+                    if (::pipe2(Channel.Pipe, O_NONBLOCK | O_CLOEXEC) == -1) {
+                        m_Splice = false;
+                        ClosePipes();
+                        break;
+                    }
+                }
+            }
+
+            /*
+             * Bytes read along with the handshake are already in the input buffers, out of reach of splice().
+             * Queue them for the other side first; both Relay() and Splice() send queued output before anything new.
+             */
+            CTCPConnection *Peers[2][2] = {
+                { m_pConnection, AConnection },
+                { AConnection, m_pConnection }
+            };
+
+            for (int i = 0; i < 2; i++) {
+                auto &Input = Peers[i][0]->InputBuffer();
+                const auto Count = Input.Size();
+                if (Count > 0) {
+                    Peers[i][1]->OutputBuffer().WriteBuffer(Input.Memory(), Count);
+                    Input.Remove(Count);
+                    m_Channels[i].Bytes += Count;
+                }
+            }
+
+            // A tunnel lives as long as its peers keep it open.
+            AConnection->TimeOut(INFINITE);
+            m_pConnection->TimeOut(INFINITE);
+
+            const auto pHandler = m_pConnection->EventHandler();
+#if defined(_GLIBCXX_RELEASE) && (_GLIBCXX_RELEASE >= 9)
+            pHandler->OnReadEvent([this](auto && AHandler) { DoTunnel(AHandler); });
+            pHandler->OnWriteEvent([this](auto && AHandler) { DoTunnel(AHandler); });
+#else
+            pHandler->OnReadEvent(std::bind(&CHTTPProxy::DoTunnel, this, _1));
+            pHandler->OnWriteEvent(std::bind(&CHTTPProxy::DoTunnel, this, _1));
+#endif
+            DoTunnel(pHandler);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPProxy::CloseTunnel() {
+            const auto pUpstream = m_Connections.Contains(m_pProxyConnection) ? m_pProxyConnection : nullptr;
+            const auto pDownstream = m_pConnection;
+
+            m_Tunnelling = false;
+            ClosePipes();
+
+            // Either disconnect may end up freeing this proxy.
+            if (pUpstream != nullptr)
+                pUpstream->Disconnect();
+            pDownstream->Disconnect();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHTTPProxy::DoTunnel(CPollEventHandler *) {
+            if (!m_Connections.Contains(m_pProxyConnection)) {
+                CloseTunnel();
+                return;
+            }
+
+            try {
+                CTCPConnection *Peers[2][2] = {
+                    { m_pConnection, m_pProxyConnection },
+                    { m_pProxyConnection, m_pConnection }
+                };
+
+                for (int i = 0; i < 2; i++) {
+                    auto &Channel = m_Channels[i];
+
+                    if (m_Splice) {
+                        Splice(Peers[i][0], Peers[i][1], Channel);
+                    } else {
+                        Relay(Peers[i][0], Peers[i][1], Channel);
+                    }
+
+                    // Pass a half-close on once everything read before it has been delivered.
+                    if (Channel.Eof && Channel.Pending == 0 && !Channel.Shutdown) {
+                        ::shutdown(Peers[i][1]->Socket()->Binding()->Handle(), SHUT_WR);
+                        Channel.Shutdown = true;
+                    }
+                }
+
+                if (m_Channels[0].Shutdown && m_Channels[1].Shutdown)
+                    CloseTunnel();
+            } catch (Delphi::Exception::Exception &E) {
+                DoException(m_pProxyConnection, E);
+                CloseTunnel();
+            }
+        }
 
         //--------------------------------------------------------------------------------------------------------------
 
@@ -231,144 +231,34 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
-        CStringHash::CStringHash(size_t Size): CObject() {
-            m_BucketSize = Size;
-            m_Buckets = new CList* [Size];
-            for (size_t I = 0; I < Size; ++I)
-                m_Buckets[I] = new CList();
-        }
-        //--------------------------------------------------------------------------------------------------------------
-
-        CStringHash::~CStringHash() {
-            Clear();
-            for (size_t I = 0; I < m_BucketSize; ++I) {
-                FreeAndNil(m_Buckets[I]);
-            }
-            delete [] m_Buckets;
-        }
-        //--------------------------------------------------------------------------------------------------------------
-
-        int CStringHash::Find(const CString &Key, CHashItem* &AItem) {
-            int Hash, pos = 0;
-            CHashItem *Item;
-            Hash = HashOf(Key) % (unsigned) m_BucketSize;
-            if (m_Buckets[Hash] != nullptr) {
-                while (pos < m_Buckets[Hash]->Count()) {
-                    Item = (CHashItem *) m_Buckets[Hash]->Items(pos);
-                    if (Item->Key == Key) {
-                        AItem = Item;
-                        return pos;
-                    }
-                    pos++;
-                }
-            }
-            return -1;
-        }
-        //-------------------------------------------------------------------------------------------------------------
-
-        int CStringHash::Find(LPCTSTR Key, CHashItem* &AItem) {
-            int Hash, pos = 0;
-            CHashItem *Item;
-            Hash = HashOf(Key) % (unsigned) m_BucketSize;
-            if (m_Buckets[Hash] != nullptr) {
-                while (pos < m_Buckets[Hash]->Count()) {
-                    Item = (CHashItem *) m_Buckets[Hash]->Items(pos);
-                    if (Item->Key == Key) {
-                        AItem = Item;
-                        return pos;
-                    }
-                    pos++;
-                }
-            }
-            return -1;
-        }
-        //-------------------------------------------------------------------------------------------------------------
-
-        unsigned CStringHash::HashOf(const CString &Key) {
-            unsigned Result = 0;
-            for (size_t I = 0; I < Key.Length(); ++I)
-                Result = ((Result << 2) | (Result >> (sizeof(Result) * 8 - 2))) ^ Key[I];
-            return Result;
-        }
-        //--------------------------------------------------------------------------------------------------------------
-
-        unsigned CStringHash::HashOf(LPCTSTR Key) {
-            unsigned Result = 0;
-            size_t Length;
-            chVERIFY(SUCCEEDED(StringCchLength(Key, _INT_T_LEN, &Length)));
-            for (size_t I = 0; I < Length; ++I)
-                Result = ((Result << 2) | (Result >> (sizeof(Result) * 8 - 2))) ^ Key[I];
-            return Result;
-        }
-        //--------------------------------------------------------------------------------------------------------------
-
         void CStringHash::Add(const CString &Key, int Value) {
-            int Hash;
-            CHashItem *Item;
-            Hash = HashOf(Key) % (unsigned) m_BucketSize;
-            Item = new CHashItem;
-            Item->Key = Key;
-            Item->Value = Value;
-            m_Buckets[Hash]->Add(Item);
+            if (!Key.IsEmpty())
+                inherited::Add(Key, Value);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CStringHash::Add(LPCTSTR Key, int Value) {
-            int Hash;
-            CHashItem *Item;
-            Hash = HashOf(Key) % (unsigned) m_BucketSize;
-            Item = new CHashItem;
-            Item->Key = Key;
-            Item->Value = Value;
-            m_Buckets[Hash]->Add(Item);
-        }
-        //--------------------------------------------------------------------------------------------------------------
-
-        void CStringHash::ClearList(CList *List) {
-            for (int I = List->Count() - 1; I >= 0; --I) {
-                delete (CHashItem *) List->Items(I);
-            }
-            List->Clear();
-        }
-        //--------------------------------------------------------------------------------------------------------------
-
-        void CStringHash::Clear() {
-            for (size_t I = 0; I < m_BucketSize; ++I) {
-                ClearList(m_Buckets[I]);
-            }
+            if (Key != nullptr && *Key != '\0')
+                inherited::Add(Key, strlen(Key), Value);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CStringHash::Remove(const CString &Key) {
-            int Hash, Pos;
-            CHashItem *Item = nullptr;
-            Pos = Find(Key, Item);
-            if (Pos >= 0) {
-                Hash = HashOf(Key) % (unsigned) m_BucketSize;
-                m_Buckets[Hash]->Delete(Pos);
-            }
+            if (!Key.IsEmpty())
+                inherited::Remove(Key);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CStringHash::Remove(LPCTSTR Key) {
-            int Hash, Pos;
-            CHashItem *Item = nullptr;
-            Pos = Find(Key, Item);
-            if (Pos >= 0) {
-                Hash = HashOf(Key) % (unsigned) m_BucketSize;
-                m_Buckets[Hash]->Delete(Pos);
-            }
+            if (Key != nullptr && *Key != '\0')
+                inherited::Remove(Key);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         bool CStringHash::Modify(const CString &Key, int Value) {
-            int Hash, Pos;
-            CHashItem *Item;
-            Pos = Find(Key, Item);
-            if (Pos >= 0) {
-                Hash = HashOf(Key) % (unsigned) m_BucketSize;
-                Item->Value = Value;
-                m_Buckets[Hash]->Items(Pos, Item);
+            const auto Item = Key.IsEmpty() ? nullptr : Find(Key);
+            if (Item != nullptr) {
+                *Item = Value;
                 return true;
             }
             return false;
@@ -376,36 +266,24 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         bool CStringHash::Modify(LPCTSTR Key, int Value) {
-            int Hash, Pos;
-            CHashItem *Item;
-            Pos = Find(Key, Item);
-            if (Pos >= 0) {
-                Hash = HashOf(Key) % (unsigned) m_BucketSize;
-                Item->Value = Value;
-                m_Buckets[Hash]->Items(Pos, Item);
+            const auto Item = (Key == nullptr || *Key == '\0') ? nullptr : Find(Key);
+            if (Item != nullptr) {
+                *Item = Value;
                 return true;
             }
             return false;
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        int CStringHash::ValueOf(const CString &Key) {
-            int Pos;
-            CHashItem *Item;
-            Pos = Find(Key, Item);
-            if (Pos >= 0)
-                return Item->Value;
-            return -1;
+        int CStringHash::ValueOf(const CString &Key) const {
+            const auto Item = Key.IsEmpty() ? nullptr : Find(Key);
+            return Item == nullptr ? -1 : *Item;
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        int CStringHash::ValueOf(LPCTSTR Key) {
-            int Pos;
-            CHashItem *Item;
-            Pos = Find(Key, Item);
-            if (Pos >= 0)
-                return Item->Value;
-            return -1;
+        int CStringHash::ValueOf(LPCTSTR Key) const {
+            const auto Item = (Key == nullptr || *Key == '\0') ? nullptr : Find(Key);
+            return Item == nullptr ? -1 : *Item;
         }
 
         //--------------------------------------------------------------------------------------------------------------
@@ -425,35 +303,29 @@ namespace Delphi {
                 return;
 
             if (m_ValueHash == nullptr)
-                m_ValueHash = CStringHash::Create();
+                m_ValueHash = CStringHash::Create(Count());
             else
                 m_ValueHash->Clear();
 
             for (int I = 0; I < Count(); ++I)
-                m_ValueHash->Add(CStringList::Strings(I), I);
+                m_ValueHash->Add(Get(I), I);
 
             m_ValueHashValid = true;
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CHashedStringList::UpdateNameHash() const {
-            size_t P;
-
             if (m_NameHashValid)
                 return;
 
+            // Names compare ignoring case, as in CStrings::IndexOfName()
             if (m_NameHash == nullptr)
-                m_NameHash = CStringHash::Create();
+                m_NameHash = CStringHash::Create(Count(), false);
             else
                 m_NameHash->Clear();
 
-            for (int I = 0; I < Count(); ++I) {
-                const CString &Key = Get(I);
-                P = Key.Find(NameValueSeparator());
-                if (P != CString::npos) {
-                    m_NameHash->Add(Key.SubString(0, P), I);
-                }
-            }
+            for (int I = 0; I < Count(); ++I)
+                m_NameHash->Add(Names(I), I);
 
             m_NameHashValid = true;
         }
@@ -465,6 +337,47 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CHashedStringList::InsertItem(int Index, CStringItem &&Item) {
+            const bool Append = Index == Count();
+
+            inherited::InsertItem(Index, std::move(Item));
+
+            // Appends keep the stored indexes valid, so the hashes follow them instead of being rebuilt
+            if (Append) {
+                if (m_ValueHashValid)
+                    m_ValueHash->Add(Get(Index), Index);
+                if (m_NameHashValid)
+                    m_NameHash->Add(Names(Index), Index);
+            } else {
+                Changed();
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHashedStringList::Put(int Index, const CString &S) {
+            inherited::Put(Index, S);
+            Changed();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHashedStringList::Put(int Index, LPCTSTR Str) {
+            inherited::Put(Index, Str);
+            Changed();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHashedStringList::Clear() {
+            inherited::Clear();
+            Changed();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CHashedStringList::Delete(int Index) {
+            inherited::Delete(Index);
+            Changed();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         int CHashedStringList::IndexOf(const CString &S) const {
             UpdateValueHash();
             return m_ValueHash->ValueOf(S);
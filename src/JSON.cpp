@@ -24,6 +24,10 @@ Author:
 #include "delphi.hpp"
 #include "delphi/JSON.hpp"
 
+#if defined(__SSE2__) && !defined(_UNICODE)
+#include <emmintrin.h>
+#endif
+
 #define JSON_INVALID_VALUE_TYPE "Invalid JSON value type."
 
 extern "C++" {
@@ -32,32 +36,134 @@ namespace Delphi {
 
     namespace Json {
 
-        CString EncodeJsonString(const CString &String) {
-            CString Result;
-
-            for (size_t i = 0; i < String.Size(); i++) {
-                const auto ch = String.at(i);
-                switch (ch) {
+        size_t JsonEscapeScan(LPCTSTR Str, size_t Length) {
+            size_t Index = 0;
+#if defined(__SSE2__) && !defined(_UNICODE)
+            const __m128i CarriageReturn = _mm_set1_epi8('\r');
+            const __m128i LineFeed = _mm_set1_epi8('\n');
+            const __m128i Tab = _mm_set1_epi8('\t');
+            const __m128i Quote = _mm_set1_epi8('"');
+            const __m128i Slash = _mm_set1_epi8('/');
+            const __m128i BackSlash = _mm_set1_epi8('\\');
+
+            while (Index + 16 <= Length) {
+                const __m128i Chunk = _mm_loadu_si128((const __m128i *) (Str + Index));
+
+                __m128i Mask = _mm_or_si128(_mm_cmpeq_epi8(Chunk, CarriageReturn), _mm_cmpeq_epi8(Chunk, LineFeed));
+                Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, Tab));
+                Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, Quote));
+                Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, Slash));
+                Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, BackSlash));
+
+                const auto Bits = (unsigned) _mm_movemask_epi8(Mask);
+                if (Bits != 0)
+                    return Index + __builtin_ctz(Bits);
+
+                Index += 16;
+            }
+#endif
+            for (; Index < Length; Index++) {
+                switch (Str[Index]) {
                     case '\r':
-                        Result.Append("\\r");
-                        break;
                     case '\n':
-                        Result.Append("\\n");
-                        break;
                     case '\t':
-                        Result.Append("\\t");
-                        break;
                     case '"':
                     case '/':
                     case '\\':
-                        Result.Append("\\");
-                        Result.Append(ch);
+                        return Index;
+                    default:
                         break;
+                }
+            }
+
+            return Length;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        size_t JsonStringScan(LPCTSTR Str, size_t Length) {
+            size_t Index = 0;
+#if defined(__SSE2__) && !defined(_UNICODE)
+            const __m128i Quote = _mm_set1_epi8('"');
+            const __m128i BackSlash = _mm_set1_epi8('\\');
+            const __m128i Control = _mm_set1_epi8(0x1F);
+
+            while (Index + 16 <= Length) {
+                const __m128i Chunk = _mm_loadu_si128((const __m128i *) (Str + Index));
+
+                __m128i Mask = _mm_or_si128(_mm_cmpeq_epi8(Chunk, Quote), _mm_cmpeq_epi8(Chunk, BackSlash));
+                // Unsigned Chunk <= 0x1F
+                Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(_mm_max_epu8(Chunk, Control), Control));
+
+                const auto Bits = (unsigned) _mm_movemask_epi8(Mask);
+                if (Bits != 0)
+                    return Index + __builtin_ctz(Bits);
+
+                Index += 16;
+            }
+#endif
+            for (; Index < Length; Index++) {
+                const auto C = (unsigned) Str[Index];
+                if (C == '"' || C == '\\' || C < 0x20)
+                    return Index;
+            }
+
+            return Length;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        size_t JsonStructuralScan(LPCTSTR Str, size_t Length) {
+            size_t Index = 0;
+#if defined(__SSE2__) && !defined(_UNICODE)
+            const __m128i Quote = _mm_set1_epi8('"');
+            const __m128i LeftBrace = _mm_set1_epi8('{');
+            const __m128i RightBrace = _mm_set1_epi8('}');
+            const __m128i LeftBracket = _mm_set1_epi8('[');
+            const __m128i RightBracket = _mm_set1_epi8(']');
+
+            while (Index + 16 <= Length) {
+                const __m128i Chunk = _mm_loadu_si128((const __m128i *) (Str + Index));
+
+                __m128i Mask = _mm_or_si128(_mm_cmpeq_epi8(Chunk, Quote), _mm_cmpeq_epi8(Chunk, LeftBrace));
+                Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, RightBrace));
+                Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, LeftBracket));
+                Mask = _mm_or_si128(Mask, _mm_cmpeq_epi8(Chunk, RightBracket));
+
+                const auto Bits = (unsigned) _mm_movemask_epi8(Mask);
+                if (Bits != 0)
+                    return Index + __builtin_ctz(Bits);
+
+                Index += 16;
+            }
+#endif
+            for (; Index < Length; Index++) {
+                switch (Str[Index]) {
+                    case '"':
+                    case '{':
+                    case '}':
+                    case '[':
+                    case ']':
+                        return Index;
                     default:
-                        Result.Append(ch);
                         break;
                 }
             }
+
+            return Length;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CString EncodeJsonString(const CString &String) {
+            const size_t Length = String.Length();
+
+            size_t Index = JsonEscapeScan(String.Data(), Length);
+            if (Index == Length)
+                return String;
+
+            CString Result;
+            CJSONWriter Writer(Result);
+            Writer.WriteEncoded(String.Data(), Length);
+            Writer.Flush();
+
             return Result;
         }
         //--------------------------------------------------------------------------------------------------------------
@@ -195,6 +301,26 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CJSON::MoveFrom(CJSON &Source) noexcept {
+            if (m_Value != this)
+                delete m_Value;
+
+            m_ValueType = Source.m_ValueType;
+
+            // A scalar points at itself; an object or array changes hands together with its owner link
+            if (Source.m_Value == &Source) {
+                m_Value = this;
+            } else {
+                m_Value = Source.m_Value;
+                if (m_Value != nullptr)
+                    m_Value->SetOwner(this);
+            }
+
+            Source.m_Value = nullptr;
+            Source.m_ValueType = jvtNull;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         void CJSON::Concat(const CJSON& Source) {
             if (Assigned(Source.Value()) && (ValueType() == Source.Value()->ValueType())) {
                 if (Source.Value()->IsObject())
@@ -276,43 +402,25 @@ namespace Delphi {
 
         CString CJSON::JsonToString() const {
             CString S;
+            CJSONWriter Writer(S);
+            Writer.WriteJson(*this);
+            Writer.Flush();
+            return S;
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
-            if (ValueType() == jvtObject) {
-                S = "{";
-
-                for (int i = 0; i < Count(); i++) {
-
-                    if (i > 0) {
-                        S += ", ";
-                    }
-
-                    S += "\"";
-                    S += Members(i).String();
-                    S += "\": ";
-
-                    S << Object()[i].ToString();
-                }
-
-                S += "}";
-            }
-
-            if (IsArray()) {
-
-                S = "[";
-
-                for (int i = 0; i < Count(); i++) {
-
-                    if (i > 0) {
-                        S += ", ";
-                    }
-
-                    S << Array()[i].ToString();
-                }
-
-                S += "]";
+        void CJSON::JsonToWriter(CJSONWriter &Writer) const {
+            if (IsObject()) {
+                if (Assigned(m_Value))
+                    Writer.WriteJson(*m_Value);
+                else
+                    Writer.Write("{}", 2);
+            } else if (IsArray()) {
+                if (Assigned(m_Value))
+                    Writer.WriteJson(*m_Value);
+                else
+                    Writer.Write("[]", 2);
             }
-
-            return S;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -336,16 +444,25 @@ namespace Delphi {
 
         void CJSON::StrToJson(LPCTSTR ABuffer, size_t ASize) {
 
-            CJSONParser pParser(this);
             CJSONParserResult R;
 
             BeginUpdate();
             try {
                 if (Assigned(ABuffer)) {
                     Clear();
-                    R = pParser.Parse((LPTSTR) ABuffer, ABuffer + ASize);
-                    if (!R.result) {
-                        throw Exception::EJSONParseSyntaxError(_T("JSON Parser syntax error in position %d, char: %#x"), R.pos, ABuffer[R.pos]);
+
+                    CJSONReader Reader(ABuffer, ASize);
+                    CJSONBuilder Builder(this);
+
+                    if (!Reader.Parse(Builder)) {
+                        // Not strict JSON: fall back to the lenient character parser
+                        Clear();
+
+                        CJSONParser pParser(this);
+                        R = pParser.Parse((LPTSTR) ABuffer, ABuffer + ASize);
+                        if (!R.result) {
+                            throw Exception::EJSONParseSyntaxError(_T("JSON Parser syntax error in position %d, char: %#x"), R.pos, ABuffer[R.pos]);
+                        }
                     }
                 }
             } catch (...) {
@@ -399,8 +516,9 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSON::SaveToStream(CStream &Stream) const {
-            const CString& S = JsonToString();
-            Stream.WriteBuffer(S.Data(), S.Size());
+            CJSONWriter Writer(Stream);
+            Writer.WriteJson(*this);
+            Writer.Flush();
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -654,22 +772,18 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        CString CJSONElements::JsonToString() const {
-            CString S;
-
-            S += "[";
+        void CJSONElements::JsonToWriter(CJSONWriter &Writer) const {
+            Writer.Write('[');
 
             for (int i = 0; i < Count(); i++) {
                 if (i > 0) {
-                    S += ", ";
+                    Writer.Write(", ", 2);
                 }
 
-                S << Values(i).ToString();
+                Writer.WriteJson(Values(i));
             }
 
-            S += "]";
-
-            return S;
+            Writer.Write(']');
         }
 
         //--------------------------------------------------------------------------------------------------------------
@@ -755,27 +869,25 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        CString CJSONMembers::JsonToString() const {
-            CString S;
-
-            S = "{";
+        void CJSONMembers::JsonToWriter(CJSONWriter &Writer) const {
+            Writer.Write('{');
 
             for (int i = 0; i < Count(); i++) {
 
                 if (i > 0) {
-                    S += ", ";
+                    Writer.Write(", ", 2);
                 }
 
-                S += "\"";
-                S += Members(i).String();
-                S += "\": ";
+                const auto &Member = Members(i);
 
-                S << Members(i).Value().ToString();
-            }
+                Writer.Write('"');
+                Writer.Write(Member.String().Data(), Member.String().Length());
+                Writer.Write("\": ", 3);
 
-            S += "}";
+                Writer.WriteJson(Member.Value());
+            }
 
-            return S;
+            Writer.Write('}');
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -1031,8 +1143,9 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONMembers::IndexOfString(const CString &String) const {
+            // Compare() takes the name by reference; operator== would copy it for every member
             for (int I = 0; I < GetCount(); ++I) {
-                if (Get(I).String() == String)
+                if (Get(I).String().Compare(String) == 0)
                     return I;
             }
 
@@ -1241,43 +1354,46 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        CString CJSONValue::JsonToString() const {
-            CString S;
-
+        void CJSONValue::JsonToWriter(CJSONWriter &Writer) const {
             switch (ValueType()) {
                 case jvtObject:
-                    S = AsObject().ToString();
+                    if (Assigned(m_Value))
+                        Writer.WriteJson(AsObject());
+                    else
+                        Writer.Write("{}", 2);
                     break;
 
                 case jvtArray:
-                    S = AsArray().ToString();
+                    if (Assigned(m_Value))
+                        Writer.WriteJson(AsArray());
+                    else
+                        Writer.Write("[]", 2);
                     break;
 
                 case jvtString:
-                    S = "\"";
-                    S += Data();
-                    S += "\"";
+                    Writer.Write('"');
+                    Writer.Write(m_Data.Data(), m_Data.Length());
+                    Writer.Write('"');
                     break;
 
                 case jvtNumber:
-                    S = Data();
+                    Writer.Write(m_Data.Data(), m_Data.Length());
                     break;
 
                 case jvtBoolean:
                     if (AsBoolean()) {
-                        S = "true";
+                        Writer.Write("true", 4);
                     } else {
-                        S = "false";
+                        Writer.Write("false", 5);
                     }
                     break;
 
                 case jvtNull:
-                    S = "null";
+                    Writer.Write("null", 4);
                     break;
             }
-
-            return S;
         }
+        //--------------------------------------------------------------------------------------------------------------
 
         bool CJSONValue::HasOwnProperty(const CString &String) const {
             if (Assigned(m_Value)) {
@@ -1471,7 +1587,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         CJSONObject::CJSONObject(CPersistent *AOwner): CJSONMembers(AOwner, jvtObject) {
-
+            m_pIndex = nullptr;
+            m_IndexValid = false;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -1480,6 +1597,111 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CJSONObject::UpdateIndex() const {
+            if (m_IndexValid)
+                return;
+
+            const auto Count = (size_t) GetCount();
+
+            if (m_pIndex == nullptr) {
+                m_pIndex = CStringHash::Create(Count);
+            } else {
+                m_pIndex->Clear();
+            }
+
+            // Empty names never match (see CString::Compare), so they are not indexed
+            for (int I = 0; I < (int) Count; ++I) {
+                const CString &Name = m_pList[I].String();
+                if (!Name.IsEmpty())
+                    m_pIndex->Add(Name, I);
+            }
+
+            m_IndexValid = true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CJSONObject::IndexInserted(int Index) {
+            if (m_IndexValid) {
+                // Only appends keep the stored positions valid
+                if (Index == GetCount() - 1) {
+                    const CString &Name = m_pList[Index].String();
+                    if (!Name.IsEmpty())
+                        m_pIndex->Add(Name, Index);
+                } else {
+                    m_IndexValid = false;
+                }
+            }
+
+            return Index;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONObject::IndexDeleting(int Index) {
+            if (m_IndexValid) {
+                if (Index != GetCount() - 1) {
+                    m_IndexValid = false;
+                    return;
+                }
+
+                const CString &Name = m_pList[Index].String();
+                if (Name.IsEmpty())
+                    return;
+
+                if (m_pIndex->ValueOf(Name) == Index)
+                    m_pIndex->Remove(Name);
+                else
+                    m_IndexValid = false;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONObject::IndexRenaming(int Index, const CString &String) {
+            if (m_IndexValid) {
+                const CString &Name = m_pList[Index].String();
+
+                if (!Name.IsEmpty()) {
+                    if (Name == String)
+                        return;
+
+                    if (m_pIndex->ValueOf(Name) != Index) {
+                        m_IndexValid = false;
+                        return;
+                    }
+                }
+
+                // Keep the first occurrence rule simple: renaming onto an existing name rebuilds the index
+                if (!String.IsEmpty() && m_pIndex->ValueOf(String) != -1) {
+                    m_IndexValid = false;
+                    return;
+                }
+
+                if (!Name.IsEmpty())
+                    m_pIndex->Remove(Name);
+
+                if (!String.IsEmpty())
+                    m_pIndex->Add(String, Index);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CJSONObject::IndexOfString(const CString &Value) const {
+            if (GetCount() < JSON_OBJECT_INDEX_THRESHOLD)
+                return inherited::IndexOfString(Value);
+
+            UpdateIndex();
+            return m_pIndex->ValueOf(Value);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CJSONObject::IndexOfString(reference Value) const {
+            if (GetCount() < JSON_OBJECT_INDEX_THRESHOLD)
+                return inherited::IndexOfString(Value);
+
+            UpdateIndex();
+            return m_pIndex->ValueOf(Value);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         const CString &CJSONObject::GetString(int Index) const {
             if ((Index < 0) || (Index >= GetCount()))
                 throw ExceptionFrm(SListIndexError, Index);
@@ -1548,200 +1770,228 @@ namespace Delphi {
             if ((Index < 0) || (Index >= GetCount()))
                 throw ExceptionFrm(SListIndexError, Index);
 
+            IndexRenaming(Index, Value.String());
+
             m_pList[Index] = Value;
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CJSONObject::PutPair(int Index, const CString &String, const CJSONValue &Value) {
+            Put(Index, CJSONMember(String, Value));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONObject::PutPair(int Index, reference String, const CJSONValue &Value) {
+            Put(Index, CJSONMember(String, Value));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         int CJSONObject::Add(const CJSONMember &Value) {
-            return m_pList.Add(Value);
+            return IndexInserted(m_pList.Add(Value));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(const CString& String, const CJSONMembers &Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(reference String, const CJSONMembers &Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(const CString& String, const CJSONElements &Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(reference String, const CJSONElements &Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(const CString& String, const CJSONValue &Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(reference String, const CJSONValue &Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(const CString& String, const CString &Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(reference String, reference Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(reference String, const CString &Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(const CString &String, bool Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(CJSONObject::reference String, bool Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(const CString &String, int Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(reference String, int Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(const CString &String, float Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(reference String, float Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(const CString &String, double Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         int CJSONObject::AddPair(reference String, double Value) {
-            return m_pList.Add(CJSONMember(String, Value));
+            return IndexInserted(m_pList.Add(CJSONMember(String, Value)));
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::Insert(int Index, const CJSONMember &Value) {
-            return m_pList.Insert(Index, Value);
+            m_pList.Insert(Index, Value);
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, const CString &String, const CJSONMembers &Value) {
             m_pList.Insert(Index, CJSONMember(Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, reference String, const CJSONMembers &Value) {
             m_pList.Insert(Index, CJSONMember(Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, const CString &String, const CJSONElements &Value) {
             m_pList.Insert(Index, CJSONMember(Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, reference String, const CJSONElements &Value) {
             m_pList.Insert(Index, CJSONMember(Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, const CString &String, const CJSONValue &Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, reference String, const CJSONValue &Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, const CString &String, const CString &Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, reference String, const CString &Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, const CString &String, reference Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, reference String, reference Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, const CString &String, bool Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, reference String, bool Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, const CString &String, int Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, reference String, int Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, const CString &String, float Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, reference String, float Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, const CString &String, double Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::InsertPair(int Index, reference String, double Value) {
             m_pList.Insert(Index, CJSONMember(String, Value));
+            IndexInserted(Index);
         }
         //--------------------------------------------------------------------------------------------------------------
 
         bool CJSONObject::HasOwnProperty(const CString &String) const {
-            int Index = 0;
-            while (Index < GetCount() && Get(Index).String() != String)
-                Index++;
-            return Index != GetCount();
+            return IndexOfString(String) != -1;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -1762,20 +2012,1123 @@ namespace Delphi {
 
         void CJSONObject::Clear() {
             m_pList.Clear();
+
+            delete m_pIndex;
+            m_pIndex = nullptr;
+            m_IndexValid = false;
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::Update(int Index) {
+            if ((Index < 0) || (Index >= GetCount()))
+                throw ExceptionFrm(SListIndexError, Index);
 
+            // The previous name is gone, so the stored positions can not be patched
+            m_IndexValid = false;
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CJSONObject::Delete(int Index) {
+            IndexDeleting(Index);
             m_pList.Delete(Index);
         }
 
         //--------------------------------------------------------------------------------------------------------------
 
+        //-- CJSONWriter -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONWriter::CJSONWriter(CStream &Stream): CObject() {
+            m_pStream = &Stream;
+            m_pString = nullptr;
+            m_Length = 0;
+            m_Written = 0;
+            m_Depth = 0;
+            m_AfterName = false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONWriter::CJSONWriter(CString &String): CObject() {
+            m_pStream = nullptr;
+            m_pString = &String;
+            m_Length = 0;
+            m_Written = 0;
+            m_Depth = 0;
+            m_AfterName = false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONWriter::~CJSONWriter() {
+            try {
+                Flush();
+            } catch (...) {
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Flush() {
+            if (m_Length == 0)
+                return;
+
+            if (Assigned(m_pString)) {
+                m_pString->Append(m_Buffer, m_Length);
+            } else {
+                m_pStream->WriteBuffer(m_Buffer, m_Length * sizeof(TCHAR));
+            }
+
+            m_Written += m_Length;
+            m_Length = 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Write(LPCTSTR Str, size_t Length) {
+            if (Length == 0)
+                return;
+
+            if (m_Length + Length > JSON_WRITER_BUFFER_SIZE) {
+                Flush();
+
+                if (Length > JSON_WRITER_BUFFER_SIZE) {
+                    if (Assigned(m_pString)) {
+                        m_pString->Append(Str, Length);
+                    } else {
+                        m_pStream->WriteBuffer(Str, Length * sizeof(TCHAR));
+                    }
+                    m_Written += Length;
+                    return;
+                }
+            }
+
+            ::CopyMemory(m_Buffer + m_Length, Str, Length * sizeof(TCHAR));
+            m_Length += Length;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::WriteEncoded(LPCTSTR Str, size_t Length) {
+            size_t Index = 0;
+
+            while (Index < Length) {
+                const size_t Next = Index + JsonEscapeScan(Str + Index, Length - Index);
+
+                Write(Str + Index, Next - Index);
+
+                if (Next == Length)
+                    break;
+
+                const auto ch = Str[Next];
+                switch (ch) {
+                    case '\r':
+                        Write("\\r", 2);
+                        break;
+                    case '\n':
+                        Write("\\n", 2);
+                        break;
+                    case '\t':
+                        Write("\\t", 2);
+                        break;
+                    default:
+                        Write('\\');
+                        Write(ch);
+                        break;
+                }
+
+                Index = Next + 1;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::WriteJson(const CJSON &Json) {
+            Json.JsonToWriter(*this);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Separator() {
+            if (m_Depth == 0)
+                return;
+
+            if (m_AfterName) {
+                m_AfterName = false;
+                return;
+            }
+
+            if (m_First[m_Depth - 1]) {
+                m_First[m_Depth - 1] = false;
+            } else {
+                Write(", ", 2);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Push() {
+            if (m_Depth == JSON_WRITER_MAX_DEPTH)
+                throw ExceptionFrm(_T("JSON writer: nesting depth exceeds %d."), JSON_WRITER_MAX_DEPTH);
+            m_First[m_Depth++] = true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Pop() {
+            if (m_Depth == 0)
+                throw ExceptionFrm(_T("JSON writer: unbalanced end of object or array."));
+            m_Depth--;
+            m_AfterName = false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::BeginObject() {
+            Separator();
+            Write('{');
+            Push();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::EndObject() {
+            Pop();
+            Write('}');
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::BeginArray() {
+            Separator();
+            Write('[');
+            Push();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::EndArray() {
+            Pop();
+            Write(']');
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Name(const CString &String) {
+            Separator();
+            Write('"');
+            WriteEncoded(String.Data(), String.Length());
+            Write("\": ", 3);
+            m_AfterName = true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Name(LPCTSTR String) {
+            Separator();
+            Write('"');
+            WriteEncoded(String, Assigned(String) ? strlen(String) : 0);
+            Write("\": ", 3);
+            m_AfterName = true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Value(const CJSON &Json) {
+            Separator();
+            WriteJson(Json);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Value(const CString &String) {
+            Separator();
+            Write('"');
+            WriteEncoded(String.Data(), String.Length());
+            Write('"');
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Value(LPCTSTR String) {
+            if (String == nullptr)
+                return Null();
+
+            Separator();
+            Write('"');
+            WriteEncoded(String, strlen(String));
+            Write('"');
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Value(int Number) {
+            TCHAR szValue[_INT_T_LEN + 1] = {0};
+            Separator();
+            IntToStr(Number, szValue, _INT_T_LEN);
+            Write(szValue, strlen(szValue));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Value(long int Number) {
+            TCHAR szValue[_INT_T_LEN + 1] = {0};
+            Separator();
+            IntToStr(Number, szValue, _INT_T_LEN);
+            Write(szValue, strlen(szValue));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Value(double Number) {
+            TCHAR szValue[_INT_T_LEN + 1] = {0};
+            Separator();
+            FloatToStr(Number, szValue, _INT_T_LEN);
+            Write(szValue, strlen(szValue));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Value(bool Boolean) {
+            Separator();
+            if (Boolean) {
+                Write("true", 4);
+            } else {
+                Write("false", 5);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONWriter::Null() {
+            Separator();
+            Write("null", 4);
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CJSONReader -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        inline bool JsonIsDigit(TCHAR C) {
+            return C >= '0' && C <= '9';
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONReader::CJSONReader(LPCTSTR ABuffer, size_t ASize) : CObject() {
+            m_Begin = ABuffer;
+            m_End = ABuffer + ASize;
+            m_Stack[0] = 0;
+
+            Reset();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONReader::Reset() {
+            m_Pos = m_Begin;
+            m_Token = jtNone;
+            m_Text = nullptr;
+            m_Length = 0;
+            m_State = rsValue;
+            m_Depth = 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONToken CJSONReader::Error() {
+            m_State = rsError;
+            m_Token = jtError;
+            return m_Token;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONReader::SkipWhiteSpace() {
+            while (m_Pos < m_End && (*m_Pos == ' ' || *m_Pos == '\n' || *m_Pos == '\r' || *m_Pos == '\t'))
+                m_Pos++;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONReader::ScanString() {
+            LPCTSTR P = m_Pos + 1;
+
+            while (P < m_End) {
+                P += JsonStringScan(P, m_End - P);
+                if (P == m_End)
+                    break;
+
+                if (*P == '"') {
+                    m_Text = m_Pos + 1;
+                    m_Length = P - m_Text;
+                    m_Pos = P + 1;
+                    return true;
+                }
+
+                if (*P != '\\')
+                    return false; // Unescaped control character
+
+                if (++P == m_End)
+                    break;
+
+                switch (*P) {
+                    case '"':
+                    case '\\':
+                    case '/':
+                    case 'b':
+                    case 'f':
+                    case 'n':
+                    case 'r':
+                    case 't':
+                        P++;
+                        break;
+                    case 'u':
+                        if (m_End - P < 5)
+                            return false;
+                        for (int i = 1; i <= 4; i++) {
+                            if (!isxdigit((u_char) P[i]))
+                                return false;
+                        }
+                        P += 5;
+                        break;
+                    default:
+                        return false;
+                }
+            }
+
+            return false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONReader::ScanNumber() {
+            LPCTSTR P = m_Pos;
+
+            if (P < m_End && *P == '-')
+                P++;
+
+            if (P == m_End)
+                return false;
+
+            if (*P == '0') {
+                P++;
+            } else if (JsonIsDigit(*P)) {
+                while (P < m_End && JsonIsDigit(*P))
+                    P++;
+            } else {
+                return false;
+            }
+
+            if (P < m_End && *P == '.') {
+                if (++P == m_End || !JsonIsDigit(*P))
+                    return false;
+                while (P < m_End && JsonIsDigit(*P))
+                    P++;
+            }
+
+            if (P < m_End && (*P == 'e' || *P == 'E')) {
+                if (++P < m_End && (*P == '+' || *P == '-'))
+                    P++;
+                if (P == m_End || !JsonIsDigit(*P))
+                    return false;
+                while (P < m_End && JsonIsDigit(*P))
+                    P++;
+            }
+
+            m_Text = m_Pos;
+            m_Length = P - m_Pos;
+            m_Pos = P;
+
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONReader::ScanLiteral(LPCTSTR Literal, size_t Length) {
+            if ((size_t) (m_End - m_Pos) < Length || memcmp(m_Pos, Literal, Length * sizeof(TCHAR)) != 0)
+                return false;
+
+            m_Text = m_Pos;
+            m_Length = Length;
+            m_Pos += Length;
+
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONToken CJSONReader::AfterValue(CJSONToken Token) {
+            m_State = m_Depth == 0 ? rsDone : rsComma;
+            m_Token = Token;
+            return m_Token;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONToken CJSONReader::ReadValue(TCHAR C) {
+            switch (C) {
+                case '{':
+                case '[':
+                    if (m_Depth == JSON_READER_MAX_DEPTH)
+                        return Error();
+
+                    m_Stack[m_Depth++] = C;
+
+                    m_Text = m_Pos++;
+                    m_Length = 1;
+
+                    m_State = C == '{' ? rsFirstName : rsFirstValue;
+                    m_Token = C == '{' ? jtStartObject : jtStartArray;
+
+                    return m_Token;
+
+                case '"':
+                    return ScanString() ? AfterValue(jtString) : Error();
+
+                case 't':
+                    return ScanLiteral(_T("true"), 4) ? AfterValue(jtTrue) : Error();
+
+                case 'f':
+                    return ScanLiteral(_T("false"), 5) ? AfterValue(jtFalse) : Error();
+
+                case 'n':
+                    return ScanLiteral(_T("null"), 4) ? AfterValue(jtNull) : Error();
+
+                default:
+                    return ScanNumber() ? AfterValue(jtNumber) : Error();
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONToken CJSONReader::CloseContainer(TCHAR C) {
+            if (m_Depth == 0)
+                return Error();
+
+            const TCHAR Open = m_Stack[m_Depth - 1];
+            if ((Open == '{' && C != '}') || (Open == '[' && C != ']'))
+                return Error();
+
+            m_Depth--;
+
+            m_Text = m_Pos++;
+            m_Length = 1;
+
+            return AfterValue(C == '}' ? jtEndObject : jtEndArray);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONToken CJSONReader::Next() {
+            if (m_State == rsError)
+                return m_Token;
+
+            SkipWhiteSpace();
+
+            if (m_State == rsDone) {
+                if (m_Pos != m_End)
+                    return Error();
+                m_Token = jtEnd;
+                return m_Token;
+            }
+
+            if (m_Pos == m_End)
+                return Error();
+
+            const TCHAR C = *m_Pos;
+
+            switch (m_State) {
+                case rsComma:
+                    if (C == ',') {
+                        m_Pos++;
+                        m_State = m_Stack[m_Depth - 1] == '{' ? rsName : rsValue;
+                        return Next();
+                    }
+                    return CloseContainer(C);
+
+                case rsFirstName:
+                    if (C == '}')
+                        return CloseContainer(C);
+                    // fall through
+
+                case rsName:
+                    if (C != '"' || !ScanString())
+                        return Error();
+
+                    SkipWhiteSpace();
+                    if (m_Pos == m_End || *m_Pos != ':')
+                        return Error();
+
+                    m_Pos++;
+                    m_State = rsValue;
+                    m_Token = jtName;
+
+                    return m_Token;
+
+                case rsFirstValue:
+                    if (C == ']')
+                        return CloseContainer(C);
+                    return ReadValue(C);
+
+                default:
+                    return ReadValue(C);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONReader::Skip() {
+            if (m_Token == jtName) {
+                Next();
+                if (m_Token != jtStartObject && m_Token != jtStartArray)
+                    return m_Token != jtError;
+            }
+
+            if (m_Token != jtStartObject && m_Token != jtStartArray)
+                return m_Token != jtError;
+
+            // Jump between structural characters only: the skipped value is balanced, not validated
+            int Level = 1;
+            LPCTSTR P = m_Pos;
+
+            while (P < m_End) {
+                P += JsonStructuralScan(P, m_End - P);
+                if (P == m_End)
+                    break;
+
+                switch (*P) {
+                    case '"':
+                        m_Pos = P;
+                        if (!ScanString()) {
+                            Error();
+                            return false;
+                        }
+                        P = m_Pos;
+                        continue;
+
+                    case '{':
+                    case '[':
+                        Level++;
+                        break;
+
+                    default:
+                        if (--Level == 0) {
+                            m_Pos = P;
+                            return CloseContainer(*P) != jtError;
+                        }
+                        break;
+                }
+
+                P++;
+            }
+
+            m_Pos = m_End;
+            Error();
+
+            return false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONReader::Find(LPCTSTR Name, size_t Length) {
+            while (Next() == jtName) {
+                if (m_Length == Length && memcmp(m_Text, Name, Length * sizeof(TCHAR)) == 0)
+                    return true;
+                if (!Skip())
+                    return false;
+            }
+
+            return false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONReader::Validate() {
+            while (m_Token != jtEnd && m_Token != jtError)
+                Next();
+
+            return m_Token == jtEnd;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONReader::Parse(CJSONHandler &Handler) {
+            bool Continue = true;
+
+            while (Continue) {
+                switch (Next()) {
+                    case jtStartObject:
+                        Continue = Handler.OnStartObject();
+                        break;
+                    case jtEndObject:
+                        Continue = Handler.OnEndObject();
+                        break;
+                    case jtStartArray:
+                        Continue = Handler.OnStartArray();
+                        break;
+                    case jtEndArray:
+                        Continue = Handler.OnEndArray();
+                        break;
+                    case jtName:
+                        Continue = Handler.OnName(m_Text, m_Length);
+                        break;
+                    case jtString:
+                        Continue = Handler.OnString(m_Text, m_Length);
+                        break;
+                    case jtNumber:
+                        Continue = Handler.OnNumber(m_Text, m_Length);
+                        break;
+                    case jtTrue:
+                        Continue = Handler.OnBoolean(true);
+                        break;
+                    case jtFalse:
+                        Continue = Handler.OnBoolean(false);
+                        break;
+                    case jtNull:
+                        Continue = Handler.OnNull();
+                        break;
+                    case jtEnd:
+                        return true;
+                    default:
+                        return false;
+                }
+            }
+
+            return false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CString CJSONReader::AsString() const {
+            CString Result;
+
+            if (m_Length != 0) {
+                Result.Create(m_Text, m_Length);
+                if (m_Token == jtString || m_Token == jtName)
+                    return DecodeJsonString(Result);
+            }
+
+            return Result;
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CJSONBuilder ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONBuilder::CJSONBuilder(CJSON *Json) : CJSONHandler() {
+            m_Json = Json;
+            m_pJsonList = new CList();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONBuilder::~CJSONBuilder() {
+            delete m_pJsonList;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSON &CJSONBuilder::CurrentJson() {
+            return *(CJSON *) m_pJsonList->Last();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONObject &CJSONBuilder::CurrentObject() {
+            return dynamic_cast<CJSONObject &> (CurrentJson());
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONArray &CJSONBuilder::CurrentArray() {
+            return dynamic_cast<CJSONArray &> (CurrentJson());
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONBuilder::AddContainer(CJSONValueType ValueType) {
+            CJSON *Json;
+
+            if (m_pJsonList->Count() == 0) {
+                Json = m_Json;
+            } else if (CurrentJson().IsObject()) {
+                Json = &CurrentObject().Last().Value();
+            } else {
+                CurrentArray().Add(CJSONValue(ValueType));
+                m_pJsonList->Add(CurrentArray().Last().Value());
+                return true;
+            }
+
+            if (ValueType == jvtObject)
+                m_pJsonList->Add(Json->GetObject());
+            else
+                m_pJsonList->Add(Json->GetArray());
+
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONBuilder::AddValue(CJSONValueType ValueType, LPCTSTR Str, size_t Length) {
+            // A scalar document has no place in the CJSON tree
+            if (m_pJsonList->Count() == 0)
+                return false;
+
+            if (CurrentJson().IsObject()) {
+                CJSONValue &Value = CurrentObject().Last().Value();
+                Value.ValueType(ValueType);
+                if (Length != 0)
+                    Value.Data().Append(Str, Length);
+            } else {
+                CurrentArray().Add(CJSONValue(ValueType));
+                if (Length != 0)
+                    CurrentArray().Last().Data().Append(Str, Length);
+            }
+
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONBuilder::OnEndObject() {
+            m_pJsonList->Extract(m_pJsonList->Last());
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONBuilder::OnName(LPCTSTR Str, size_t Length) {
+            auto &Object = CurrentObject();
+            const auto Index = Object.Add(CJSONMember());
+            if (Length != 0) {
+                Object.Last().String().Append(Str, Length);
+                Object.Update(Index);
+            }
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONBuilder::OnBoolean(bool Value) {
+            if (Value)
+                return AddValue(jvtBoolean, _T("true"), 4);
+            return AddValue(jvtBoolean, _T("false"), 5);
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CJSONNode -------------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        const CJSONTapeItem *CJSONNode::Item() const {
+            if (m_pDocument == nullptr || m_Index >= m_pDocument->m_Count)
+                return nullptr;
+            return &m_pDocument->m_Tape[m_Index];
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONValueType CJSONNode::ValueType() const {
+            const auto pItem = Item();
+            return pItem == nullptr ? jvtNull : (CJSONValueType) pItem->Type;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CJSONNode::Count() const {
+            const auto pItem = Item();
+            return pItem == nullptr ? 0 : (int) pItem->Count;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        LPCTSTR CJSONNode::Text() const {
+            const auto pItem = Item();
+            return pItem == nullptr ? nullptr : m_pDocument->m_Source + pItem->Offset;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        size_t CJSONNode::Length() const {
+            const auto pItem = Item();
+            return pItem == nullptr ? 0 : pItem->Length;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CJSONNode::IndexOfString(reference String, size_t Length) const {
+            if (!IsObject())
+                return -1;
+
+            const CJSONTapeItem *Tape = m_pDocument->m_Tape;
+            LPCTSTR Source = m_pDocument->m_Source;
+
+            uint32_t Name = m_Index + 1;
+            for (int I = 0; I < (int) Tape[m_Index].Count; ++I) {
+                const CJSONTapeItem &Item = Tape[Name];
+                // Same rule as CString::Compare: an empty name never matches
+                if (Length != 0 && Item.Length == Length && memcmp(Source + Item.Offset, String, Length * sizeof(TCHAR)) == 0)
+                    return I;
+                Name = Tape[Item.Next].Next;
+            }
+
+            return -1;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CString CJSONNode::Strings(int Index) const {
+            if (!IsObject() || Index < 0 || Index >= Count())
+                throw ExceptionFrm(SListIndexError, Index);
+
+            const CJSONTapeItem *Tape = m_pDocument->m_Tape;
+
+            uint32_t Name = m_Index + 1;
+            for (int I = 0; I < Index; ++I)
+                Name = Tape[Tape[Name].Next].Next;
+
+            return Child(Name).Data();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CString CJSONNode::Name() const {
+            CString Result;
+            // A member name is always the tape item right before its value
+            if (m_pDocument != nullptr && m_Parent != m_Index && m_pDocument->m_Tape[m_Parent].Type == jvtObject)
+                Result = Child(m_Index - 1).Data();
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CString CJSONNode::Data() const {
+            CString Result;
+            const auto pItem = Item();
+            if (pItem != nullptr && pItem->Length != 0)
+                Result.Create(m_pDocument->m_Source + pItem->Offset, pItem->Length);
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CString CJSONNode::AsString() const {
+            if (IsString())
+                return DecodeJsonString(Data());
+            return Data();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CJSONNode::AsBoolean() const {
+            LPCTSTR LBoolStr[] = ARRAY_BOOLEAN_STRINGS;
+
+            const CString &Value = Data();
+            for (size_t i = 0; i < chARRAY(LBoolStr); ++i) {
+                if (SameText(LBoolStr[i], Value.c_str()))
+                    return Odd(i);
+            }
+
+            throw EConvertError(_T("Invalid conversion string \"%s\" to boolean value."), Value.c_str());
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONNode::ToJson(CJSON &Json) const {
+            if (!IsObject() && !IsArray())
+                throw ExceptionFrm(_T("JSON node is not an object or array."));
+
+            Json.BeginUpdate();
+            try {
+                Json.Clear();
+                CJSONBuilder Builder(&Json);
+                m_pDocument->Replay(m_Index, Builder);
+            } catch (...) {
+                Json.EndUpdate();
+                throw;
+            }
+            Json.EndUpdate();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONNode CJSONNode::First() const {
+            const auto pItem = Item();
+
+            if (pItem == nullptr || pItem->Count == 0)
+                return {};
+
+            if (pItem->Type == jvtObject)
+                return Child(m_pDocument->m_Tape[m_Index + 1].Next);
+
+            return Child(m_Index + 1);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONNode CJSONNode::Next() const {
+            const auto pItem = Item();
+
+            if (pItem == nullptr || m_Parent == m_Index)
+                return {};
+
+            const CJSONTapeItem &Parent = m_pDocument->m_Tape[m_Parent];
+
+            // The container's Next is the first tape index past its last child
+            uint32_t Index = pItem->Next;
+            if (Index >= Parent.Next)
+                return {};
+
+            if (Parent.Type == jvtObject)
+                Index = m_pDocument->m_Tape[Index].Next;
+
+            return {m_pDocument, Index, m_Parent};
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONNode CJSONNode::operator[](int Index) const {
+            const auto pItem = Item();
+
+            if (pItem == nullptr || Index < 0 || Index >= (int) pItem->Count)
+                return {};
+
+            const CJSONTapeItem *Tape = m_pDocument->m_Tape;
+
+            uint32_t Value = m_Index + 1;
+            if (pItem->Type == jvtObject) {
+                Value = Tape[Value].Next;
+                for (int I = 0; I < Index; ++I)
+                    Value = Tape[Tape[Value].Next].Next;
+            } else {
+                for (int I = 0; I < Index; ++I)
+                    Value = Tape[Value].Next;
+            }
+
+            return Child(Value);
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CJSONDocument ---------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONDocument::CJSONDocument(): CObject() {
+            m_Source = nullptr;
+            m_Size = 0;
+            m_Tape = nullptr;
+            m_Count = 0;
+            m_Capacity = 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONDocument::CJSONDocument(const CString &String): CJSONDocument() {
+            Parse(String);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CJSONDocument::~CJSONDocument() {
+            Clear();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONDocument::Clear() {
+            if (m_Source != nullptr)
+                m_Source = (LPTSTR) GHeap->Free(0, m_Source, m_Size * sizeof(TCHAR));
+            if (m_Tape != nullptr)
+                m_Tape = (CJSONTapeItem *) GHeap->Free(0, m_Tape, m_Capacity * sizeof(CJSONTapeItem));
+
+            m_Size = 0;
+            m_Count = 0;
+            m_Capacity = 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint32_t CJSONDocument::NewItem(CJSONValueType Type, size_t Offset, size_t Length) {
+            if (m_Count == m_Capacity) {
+                const uint32_t Capacity = m_Capacity * 2;
+                // On failure the old tape stays in m_Tape for Clear() to free
+                const auto Tape = (CJSONTapeItem *) GHeap->ReAlloc(0, m_Tape, Capacity * sizeof(CJSONTapeItem),
+                                                                    m_Capacity * sizeof(CJSONTapeItem));
+                if (Tape == nullptr)
+                    throw Delphi::Exception::Exception(_T("Out of memory while expanding JSON document"));
+                m_Tape = Tape;
+                m_Capacity = Capacity;
+            }
+
+            CJSONTapeItem &Item = m_Tape[m_Count];
+
+            Item.Type = Type;
+            Item.Next = m_Count + 1;
+            Item.Offset = Offset;
+            Item.Length = Length;
+            Item.Count = 0;
+
+            return m_Count++;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONDocument::Parse(LPCTSTR ABuffer, size_t ASize) {
+            uint32_t Stack[JSON_READER_MAX_DEPTH];
+            int Depth = 0;
+
+            Clear();
+
+            if (!Assigned(ABuffer) || ASize == 0)
+                return;
+
+            if (ASize > _MAX_UINT32_VALUE)
+                throw ExceptionFrm(_T("JSON document too large: %lu."), (unsigned long) ASize);
+
+            m_Source = (LPTSTR) GHeap->Alloc(0, ASize * sizeof(TCHAR));
+            m_Size = ASize;
+            ::CopyMemory(m_Source, ABuffer, ASize * sizeof(TCHAR));
+
+            m_Capacity = ASize / 8 + 16;
+            m_Tape = (CJSONTapeItem *) GHeap->Alloc(0, m_Capacity * sizeof(CJSONTapeItem));
+
+            CJSONReader Reader(m_Source, m_Size);
+
+            for (;;) {
+                const CJSONToken Token = Reader.Next();
+                const size_t Offset = Assigned(Reader.Text()) ? Reader.Text() - m_Source : 0;
+
+                // Array elements are counted by value, object members by name
+                if (Depth > 0 && Token != jtEndObject && Token != jtEndArray) {
+                    CJSONTapeItem &Parent = m_Tape[Stack[Depth - 1]];
+                    if ((Parent.Type == jvtArray) == (Token != jtName))
+                        Parent.Count++;
+                }
+
+                switch (Token) {
+                    case jtStartObject:
+                        Stack[Depth++] = NewItem(jvtObject, Offset, 0);
+                        break;
+                    case jtStartArray:
+                        Stack[Depth++] = NewItem(jvtArray, Offset, 0);
+                        break;
+                    case jtEndObject:
+                    case jtEndArray: {
+                        CJSONTapeItem &Item = m_Tape[Stack[--Depth]];
+                        Item.Length = Offset + 1 - Item.Offset;
+                        Item.Next = m_Count;
+                        break;
+                    }
+                    case jtName:
+                    case jtString:
+                        NewItem(jvtString, Offset, Reader.Length());
+                        break;
+                    case jtNumber:
+                        NewItem(jvtNumber, Offset, Reader.Length());
+                        break;
+                    case jtTrue:
+                    case jtFalse:
+                        NewItem(jvtBoolean, Offset, Reader.Length());
+                        break;
+                    case jtNull:
+                        NewItem(jvtNull, Offset, Reader.Length());
+                        break;
+                    case jtEnd:
+                        return;
+                    default: {
+                        const size_t Position = Reader.Position();
+                        const TCHAR C = Position < m_Size ? m_Source[Position] : 0;
+                        Clear();
+                        throw Exception::EJSONParseSyntaxError(_T("JSON Parser syntax error in position %d, char: %#x"), Position, C);
+                    }
+                }
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CJSONDocument::Replay(uint32_t Index, CJSONHandler &Handler) const {
+            const CJSONTapeItem &Item = m_Tape[Index];
+
+            switch (Item.Type) {
+                case jvtObject: {
+                    Handler.OnStartObject();
+                    uint32_t Name = Index + 1;
+                    for (uint32_t I = 0; I < Item.Count; ++I) {
+                        Handler.OnName(m_Source + m_Tape[Name].Offset, m_Tape[Name].Length);
+                        Replay(m_Tape[Name].Next, Handler);
+                        Name = m_Tape[m_Tape[Name].Next].Next;
+                    }
+                    Handler.OnEndObject();
+                    break;
+                }
+                case jvtArray: {
+                    Handler.OnStartArray();
+                    uint32_t Value = Index + 1;
+                    for (uint32_t I = 0; I < Item.Count; ++I) {
+                        Replay(Value, Handler);
+                        Value = m_Tape[Value].Next;
+                    }
+                    Handler.OnEndArray();
+                    break;
+                }
+                case jvtString:
+                    Handler.OnString(m_Source + Item.Offset, Item.Length);
+                    break;
+                case jvtNumber:
+                    Handler.OnNumber(m_Source + Item.Offset, Item.Length);
+                    break;
+                case jvtBoolean:
+                    Handler.OnBoolean(m_Source[Item.Offset] == 't');
+                    break;
+                default:
+                    Handler.OnNull();
+                    break;
+            }
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
         //-- CJSONParser -----------------------------------------------------------------------------------------------
 
         //--------------------------------------------------------------------------------------------------------------
@@ -1924,6 +3277,7 @@ namespace Delphi {
                         m_State = string;
                         return -1;
                     } else if (AInput == '"') {
+                        CurrentObject().Update(CurrentObject().Count() - 1);
                         m_State = string_end;
                         return -1;
                     }
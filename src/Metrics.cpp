@@ -0,0 +1,601 @@
+/*++
+
+Library name:
+
+  libdelphi
+
+Module Name:
+
+  Metrics.cpp
+
+Notices:
+
+  Delphi classes for C++
+
+  Metrics registry: counters, gauges and latency histograms in Prometheus text format
+
+Author:
+
+  Copyright (c) Prepodobny Alen
+
+  mailto: alienufo@inbox.ru
+  mailto: ufocomp@gmail.com
+
+--*/
+
+#include "delphi.hpp"
+#include "delphi/Metrics.hpp"
+//----------------------------------------------------------------------------------------------------------------------
+
+extern "C++" {
+
+namespace Delphi {
+
+    namespace Metrics {
+
+        uint64_t MetricsTime() {
+            struct timespec ts = {0, 0};
+            ::clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static void AppendValue(CString &Text, LPCTSTR Format, ...) {
+            TCHAR szValue[64] = {0};
+
+            va_list args;
+            va_start(args, Format);
+            ::vsnprintf(szValue, sizeof(szValue), Format, args);
+            va_end(args);
+
+            Text.Append(szValue);
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CMetric ---------------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetric::CMetric(CMetricType Type, const CString &Name, const CString &Help, const CString &Labels): CObject(),
+                m_Type(Type), m_Name(Name), m_Help(Help), m_Labels(Labels) {
+
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CMetric::Shard() {
+            static int NextShard = 0;
+            static thread_local int Index = -1;
+
+            if (Index == -1)
+                Index = __atomic_fetch_add(&NextShard, 1, __ATOMIC_RELAXED) % METRICS_SHARDS;
+
+            return Index;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        LPCTSTR CMetric::TypeName() const {
+            switch (m_Type) {
+                case mtCounter:
+                    return _T("counter");
+                case mtGauge:
+                    return _T("gauge");
+                case mtHistogram:
+                    return _T("histogram");
+            }
+            return _T("untyped");
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CMetric::AppendName(CString &Text, LPCTSTR Suffix, LPCTSTR Label) const {
+            Text.Append(m_Name);
+
+            if (Suffix != nullptr)
+                Text.Append(Suffix);
+
+            if (!m_Labels.IsEmpty() || Label != nullptr) {
+                Text.Append('{');
+                if (!m_Labels.IsEmpty()) {
+                    Text.Append(m_Labels);
+                    if (Label != nullptr)
+                        Text.Append(',');
+                }
+                if (Label != nullptr)
+                    Text.Append(Label);
+                Text.Append('}');
+            }
+
+            Text.Append(' ');
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CMetricCounter --------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricCounter::CMetricCounter(const CString &Name, const CString &Help, const CString &Labels):
+                CMetric(mtCounter, Name, Help, Labels), m_Cells() {
+
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricCounter::CMetricCounter(CMetricType Type, const CString &Name, const CString &Help, const CString &Labels):
+                CMetric(Type, Name, Help, Labels), m_Cells() {
+
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int64_t CMetricCounter::Sum() const {
+            int64_t Result = 0;
+            for (const auto &Cell : m_Cells)
+                Result += __atomic_load_n(&Cell.Value, __ATOMIC_RELAXED);
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CMetricCounter::ToText(CString &Text) const {
+            AppendName(Text, nullptr);
+            AppendValue(Text, "%lld\n", (long long) Sum());
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CMetricGauge ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricGauge::CMetricGauge(const CString &Name, const CString &Help, const CString &Labels):
+                CMetricCounter(mtGauge, Name, Help, Labels) {
+            m_Base = 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CMetricGauge::Set(int64_t Value) {
+            __atomic_store_n(&m_Base, Value - Sum(), __ATOMIC_RELAXED);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int64_t CMetricGauge::Value() const {
+            return __atomic_load_n(&m_Base, __ATOMIC_RELAXED) + Sum();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CMetricGauge::ToText(CString &Text) const {
+            AppendName(Text, nullptr);
+            AppendValue(Text, "%lld\n", (long long) Value());
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CMetricHistogram ------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricHistogram::CMetricHistogram(const CString &Name, const CString &Help, const CString &Labels):
+                CMetric(mtHistogram, Name, Help, Labels) {
+
+            void *pShards = nullptr;
+            if (::posix_memalign(&pShards, METRICS_CACHE_LINE, sizeof(CMetricHistogramShard) * METRICS_SHARDS) != 0)
+                throw Delphi::Exception::Exception(_T("Metrics: out of memory."));
+
+            ::memset(pShards, 0, sizeof(CMetricHistogramShard) * METRICS_SHARDS);
+            m_pShards = static_cast<CMetricHistogramShard *> (pShards);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricHistogram::~CMetricHistogram() {
+            free(m_pShards);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CMetricHistogram::BucketOf(uint64_t Value) {
+            constexpr uint64_t SubBuckets = 1u << METRICS_HISTOGRAM_PRECISION;
+            constexpr uint64_t MaxValue = ((uint64_t) 1 << METRICS_HISTOGRAM_RANGE) - 1;
+
+            if (Value < SubBuckets)
+                return (int) Value;
+
+            if (Value > MaxValue)
+                Value = MaxValue;
+
+            const int Exponent = 63 - __builtin_clzll(Value);
+            const int Shift = Exponent - METRICS_HISTOGRAM_PRECISION;
+
+            return (int) (((uint64_t) (Shift + 1) << METRICS_HISTOGRAM_PRECISION) + ((Value >> Shift) & (SubBuckets - 1)));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint64_t CMetricHistogram::BucketUpper(int Index) {
+            constexpr int SubBuckets = 1 << METRICS_HISTOGRAM_PRECISION;
+
+            if (Index < SubBuckets)
+                return (uint64_t) Index;
+
+            const int Shift = (Index >> METRICS_HISTOGRAM_PRECISION) - 1;
+            const uint64_t Lower = (uint64_t) (SubBuckets + (Index & (SubBuckets - 1))) << Shift;
+
+            return Lower + ((uint64_t) 1 << Shift) - 1;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CMetricHistogram::Merge(CMetricHistogramShard &Total) const {
+            ::memset(&Total, 0, sizeof(Total));
+
+            for (int i = 0; i < METRICS_SHARDS; ++i) {
+                const auto &Shard = m_pShards[i];
+                for (int j = 0; j < METRICS_HISTOGRAM_BUCKETS; ++j)
+                    Total.Buckets[j] += __atomic_load_n(&Shard.Buckets[j], __ATOMIC_RELAXED);
+                Total.Count += __atomic_load_n(&Shard.Count, __ATOMIC_RELAXED);
+                Total.Sum += __atomic_load_n(&Shard.Sum, __ATOMIC_RELAXED);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint64_t CMetricHistogram::Count() const {
+            uint64_t Result = 0;
+            for (int i = 0; i < METRICS_SHARDS; ++i)
+                Result += __atomic_load_n(&m_pShards[i].Count, __ATOMIC_RELAXED);
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint64_t CMetricHistogram::Sum() const {
+            uint64_t Result = 0;
+            for (int i = 0; i < METRICS_SHARDS; ++i)
+                Result += __atomic_load_n(&m_pShards[i].Sum, __ATOMIC_RELAXED);
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        uint64_t CMetricHistogram::Quantile(double Q) const {
+            CMetricHistogramShard Total;
+            Merge(Total);
+
+            if (Total.Count == 0)
+                return 0;
+
+            auto Rank = (uint64_t) (Q * (double) Total.Count + 0.5);
+            if (Rank < 1)
+                Rank = 1;
+
+            uint64_t Seen = 0;
+            for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; ++i) {
+                Seen += Total.Buckets[i];
+                if (Seen >= Rank)
+                    return BucketUpper(i);
+            }
+
+            return BucketUpper(METRICS_HISTOGRAM_BUCKETS - 1);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CMetricHistogram::ToText(CString &Text) const {
+            CMetricHistogramShard Total;
+            Merge(Total);
+
+            TCHAR szLabel[64] = {0};
+
+            /*
+             * Buckets of one log2 group never straddle a power of two, so the cumulative count below 2^k is exact.
+             * Values are whole microseconds and "le" is inclusive, so that count is labelled with 2^k - 1.
+             */
+            uint64_t Cumulative = 0;
+            int Index = 0;
+
+            for (int k = METRICS_HISTOGRAM_PRECISION; k <= METRICS_HISTOGRAM_RANGE; ++k) {
+                const uint64_t Bound = (uint64_t) 1 << k;
+
+                while (Index < METRICS_HISTOGRAM_BUCKETS && BucketUpper(Index) < Bound)
+                    Cumulative += Total.Buckets[Index++];
+
+                ::snprintf(szLabel, sizeof(szLabel), "le=\"%.6f\"", (double) (Bound - 1) / 1000000);
+                AppendName(Text, "_bucket", szLabel);
+                AppendValue(Text, "%llu\n", (unsigned long long) Cumulative);
+            }
+
+            AppendName(Text, "_bucket", "le=\"+Inf\"");
+            AppendValue(Text, "%llu\n", (unsigned long long) Total.Count);
+
+            AppendName(Text, "_sum");
+            AppendValue(Text, "%.6f\n", (double) Total.Sum / 1000000);
+
+            AppendName(Text, "_count");
+            AppendValue(Text, "%llu\n", (unsigned long long) Total.Count);
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CMetricsRegistry ------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricsRegistry::CMetricsRegistry(): CObject() {
+            pthread_mutex_init(&m_Lock, nullptr);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricsRegistry::~CMetricsRegistry() {
+            for (int i = 0; i < m_Metrics.Count(); ++i)
+                delete Metrics(i);
+            m_Metrics.Clear();
+
+            pthread_mutex_destroy(&m_Lock);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricsRegistry &CMetricsRegistry::Default() {
+            // Leaked on purpose: connections released during static destruction still update their metrics
+            static auto *Registry = new CMetricsRegistry();
+            return *Registry;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetric *CMetricsRegistry::Find(const CString &Name, const CString &Labels) const {
+            for (int i = 0; i < m_Metrics.Count(); ++i) {
+                const auto pMetric = Metrics(i);
+                if (pMetric->Name() == Name && pMetric->Labels() == Labels)
+                    return pMetric;
+            }
+            return nullptr;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetric *CMetricsRegistry::Get(CMetricType Type, const CString &Name, const CString &Help, const CString &Labels) {
+            CMetric *pMetric;
+
+            pthread_mutex_lock(&m_Lock);
+            try {
+                pMetric = Find(Name, Labels);
+
+                if (pMetric == nullptr) {
+                    switch (Type) {
+                        case mtCounter:
+                            pMetric = new CMetricCounter(Name, Help, Labels);
+                            break;
+                        case mtGauge:
+                            pMetric = new CMetricGauge(Name, Help, Labels);
+                            break;
+                        case mtHistogram:
+                            pMetric = new CMetricHistogram(Name, Help, Labels);
+                            break;
+                    }
+                    m_Metrics.Add(pMetric);
+                } else if (pMetric->Type() != Type) {
+                    throw ExceptionFrm(_T("Metrics: \"%s\" is already registered as a %s."), Name.c_str(), pMetric->TypeName());
+                }
+            } catch (...) {
+                pthread_mutex_unlock(&m_Lock);
+                throw;
+            }
+            pthread_mutex_unlock(&m_Lock);
+
+            return pMetric;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricCounter *CMetricsRegistry::Counter(const CString &Name, const CString &Help, const CString &Labels) {
+            return static_cast<CMetricCounter *> (Get(mtCounter, Name, Help, Labels));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricGauge *CMetricsRegistry::Gauge(const CString &Name, const CString &Help, const CString &Labels) {
+            return static_cast<CMetricGauge *> (Get(mtGauge, Name, Help, Labels));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CMetricHistogram *CMetricsRegistry::Histogram(const CString &Name, const CString &Help, const CString &Labels) {
+            return static_cast<CMetricHistogram *> (Get(mtHistogram, Name, Help, Labels));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CMetricsRegistry::ToText(CString &Text) {
+            pthread_mutex_lock(&m_Lock);
+
+            for (int i = 0; i < m_Metrics.Count(); ++i) {
+                const auto pMetric = Metrics(i);
+
+                int First = 0;
+                while (Metrics(First)->Name() != pMetric->Name())
+                    First++;
+
+                if (First < i)
+                    continue;
+
+                // One HELP/TYPE header per family, then every label set of that family
+                Text.Append(_T("# HELP "));
+                Text.Append(pMetric->Name());
+                Text.Append(' ');
+                Text.Append(pMetric->Help());
+                Text.Append(_T("\n# TYPE "));
+                Text.Append(pMetric->Name());
+                Text.Append(' ');
+                Text.Append(pMetric->TypeName());
+                Text.Append('\n');
+
+                for (int j = i; j < m_Metrics.Count(); ++j) {
+                    if (Metrics(j)->Name() == pMetric->Name())
+                        Metrics(j)->ToText(Text);
+                }
+            }
+
+            pthread_mutex_unlock(&m_Lock);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CString CMetricsRegistry::Text() {
+            CString Result;
+            ToText(Result);
+            return Result;
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CSharedStats ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CSharedStats::CSharedStats(int SlotCount): CObject() {
+            m_SlotCount = SlotCount;
+            m_SlotSize = 0;
+            m_pData = nullptr;
+            m_Slot = -1;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CSharedStatsSlot *CSharedStats::GetSlot(int Index) const {
+            return (CSharedStatsSlot *) (m_pData + Index * m_SlotSize);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CSharedStats::Define(CMetricType Type, const CString &Name, const CString &Help) {
+            if (Created())
+                throw ExceptionFrm(_T("Shared stats value \"%s\" defined after the segment was created."), Name.c_str());
+
+            if (Type == mtHistogram)
+                throw ExceptionFrm(_T("Shared stats value \"%s\": histograms are not supported."), Name.c_str());
+
+            CSharedStatsValue Value;
+
+            Value.Type = Type;
+            Value.Name = Name;
+            Value.Help = Help;
+
+            m_Values.Add(std::move(Value));
+
+            return m_Values.Count() - 1;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSharedStats::Create() {
+            if (Created())
+                return;
+
+            if (m_SlotCount <= 0 || m_Values.Count() == 0)
+                throw ExceptionFrm(_T("Shared stats segment needs at least one slot and one value."));
+
+            // Round every slot up to whole cache lines: workers never write to the same line
+            const size_t Size = offsetof(CSharedStatsSlot, Values) + m_Values.Count() * sizeof(int64_t);
+            m_SlotSize = (Size + METRICS_CACHE_LINE - 1) & ~((size_t) METRICS_CACHE_LINE - 1);
+
+            m_Heap.SetMaximumSize(m_SlotCount * m_SlotSize);
+            m_Heap.Initialize();
+
+            m_pData = (char *) m_Heap.GetHandle();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CSharedStats::Acquire() {
+            if (!Created())
+                throw ExceptionFrm(_T("Shared stats segment has not been created."));
+
+            const pid_t Pid = ::getpid();
+
+            for (int i = 0; i < m_SlotCount; ++i) {
+                pid_t Free = 0;
+                if (__atomic_compare_exchange_n(&GetSlot(i)->Pid, &Free, Pid, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                    __atomic_store_n(&GetSlot(i)->Used, 1, __ATOMIC_RELAXED);
+                    m_Slot = i;
+                    return i;
+                }
+            }
+
+            throw ExceptionFrm(_T("No free shared stats slot for process %d."), Pid);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSharedStats::Release(pid_t Pid) {
+            if (!Created() || Pid == 0)
+                return;
+
+            for (int i = 0; i < m_SlotCount; ++i) {
+                const auto pSlot = GetSlot(i);
+
+                if (__atomic_load_n(&pSlot->Pid, __ATOMIC_ACQUIRE) != Pid)
+                    continue;
+
+                for (int j = 0; j < m_Values.Count(); ++j) {
+                    if (m_Values[j].Type == mtGauge)
+                        __atomic_store_n(&pSlot->Values[j], 0, __ATOMIC_RELAXED);
+                }
+
+                if (i == m_Slot)
+                    m_Slot = -1;
+
+                __atomic_store_n(&pSlot->Pid, 0, __ATOMIC_RELEASE);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int64_t CSharedStats::Value(int Slot, int Index) const {
+            if (Slot < 0 || Slot >= m_SlotCount)
+                throw ExceptionFrm(SListIndexError, Slot);
+
+            if (Index < 0 || Index >= m_Values.Count())
+                throw ExceptionFrm(SListIndexError, Index);
+
+            return Created() ? __atomic_load_n(&GetSlot(Slot)->Values[Index], __ATOMIC_RELAXED) : 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int64_t CSharedStats::Total(int Index) const {
+            if (Index < 0 || Index >= m_Values.Count())
+                throw ExceptionFrm(SListIndexError, Index);
+
+            if (!Created())
+                return 0;
+
+            const bool Gauge = m_Values[Index].Type == mtGauge;
+
+            int64_t Result = 0;
+            for (int i = 0; i < m_SlotCount; ++i) {
+                const auto pSlot = GetSlot(i);
+                if (Gauge && __atomic_load_n(&pSlot->Pid, __ATOMIC_ACQUIRE) == 0)
+                    continue;
+                Result += __atomic_load_n(&pSlot->Values[Index], __ATOMIC_RELAXED);
+            }
+
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        pid_t CSharedStats::SlotPid(int Slot) const {
+            if (Slot < 0 || Slot >= m_SlotCount)
+                throw ExceptionFrm(SListIndexError, Slot);
+
+            return Created() ? __atomic_load_n(&GetSlot(Slot)->Pid, __ATOMIC_ACQUIRE) : 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSharedStats::ToText(CString &Text) const {
+            if (!Created())
+                return;
+
+            for (int j = 0; j < m_Values.Count(); ++j) {
+                const auto &Value = m_Values[j];
+                const bool Gauge = Value.Type == mtGauge;
+
+                Text.Append(_T("# HELP "));
+                Text.Append(Value.Name);
+                Text.Append(' ');
+                Text.Append(Value.Help);
+                Text.Append(_T("\n# TYPE "));
+                Text.Append(Value.Name);
+                Text.Append(Gauge ? _T(" gauge\n") : _T(" counter\n"));
+
+                for (int i = 0; i < m_SlotCount; ++i) {
+                    const auto pSlot = GetSlot(i);
+
+                    const bool Live = __atomic_load_n(&pSlot->Pid, __ATOMIC_ACQUIRE) != 0;
+                    if (Gauge ? !Live : (!Live && __atomic_load_n(&pSlot->Used, __ATOMIC_RELAXED) == 0))
+                        continue;
+
+                    Text.Append(Value.Name);
+                    AppendValue(Text, "{worker=\"%d\"} %lld\n", i, (long long) __atomic_load_n(&pSlot->Values[j], __ATOMIC_RELAXED));
+                }
+            }
+        }
+
+    }
+}
+}
@@ -523,6 +523,8 @@ namespace Delphi {
                 case CONNECTION_AUTHENTICATING:
                     return "Authentication is in progress with some external system.";
 #endif
+                default:
+                    break;
             }
 
             return "Unknown status.";
@@ -1063,9 +1065,33 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
-        CPQPollQuery::CPQPollQuery(CPQConnectPoll *AConnectPoll): CPQQuery(), CPollConnection(AConnectPoll->ptrQueryManager()) {
+        struct CPQMetrics {
+            CMetricCounter *Queries;
+            CMetricCounter *Errors;
+            CMetricGauge *Queued;
+            CMetricHistogram *Wait;
+            CMetricHistogram *Duration;
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        static const CPQMetrics &PQMetrics() {
+            static const CPQMetrics Metrics = {
+                CMetricsRegistry::Default().Counter("delphi_pq_queries_total", "Queries completed by the PostgreSQL pool."),
+                CMetricsRegistry::Default().Counter("delphi_pq_query_errors_total", "Queries that failed or returned an error result."),
+                CMetricsRegistry::Default().Gauge("delphi_pq_queue_depth", "Queries waiting for a free pool connection."),
+                CMetricsRegistry::Default().Histogram("delphi_pq_pool_wait_seconds", "Time a query waited in the queue for a connection."),
+                CMetricsRegistry::Default().Histogram("delphi_pq_query_duration_seconds", "Time from sending a query to its last result.")
+            };
+            return Metrics;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CPQPollQuery::CPQPollQuery(CPQConnectPoll *AConnectPoll): CPollConnection(AConnectPoll->ptrQueryManager()), CPQQuery() {
             m_pConnectPoll = AConnectPoll;
 
+            m_QueuedAt = 0;
+            m_StartedAt = 0;
+
             m_OnExecuted = nullptr;
             m_OnException = nullptr;
         }
@@ -1076,6 +1102,13 @@ namespace Delphi {
                 auto pConnection = m_pConnectPoll->GetReadyConnection();
 
                 if (pConnection != nullptr) {
+                    m_StartedAt = MetricsTime();
+
+                    if (m_QueuedAt != 0) {
+                        PQMetrics().Wait->Observe(m_StartedAt - m_QueuedAt);
+                        m_QueuedAt = 0;
+                    }
+
                     try {
                         pConnection->QueryStart(this);
                     } catch (Delphi::Exception::Exception &E) {
@@ -1104,6 +1137,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         int CPQPollQuery::AddToQueue() {
+            if (m_QueuedAt == 0)
+                m_QueuedAt = MetricsTime();
             return m_pConnectPoll->AddToQueue(this);
         }
         //--------------------------------------------------------------------------------------------------------------
@@ -1114,6 +1149,20 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CPQPollQuery::DoExecuted() {
+            const auto &Metrics = PQMetrics();
+
+            Metrics.Queries->Inc();
+
+            if (m_StartedAt != 0)
+                Metrics.Duration->ObserveSince(m_StartedAt);
+
+            for (int i = 0; i < ResultCount(); ++i) {
+                if (Results(i)->ResultStatus() == PGRES_FATAL_ERROR) {
+                    Metrics.Errors->Inc();
+                    break;
+                }
+            }
+
             if (m_OnExecuted != nullptr) {
                 try {
                     m_OnExecuted(this);
@@ -1124,6 +1173,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CPQPollQuery::DoException(const Delphi::Exception::Exception &E) {
+            PQMetrics().Errors->Inc();
+
             if (m_OnException != nullptr) {
                 try {
                     m_OnException(this, E);
@@ -1248,7 +1299,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         CPQPollConnection *CPQConnectPoll::GetHandlerConnection(CPollEventHandler *AHandler) {
-            return dynamic_cast<CPQPollConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            return m_ConnectManager.Contains(pBinding) ? static_cast<CPQPollConnection *> (pBinding) : nullptr;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -1308,12 +1360,15 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         int CPQConnectPoll::AddToQueue(CPQPollQuery *AQuery) {
-            return m_Queue.AddToQueue(this, AQuery);
+            const int Index = m_Queue.AddToQueue(this, AQuery);
+            PQMetrics().Queued->Inc();
+            return Index;
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CPQConnectPoll::RemoveFromQueue(CPQPollQuery *AQuery) {
             m_Queue.RemoveFromQueue(this, AQuery);
+            PQMetrics().Queued->Dec();
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -1486,8 +1541,8 @@ namespace Delphi {
 
         void CPQConnectPoll::PackConnections(CDateTime Now, CDateTime Period) {
             CPQPollConnection *pConnection;
-            if (m_ConnectManager.Count() > m_SizeMin) {
-                for (int i = m_ConnectManager.Count() - 1; i >= m_SizeMin; --i) {
+            if ((size_t) m_ConnectManager.Count() > m_SizeMin) {
+                for (int i = m_ConnectManager.Count() - 1; i >= (int) m_SizeMin; --i) {
                     pConnection = dynamic_cast<CPQPollConnection *> (m_ConnectManager[i]);
                     if ((pConnection->Listeners().Count() == 0) && (pConnection->ConnectionStatus() != qsWait)) {
                         if (Now - pConnection->AntiFreeze() >= Period)
@@ -1712,7 +1767,7 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        bool CPQClient::DoCommand(CTCPConnection *AConnection) {
+        bool CPQClient::DoCommand(CTCPConnection *) {
             return false;
         }
         //--------------------------------------------------------------------------------------------------------------
@@ -23,6 +23,9 @@ Author:
 
 #include "delphi.hpp"
 #include "delphi/Process.hpp"
+
+#include <dirent.h>
+#include <linux/mempolicy.h>
 //----------------------------------------------------------------------------------------------------------------------
 
 extern "C++" {
@@ -55,6 +58,8 @@ namespace Delphi {
 
             m_pData = nullptr;
 
+            m_CPU = -1;
+
             m_pwd.uid = -1;
             m_pwd.gid = -1;
 
@@ -66,6 +71,7 @@ namespace Delphi {
         void CCustomProcess::Assign(CCustomProcess *AProcess) {
             m_fDaemonized = AProcess->Daemonized();
             m_NewBinary = AProcess->NewBinary();
+            m_Tuning = AProcess->Tuning();
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -82,6 +88,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CCustomProcess::ExecuteProcess(CExecuteContext *AContext) {
+            CSignals::RestoreSigMask();
+
             if (execve(AContext->path, AContext->argv, AContext->envp) == -1) {
                 throw EOSError(errno, _T("execve() failed while executing %s \"%s\""), AContext->name, AContext->path);
             }
@@ -90,6 +98,71 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        pid_t CCustomProcess::ExecuteNewBinary(CExecuteContext *AContext, const CString &Sockets) {
+            const pid_t pid = fork();
+
+            if (pid == -1)
+                throw EOSError(errno, _T("fork() failed while executing new binary \"%s\""), AContext->path);
+
+            if (pid == 0) {
+                CSignals::RestoreSigMask();
+
+                LPCSTR Value = Sockets.c_str();
+
+                while (*Value != '\0') {
+                    char *End = nullptr;
+                    const long Handle = ::strtol(Value, &End, 10);
+                    if (End == Value)
+                        break;
+
+                    const int Flags = ::fcntl((int) Handle, F_GETFD);
+                    if (Flags != -1)
+                        ::fcntl((int) Handle, F_SETFD, Flags & ~FD_CLOEXEC);
+
+                    Value = *End == ';' ? End + 1 : End;
+                }
+
+                ::setenv(SOCKET_INHERIT_ENV, Sockets.c_str(), 1);
+
+                CString Inherit(SOCKET_INHERIT_ENV "=");
+                Inherit << Sockets;
+
+                char *const *envp = AContext->envp;
+
+                if (envp == nullptr) {
+                    envp = environ;
+                } else {
+                    // the caller's environment without a stale SOCKET_INHERIT_ENV, plus the current one
+                    const size_t Prefix = strlen(SOCKET_INHERIT_ENV);
+
+                    size_t Count = 0;
+                    while (envp[Count] != nullptr)
+                        Count++;
+
+                    auto Environ = new char *[Count + 2];
+                    size_t Index = 0;
+
+                    for (size_t i = 0; i < Count; ++i) {
+                        if (strncmp(envp[i], SOCKET_INHERIT_ENV, Prefix) != 0 || envp[i][Prefix] != '=')
+                            Environ[Index++] = envp[i];
+                    }
+
+                    Environ[Index++] = (char *) Inherit.c_str();
+                    Environ[Index] = nullptr;
+
+                    envp = Environ;
+                }
+
+                ::execve(AContext->path, AContext->argv, envp);
+                ::_exit(1);
+            }
+
+            m_NewBinary = pid;
+
+            return pid;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         void CCustomProcess::SetPwd() const {
             if (geteuid() == 0) {
                 if (setgid(m_pwd.gid) == -1) {
@@ -143,13 +216,133 @@ namespace Delphi {
 
         void CCustomProcess::SetLimitNoFile(uint32_t value) {
             if (value != static_cast<uint32_t>(-1)) {
+                SetLimit(RLIMIT_NOFILE, value);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CCustomProcess::SetLimit(int Resource, uint64_t Value) {
+            if (Value != PROCESS_LIMIT_UNCHANGED) {
                 struct rlimit rlmt = { 0, 0 };
 
-                rlmt.rlim_cur = (rlim_t) value;
-                rlmt.rlim_max = (rlim_t) value;
+                rlmt.rlim_cur = (rlim_t) Value;
+                rlmt.rlim_max = (rlim_t) Value;
+
+                if (setrlimit(Resource, &rlmt) == -1) {
+                    throw EOSError(errno, "setrlimit(%d, %llu) failed.", Resource, (unsigned long long) Value);
+                }
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CCustomProcess::ParseCPUList(const CString &List, cpu_set_t *ASet) {
+            CPU_ZERO(ASet);
+
+            if (List == "auto") {
+                if (sched_getaffinity(0, sizeof(cpu_set_t), ASet) == -1)
+                    throw EOSError(errno, "sched_getaffinity() failed.");
+                return CPU_COUNT(ASet);
+            }
+
+            LPCSTR Value = List.c_str();
+
+            while (*Value != '\0') {
+                char *End = nullptr;
+
+                const long First = ::strtol(Value, &End, 10);
+                long Last = First;
+
+                if (End == Value || First < 0)
+                    throw ExceptionFrm("Invalid CPU list: \"%s\".", List.c_str());
+
+                if (*End == '-') {
+                    Value = End + 1;
+                    Last = ::strtol(Value, &End, 10);
+                    if (End == Value || Last < First)
+                        throw ExceptionFrm("Invalid CPU list: \"%s\".", List.c_str());
+                }
+
+                if (Last >= CPU_SETSIZE)
+                    throw ExceptionFrm("CPU %ld is out of range in \"%s\".", Last, List.c_str());
+
+                for (long CPU = First; CPU <= Last; ++CPU)
+                    CPU_SET(CPU, ASet);
+
+                while (*End == ',' || *End == ' ')
+                    End++;
+
+                Value = End;
+            }
+
+            return CPU_COUNT(ASet);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static int CPUNode(int CPU) {
+            char Path[64] = {0};
+            ::snprintf(Path, sizeof(Path), "/sys/devices/system/cpu/cpu%d", CPU);
+
+            DIR *pDir = ::opendir(Path);
+            if (pDir == nullptr)
+                return -1;
+
+            int Result = -1;
+
+            struct dirent *pEntry;
+            while ((pEntry = ::readdir(pDir)) != nullptr) {
+                if (strncmp(pEntry->d_name, "node", 4) == 0 && isdigit(pEntry->d_name[4])) {
+                    Result = (int) ::strtol(pEntry->d_name + 4, nullptr, 10);
+                    break;
+                }
+            }
+
+            ::closedir(pDir);
+
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CCustomProcess::SetAffinity(int CPU, bool NUMALocal) {
+            cpu_set_t Set;
+
+            CPU_ZERO(&Set);
+            CPU_SET(CPU, &Set);
+
+            if (sched_setaffinity(0, sizeof(cpu_set_t), &Set) == -1)
+                throw EOSError(errno, "sched_setaffinity(%d) failed.", CPU);
+
+            if (NUMALocal) {
+                const int Node = CPUNode(CPU);
+                if (Node >= 0 && Node < (int) (sizeof(unsigned long) * 8)) {
+                    // Preferred rather than bound: allocations fall back to other nodes instead of failing
+                    const unsigned long NodeMask = 1UL << Node;
+                    if (::syscall(SYS_set_mempolicy, MPOL_PREFERRED, &NodeMask, sizeof(NodeMask) * 8) == -1)
+                        throw EOSError(errno, "set_mempolicy(node %d) failed.", Node);
+                }
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CCustomProcess::ApplyTuning(int WorkerIndex) {
+            SetLimit(RLIMIT_NOFILE, m_Tuning.LimitNoFile);
+            SetLimit(RLIMIT_CORE, m_Tuning.LimitCore);
+            SetLimit(RLIMIT_MEMLOCK, m_Tuning.LimitMemLock);
+
+            if (m_Tuning.CPUAffinity.IsEmpty())
+                return;
+
+            cpu_set_t Set;
+            const int Count = ParseCPUList(m_Tuning.CPUAffinity, &Set);
+            if (Count == 0)
+                return;
+
+            int Index = WorkerIndex % Count;
 
-                if (setrlimit(RLIMIT_NOFILE, &rlmt) == -1) {
-                    throw EOSError(errno, "setrlimit(RLIMIT_NOFILE, %i) failed.", value);
+            for (int CPU = 0; CPU < CPU_SETSIZE; ++CPU) {
+                if (CPU_ISSET(CPU, &Set) && Index-- == 0) {
+                    SetAffinity(CPU, m_Tuning.NUMALocal);
+                    m_CPU = CPU;
+                    break;
                 }
             }
         }
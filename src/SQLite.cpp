@@ -38,6 +38,8 @@ namespace Delphi {
             m_Handle = nullptr;
             m_DataBase = ADataBase;
             m_ResultCode = SQLITE_ERROR;
+            m_Connected = false;
+            m_StatementCacheSize = SQLITE_STATEMENT_CACHE_SIZE;
             m_OnConnected = nullptr;
             m_OnDisconnected = nullptr;
         }
@@ -45,21 +47,220 @@ namespace Delphi {
 
         CSQLiteConnection::~CSQLiteConnection() {
             Disconnect();
+
+            for (int i = m_Detached.Count() - 1; i >= 0; i--)
+                delete (CSQLiteStatement *) m_Detached.Items(i);
+            m_Detached.Clear();
         }
         //--------------------------------------------------------------------------------------------------------------
 
         bool CSQLiteConnection::Connect() {
-            if ((m_ResultCode = sqlite3_open_v2(m_DataBase.c_str(), &m_Handle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr)) == SQLITE_OK)
+            if (m_Handle != nullptr) {
+                ClearStatements();
+                sqlite3_close_v2(m_Handle);
+                m_Handle = nullptr;
+            }
+
+            m_Connected = (m_ResultCode = sqlite3_open_v2(m_DataBase.c_str(), &m_Handle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr)) == SQLITE_OK;
+
+            if (m_Connected)
                 DoConnected(this);
-            return m_ResultCode == SQLITE_OK;
+
+            return m_Connected;
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CSQLiteConnection::Disconnect() {
             if (m_Handle != nullptr) {
-                DoDisconnected(this);
+                if (m_Connected)
+                    DoDisconnected(this);
+                m_Connected = false;
+                ClearStatements();
                 sqlite3_close_v2(m_Handle);
+                m_Handle = nullptr;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSQLiteConnection::CheckConnected() {
+            if (!Connected()) {
+                if (!Connect())
+                    throw Delphi::Exception::EDBError("%s", GetErrorMessage());
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSQLiteConnection::ClearStatements() {
+            CSQLiteStatement *Statement;
+
+            // Idle statements are finalized before the database is closed. A statement still held by a result or
+            // cursor is detached and finalized on Release(); until then sqlite3_close_v2() keeps the handle alive.
+            for (int i = m_Statements.Count() - 1; i >= 0; i--) {
+                Statement = (CSQLiteStatement *) m_Statements.Items(i);
+                if (Statement->InUse()) {
+                    m_Detached.Add(Statement);
+                } else {
+                    delete Statement;
+                }
+            }
+
+            m_Statements.Clear();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSQLiteConnection::SetStatementCacheSize(int Value) {
+            if (m_StatementCacheSize != Value) {
+                m_StatementCacheSize = Value < 0 ? 0 : Value;
+
+                CSQLiteStatement *Statement;
+                int Index = m_Statements.Count() - 1;
+
+                while (Index >= 0 && m_Statements.Count() > m_StatementCacheSize) {
+                    Statement = (CSQLiteStatement *) m_Statements.Items(Index);
+                    if (!Statement->InUse()) {
+                        m_Statements.Delete(Index);
+                        delete Statement;
+                    }
+                    Index--;
+                }
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        sqlite3_stmt *CSQLiteConnection::Prepare(const CString &SQL) {
+            CSQLiteStatement *Statement;
+
+            for (int i = 0; i < m_Statements.Count(); i++) {
+                Statement = (CSQLiteStatement *) m_Statements.Items(i);
+                if (!Statement->InUse() && Statement->SQL() == SQL) {
+                    if (i > 0)
+                        m_Statements.Move(i, 0);
+                    Statement->InUse(true);
+                    return Statement->Handle();
+                }
+            }
+
+            sqlite3_stmt *stmt = nullptr;
+            if (sqlite3_prepare_v2(m_Handle, SQL.c_str(), (int) SQL.Length() + 1, &stmt, nullptr) != SQLITE_OK) {
+                sqlite3_finalize(stmt);
+                throw Delphi::Exception::EDBError("%s", GetErrorMessage());
+            }
+
+            // Evict the least recently used idle statements to make room.
+            int Index = m_Statements.Count() - 1;
+            while (Index >= 0 && m_Statements.Count() >= m_StatementCacheSize) {
+                Statement = (CSQLiteStatement *) m_Statements.Items(Index);
+                if (!Statement->InUse()) {
+                    m_Statements.Delete(Index);
+                    delete Statement;
+                }
+                Index--;
             }
+
+            if (m_Statements.Count() < m_StatementCacheSize) {
+                Statement = new CSQLiteStatement(SQL, stmt);
+                Statement->InUse(true);
+                m_Statements.Insert(0, Statement);
+            }
+
+            return stmt;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSQLiteConnection::Release(sqlite3_stmt *AHandle) {
+            CSQLiteStatement *Statement;
+
+            for (int i = 0; i < m_Statements.Count(); i++) {
+                Statement = (CSQLiteStatement *) m_Statements.Items(i);
+                if (Statement->Handle() == AHandle) {
+                    sqlite3_reset(AHandle);
+                    sqlite3_clear_bindings(AHandle);
+                    Statement->InUse(false);
+                    return;
+                }
+            }
+
+            for (int i = 0; i < m_Detached.Count(); i++) {
+                Statement = (CSQLiteStatement *) m_Detached.Items(i);
+                if (Statement->Handle() == AHandle) {
+                    m_Detached.Delete(i);
+                    delete Statement;
+                    return;
+                }
+            }
+
+            sqlite3_finalize(AHandle);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSQLiteConnection::Exec(LPCSTR SQL) {
+            CheckConnected();
+            if (sqlite3_exec(m_Handle, SQL, nullptr, nullptr, nullptr) != SQLITE_OK)
+                throw Delphi::Exception::EDBError("%s", GetErrorMessage());
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CSQLiteConnection::BulkInsert(const CString &SQL, const COnSQlLiteBulkRowEvent &OnRow, int BatchSize) {
+            CheckConnected();
+
+            if (BatchSize <= 0)
+                BatchSize = SQLITE_BULK_BATCH_SIZE;
+
+            CCSQLiteParams Params;
+
+            sqlite3_stmt *stmt = Prepare(SQL);
+
+            int Row = 0;
+            int Pending = 0;
+
+            // inside the caller's transaction: a savepoint, so a failure undoes only these rows and nothing is committed
+            const bool Owner = sqlite3_get_autocommit(m_Handle) != 0;
+
+            try {
+                if (Owner) {
+                    BeginTransaction();
+                } else {
+                    Exec("SAVEPOINT bulk_insert");
+                }
+
+                while (OnRow(Row, Params)) {
+                    CSQLiteQuery::Bind(this, stmt, Params, true);
+
+                    if (sqlite3_step(stmt) != SQLITE_DONE)
+                        throw Delphi::Exception::EDBError("%s", GetErrorMessage());
+
+                    sqlite3_reset(stmt);
+                    sqlite3_clear_bindings(stmt);
+                    Params.Clear();
+
+                    Row++;
+
+                    if (Owner && ++Pending == BatchSize) {
+                        Commit();
+                        BeginTransaction();
+                        Pending = 0;
+                    }
+                }
+
+                if (Owner) {
+                    Commit();
+                } else {
+                    Exec("RELEASE bulk_insert");
+                }
+            } catch (...) {
+                if (Owner) {
+                    if (!sqlite3_get_autocommit(m_Handle))
+                        sqlite3_exec(m_Handle, "ROLLBACK", nullptr, nullptr, nullptr);
+                } else if (!sqlite3_get_autocommit(m_Handle)) {
+                    sqlite3_exec(m_Handle, "ROLLBACK TO bulk_insert; RELEASE bulk_insert", nullptr, nullptr, nullptr);
+                }
+                Release(stmt);
+                throw;
+            }
+
+            Release(stmt);
+
+            return Row;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -143,8 +344,13 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CSQLiteResult::Clear() {
-            if (m_Handle != nullptr)
-                sqlite3_finalize(m_Handle);
+            if (m_Handle != nullptr) {
+                if (m_Query != nullptr && m_Query->Connection() != nullptr)
+                    m_Query->Connection()->Release(m_Handle);
+                else
+                    sqlite3_finalize(m_Handle);
+                m_Handle = nullptr;
+            }
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -199,90 +405,101 @@ namespace Delphi {
             if (m_pConnection == nullptr)
                 throw Delphi::Exception::EDBError(_T("Connection has not be empty"));
 
-            if (!m_pConnection->Connected()) {
-                if (!m_pConnection->Connect())
-                    throw Delphi::Exception::EDBError("%s", m_pConnection->GetErrorMessage());
-            }
+            m_pConnection->CheckConnected();
 
-            sqlite3_stmt *stmt = nullptr;
-            int ResultCode = sqlite3_prepare_v2(m_pConnection->Handle(), m_SQL.c_str(), m_SQL.Length() + 1, &stmt, nullptr);
+            sqlite3_stmt *stmt = m_pConnection->Prepare(m_SQL);
 
-            if (ResultCode != SQLITE_OK) {
-                throw Delphi::Exception::EDBError("%s", m_pConnection->GetErrorMessage());
+            try {
+                Bind(m_pConnection, stmt, m_Params);
+            } catch (...) {
+                m_pConnection->Release(stmt);
+                throw;
             }
 
-            for (int i = 0; i < m_Params.Count(); i++) {
+            Added(new CSQLiteResult(this, stmt));
+
+            DoExecuted();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSQLiteQuery::Bind(CSQLiteConnection *AConnection, sqlite3_stmt *AHandle, const CCSQLiteParams &Params,
+                bool StaticText) {
 
-                const CVariant &Value = m_Params[i];
+            const sqlite3_destructor_type TextMode = StaticText ? SQLITE_STATIC : SQLITE_TRANSIENT;
+
+            int ResultCode = SQLITE_OK;
+
+            for (int i = 0; i < Params.Count(); i++) {
+
+                const CVariant &Value = Params[i];
 
                 switch (Value.VType) {
                     case vtEmpty:
-                        ResultCode = sqlite3_bind_null(stmt, i + 1);
+                        ResultCode = sqlite3_bind_null(AHandle, i + 1);
                         break;
                     case vtInteger:
-                        ResultCode = sqlite3_bind_int(stmt, i + 1, Value.varInteger);
+                        ResultCode = sqlite3_bind_int(AHandle, i + 1, Value.varInteger);
                         break;
                     case vtBoolean:
-                        ResultCode = sqlite3_bind_int(stmt, i + 1, Value.varBoolean ? 1 : 0);
+                        ResultCode = sqlite3_bind_int(AHandle, i + 1, Value.varBoolean ? 1 : 0);
                         break;
                     case vtChar:
-                        ResultCode = sqlite3_bind_text(stmt, i + 1, &Value.varChar, 1, SQLITE_TRANSIENT);
+                        ResultCode = sqlite3_bind_text(AHandle, i + 1, &Value.varChar, 1, TextMode);
                         break;
                     case vtDouble:
-                        ResultCode = sqlite3_bind_double(stmt, i + 1, Value.varDouble);
+                        ResultCode = sqlite3_bind_double(AHandle, i + 1, Value.varDouble);
                         break;
                     case vtString:
-                        ResultCode = sqlite3_bind_text(stmt, i + 1, Value.varString->c_str(), Value.varString->Size(), SQLITE_TRANSIENT);
+                        ResultCode = sqlite3_bind_text(AHandle, i + 1, Value.varString->c_str(), Value.varString->Size(), TextMode);
                         break;
                     case vtPointer:
-                        ResultCode = sqlite3_bind_null(stmt, i + 1);
+                        ResultCode = sqlite3_bind_null(AHandle, i + 1);
                         break;
                     case vtPChar:
-                        ResultCode = sqlite3_bind_text(stmt, i + 1, Value.varPChar, -1, SQLITE_TRANSIENT);
+                        ResultCode = sqlite3_bind_text(AHandle, i + 1, Value.varPChar, -1, TextMode);
                         break;
                     case vtObject:
-                        ResultCode = sqlite3_bind_null(stmt, i + 1);
+                        ResultCode = sqlite3_bind_null(AHandle, i + 1);
                         break;
                     case vtUnsigned:
-                        ResultCode = sqlite3_bind_int(stmt, i + 1, Value.varUnsigned);
+                        ResultCode = sqlite3_bind_int(AHandle, i + 1, Value.varUnsigned);
                         break;
                     case vtWideChar:
-                        ResultCode = sqlite3_bind_null(stmt, i + 1);
+                        ResultCode = sqlite3_bind_null(AHandle, i + 1);
                         break;
                     case vtPWideChar:
-                        ResultCode = sqlite3_bind_null(stmt, i + 1);
+                        ResultCode = sqlite3_bind_null(AHandle, i + 1);
                         break;
                     case vtAnsiString:
-                        ResultCode = sqlite3_bind_text(stmt, i + 1, Value.varAnsiString, -1, SQLITE_TRANSIENT);
+                        ResultCode = sqlite3_bind_text(AHandle, i + 1, Value.varAnsiString, -1, TextMode);
                         break;
                     case vtFloat:
-                        ResultCode = sqlite3_bind_double(stmt, i + 1, Value.varFloat);
+                        ResultCode = sqlite3_bind_double(AHandle, i + 1, Value.varFloat);
                         break;
                     case vtVariant:
-                        ResultCode = sqlite3_bind_null(stmt, i + 1);
+                        ResultCode = sqlite3_bind_null(AHandle, i + 1);
                         break;
                     case vtUInt64:
-                        ResultCode = sqlite3_bind_int64(stmt, i + 1, Value.varUInt64);
+                        ResultCode = sqlite3_bind_int64(AHandle, i + 1, Value.varUInt64);
                         break;
                     case vtWideString:
-                        ResultCode = sqlite3_bind_null(stmt, i + 1);
+                        ResultCode = sqlite3_bind_null(AHandle, i + 1);
                         break;
                     case vtInt64:
-                        ResultCode = sqlite3_bind_int64(stmt, i + 1, Value.varInt64);
+                        ResultCode = sqlite3_bind_int64(AHandle, i + 1, Value.varInt64);
                         break;
                     case vtUnicodeString:
-                        ResultCode = sqlite3_bind_text(stmt, i + 1, Value.varUnicodeString->c_str(), Value.varUnicodeString->Size(), SQLITE_TRANSIENT);
+                        ResultCode = sqlite3_bind_text(AHandle, i + 1, Value.varUnicodeString->c_str(), Value.varUnicodeString->Size(), TextMode);
+                        break;
+                    case vtText:
+                        ResultCode = sqlite3_bind_text(AHandle, i + 1, Value.Text(), (int) Value.TextLength(), TextMode);
                         break;
                 }
 
                 if (ResultCode != SQLITE_OK) {
-                    throw Delphi::Exception::EDBError("%s", m_pConnection->GetErrorMessage());
+                    throw Delphi::Exception::EDBError("%s", AConnection->GetErrorMessage());
                 }
             }
-
-            Added(new CSQLiteResult(this, stmt));
-
-            DoExecuted();
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -294,6 +511,85 @@ namespace Delphi {
                 }
             }
         }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CSQLiteCursor --------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CSQLiteCursor::CSQLiteCursor(CSQLiteConnection *AConnection, const CString &ASQL): CObject() {
+            m_pConnection = AConnection;
+            m_Handle = nullptr;
+            m_SQL = ASQL;
+            m_Active = false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CSQLiteCursor::~CSQLiteCursor() {
+            Close();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSQLiteCursor::Open() {
+            if (m_pConnection == nullptr)
+                throw Delphi::Exception::EDBError(_T("Connection has not be empty"));
+
+            Close();
+
+            m_pConnection->CheckConnected();
+
+            m_Handle = m_pConnection->Prepare(m_SQL);
+
+            try {
+                CSQLiteQuery::Bind(m_pConnection, m_Handle, m_Params);
+            } catch (...) {
+                Close();
+                throw;
+            }
+
+            m_Active = true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSQLiteCursor::Close() {
+            if (m_Handle != nullptr) {
+                m_pConnection->Release(m_Handle);
+                m_Handle = nullptr;
+            }
+            m_Active = false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CSQLiteCursor::Next() {
+            if (!m_Active) {
+                if (m_Handle != nullptr)
+                    return false;
+                Open();
+            }
+
+            const int ResultCode = sqlite3_step(m_Handle);
+
+            if (ResultCode == SQLITE_ROW)
+                return true;
+
+            m_Active = false;
+
+            if (ResultCode != SQLITE_DONE)
+                throw Delphi::Exception::EDBError("%s", m_pConnection->GetErrorMessage());
+
+            return false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CString CSQLiteCursor::AsString(int Index) {
+            CString Result;
+            const auto Text = (LPCSTR) sqlite3_column_text(m_Handle, Index);
+            const int Size = sqlite3_column_bytes(m_Handle, Index);
+            if (Size > 0)
+                Result.Create(Text, Size);
+            return Result;
+        }
         //--------------------------------------------------------------------------------------------------------------
 
     }
@@ -61,6 +61,10 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        sigset_t CSignals::m_SavedMask {};
+        bool CSignals::m_MaskSaved = false;
+        //--------------------------------------------------------------------------------------------------------------
+
         CSignals::~CSignals() {
             if (m_Handle != INVALID_HANDLE_VALUE) {
                 ::close(m_Handle);
@@ -150,6 +154,86 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        CPollEventHandler *CSignals::AllocateSignalFD(CPollEventHandlers *AEventHandlers) {
+            sigset_t SigSet;
+
+            /*
+             * Only signals with a handler: a blocked signal is queued even when its action is SIG_IGN,
+             * so ignored signals must stay unblocked to keep being discarded.
+             */
+            sigemptyset(&SigSet);
+            for (int i = 0; i < Count(); ++i) {
+                const auto Signal = Get(i);
+                if (Signal->Handler() && sigaddset(&SigSet, Signal->SigNo()) == -1)
+                    throw EOSError(errno, _T("call sigaddset() failed"));
+            }
+
+            if (sigprocmask(SIG_BLOCK, &SigSet, m_MaskSaved ? nullptr : &m_SavedMask) == -1)
+                throw EOSError(errno, _T("call sigprocmask() failed"));
+
+            m_MaskSaved = true;
+
+            const auto Flags = m_Handle == INVALID_HANDLE_VALUE ? SFD_NONBLOCK | SFD_CLOEXEC : 0;
+            const auto Handle = signalfd(m_Handle, &SigSet, Flags);
+            if (Handle == INVALID_HANDLE_VALUE)
+                throw EOSError(errno, _T("call signalfd() failed"));
+
+            m_Handle = Handle;
+
+            const auto pHandler = AEventHandlers->Add(m_Handle);
+#if defined(_GLIBCXX_RELEASE) && (_GLIBCXX_RELEASE >= 9)
+            pHandler->OnSignalEvent([this](auto && AHandler) { DoSignalFD(AHandler); });
+#else
+            pHandler->OnSignalEvent(std::bind(&CSignals::DoSignalFD, this, _1));
+#endif
+            pHandler->Start(etSignal);
+
+            return pHandler;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSignals::RestoreSigMask() {
+            if (m_MaskSaved)
+                sigprocmask(SIG_SETMASK, &m_SavedMask, nullptr);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSignals::DoSignalFD(CPollEventHandler *AHandler) {
+            struct signalfd_siginfo Buffer[SIG_FD_BATCH_SIZE];
+            siginfo_t Info;
+
+            ssize_t Size;
+
+            while ((Size = ::read(AHandler->Socket(), Buffer, sizeof(Buffer))) > 0) {
+                const auto Count = (size_t) Size / sizeof(struct signalfd_siginfo);
+
+                for (size_t i = 0; i < Count; ++i) {
+                    const struct signalfd_siginfo &ssi = Buffer[i];
+
+                    ZeroMemory(&Info, sizeof(Info));
+
+                    Info.si_signo = (int) ssi.ssi_signo;
+                    Info.si_errno = ssi.ssi_errno;
+                    Info.si_code = ssi.ssi_code;
+                    Info.si_pid = (pid_t) ssi.ssi_pid;
+                    Info.si_uid = (uid_t) ssi.ssi_uid;
+                    Info.si_status = ssi.ssi_status;
+                    Info.si_value.sival_ptr = (void *) ssi.ssi_ptr;
+
+                    const auto Index = IndexOfSigNo(Info.si_signo);
+                    if (Index != -1 && Get(Index)->Handler() != nullptr)
+                        Get(Index)->Handler()(Info.si_signo, &Info, nullptr);
+                }
+
+                if (Count < SIG_FD_BATCH_SIZE)
+                    break;
+            }
+
+            if (Size == -1 && errno != EAGAIN && errno != EINTR)
+                throw EOSError(errno, _T("call read() for signalfd failed"));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         int CSignals::IndexOfSigNo(int SigNo) const {
 
             for (int i = 0; i < Count(); ++i) {
@@ -25,7 +25,11 @@ Author:
 #include "delphi/Sockets.hpp"
 //----------------------------------------------------------------------------------------------------------------------
 
+#include <sys/random.h>
+//----------------------------------------------------------------------------------------------------------------------
+
 #define EVENT_SIZE 512
+#define BUSY_POLL_MIN_WINDOW 8
 #define WEBSOCKET_ERROR_MESSAGE "Invalid WebSocket header size (%s)."
 #define WEBSOCKET_PROTOCOL_ERROR_MESSAGE "WebSocket protocol violation (%s)."
 #define SSL_NOT_INITIALIZED "SSL not initialized."
@@ -191,15 +195,17 @@ namespace Delphi {
                 SSL_CTX_use_PrivateKey_file(ctx, APrivateKeyFile, SSL_FILETYPE_PEM);
             }
 
-            return ::SSL_new(ctx);
+            SSL *ssl = ::SSL_new(ctx);
+            // The SSL object holds its own reference to the context
+            ::SSL_CTX_free(ctx);
+
+            return ssl;
         }
         //--------------------------------------------------------------------------------------------------------------
 
         void CStack::SSLFree(SSL *ssl) {
             if (ssl != nullptr) {
-                SSL_CTX *ctx = ::SSL_get_SSL_CTX(ssl);
                 ::SSL_free(ssl);
-                ::SSL_CTX_free(ctx);
             }
         }
         //--------------------------------------------------------------------------------------------------------------
@@ -623,6 +629,161 @@ namespace Delphi {
                     throw EOSError(errno, _T("fcntl failed (F_SETFL): "));
             }
         }
+#ifdef WITH_SSL
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CSSLSession -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CSSLSession: public CObject {
+        public:
+
+            CString Key;
+
+            SSL_SESSION *Session;
+
+            CSSLSession(const CString &AKey, SSL_SESSION *ASession): CObject(), Key(AKey), Session(ASession) {
+
+            }
+
+            ~CSSLSession() override {
+                ::SSL_SESSION_free(Session);
+            }
+
+        };
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CSSLContext -----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CSSLContext::CSSLContext(CSSLMethod AMethod): CObject() {
+            m_pContext = nullptr;
+            m_Method = AMethod;
+            m_KTLS = false;
+            m_SessionCacheSize = SSL_SESSION_CACHE_SIZE;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CSSLContext::~CSSLContext() {
+            Clear();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSSLContext::Load() {
+            TCHAR szError[256] = {0};
+
+            SSL_CTX *ctx = ::SSL_CTX_new(m_Method == sslServer ? TLS_server_method() : TLS_client_method());
+
+            if (ctx == nullptr) {
+                ERR_error_string_n(ERR_get_error(), szError, sizeof(szError));
+                throw ESocketError(szError);
+            }
+
+            uint64_t options = 0;
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+            options |= SSL_OP_IGNORE_UNEXPECTED_EOF;
+#endif
+#ifdef SSL_OP_ENABLE_KTLS
+            if (m_KTLS)
+                options |= SSL_OP_ENABLE_KTLS;
+#endif
+            ::SSL_CTX_set_options(ctx, options);
+            ::SSL_CTX_set_mode(ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+            if (m_Method == sslServer) {
+                ::SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+                ::SSL_CTX_sess_set_cache_size(ctx, m_SessionCacheSize);
+                ::SSL_CTX_set_session_id_context(ctx, (const unsigned char *) SSL_SESSION_ID_CONTEXT, sizeof(SSL_SESSION_ID_CONTEXT) - 1);
+            } else {
+                ::SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            }
+
+            if ((!m_CertificateFile.IsEmpty() && ::SSL_CTX_use_certificate_chain_file(ctx, m_CertificateFile.c_str()) != 1) ||
+                (!m_PrivateKeyFile.IsEmpty() && ::SSL_CTX_use_PrivateKey_file(ctx, m_PrivateKeyFile.c_str(), SSL_FILETYPE_PEM) != 1)) {
+                ERR_error_string_n(ERR_get_error(), szError, sizeof(szError));
+                ::SSL_CTX_free(ctx);
+                throw ESocketError(szError);
+            }
+
+            // Connections created from the old context keep it alive until they are freed
+            if (m_pContext != nullptr)
+                ::SSL_CTX_free(m_pContext);
+
+            m_pContext = ctx;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSSLContext::Clear() {
+            ClearSessions();
+            if (m_pContext != nullptr) {
+                ::SSL_CTX_free(m_pContext);
+                m_pContext = nullptr;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        SSL *CSSLContext::New() {
+            if (m_pContext == nullptr)
+                Load();
+            return ::SSL_new(m_pContext);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSSLContext::ClearSessions() {
+            for (int i = 0; i < m_Sessions.Count(); i++)
+                delete (CSSLSession *) m_Sessions.Items(i);
+            m_Sessions.Clear();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int CSSLContext::IndexOfSession(const CString &Key) const {
+            for (int i = 0; i < m_Sessions.Count(); i++) {
+                if (((CSSLSession *) m_Sessions.Items(i))->Key == Key)
+                    return i;
+            }
+            return -1;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSSLContext::SaveSession(SSL *ssl, const CString &Key) {
+            if (ssl == nullptr || Key.IsEmpty())
+                return;
+
+            SSL_SESSION *session = ::SSL_get1_session(ssl);
+            if (session == nullptr)
+                return;
+
+            if (::SSL_SESSION_is_resumable(session) != 1) {
+                ::SSL_SESSION_free(session);
+                return;
+            }
+
+            const auto index = IndexOfSession(Key);
+            if (index == -1) {
+                m_Sessions.Add(new CSSLSession(Key, session));
+            } else {
+                auto pItem = (CSSLSession *) m_Sessions.Items(index);
+                ::SSL_SESSION_free(pItem->Session);
+                pItem->Session = session;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CSSLContext::RestoreSession(SSL *ssl, const CString &Key) {
+            if (ssl == nullptr || Key.IsEmpty())
+                return false;
+
+            const auto index = IndexOfSession(Key);
+            if (index == -1)
+                return false;
+
+            return ::SSL_set_session(ssl, ((CSSLSession *) m_Sessions.Items(index))->Session) == 1;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+#endif
 
         //--------------------------------------------------------------------------------------------------------------
 
@@ -698,6 +859,49 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        //-- CFreeList -------------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        void *CFreeList::Allocate(size_t Size, size_t BlockSize) {
+            if (Size == BlockSize && Head != nullptr) {
+                void *Block = Head;
+                Head = *static_cast<void **> (Block);
+                Count--;
+                return Block;
+            }
+            return ::operator new(Size);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CFreeList::Release(void *Block, size_t Size, size_t BlockSize) {
+            if (Block == nullptr)
+                return;
+
+            if (Size == BlockSize && Count < FreeListCapacityDefault && !Drained) {
+                *static_cast<void **> (Block) = Head;
+                Head = Block;
+                Count++;
+            } else {
+                ::operator delete(Block);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CFreeList::Drain() {
+            Drained = true;
+
+            while (Head != nullptr) {
+                void *Block = Head;
+                Head = *static_cast<void **> (Block);
+                ::operator delete(Block);
+            }
+
+            Count = 0;
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
         //-- CSimpleBuffer ---------------------------------------------------------------------------------------------
 
         //--------------------------------------------------------------------------------------------------------------
@@ -816,6 +1020,7 @@ namespace Delphi {
 #ifdef WITH_SSL
             m_pSSL = nullptr;
             m_SSLMethod = sslNotUsed;
+            m_pSSLContext = nullptr;
 #endif
             m_Port = 0;
             m_PeerPort = 0;
@@ -832,6 +1037,14 @@ namespace Delphi {
 
             m_ClientPortMin = 0;
             m_ClientPortMax = 0;
+
+            m_BackLog = SOMAXCONN;
+            m_DeferAccept = 0;
+            m_FastOpen = 0;
+            m_BusyPoll = 0;
+            m_IncomingCPU = -1;
+
+            m_ReusePort = false;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -842,11 +1055,18 @@ namespace Delphi {
 #endif
         }
         //--------------------------------------------------------------------------------------------------------------
+
+        DEFINE_FREE_LIST_ALLOCATOR(CSocketHandle)
+        //--------------------------------------------------------------------------------------------------------------
 #ifdef WITH_SSL
         void CSocketHandle::AllocateSSL() {
             if (m_SSLMethod != sslNotUsed) {
-                if (m_pSSL == nullptr)
-                    m_pSSL = CStack::SSLNew(m_SSLMethod == sslServer);
+                if (m_pSSL == nullptr) {
+                    if (m_pSSLContext != nullptr && m_pSSLContext->Method() == m_SSLMethod)
+                        m_pSSL = m_pSSLContext->New();
+                    else
+                        m_pSSL = CStack::SSLNew(m_SSLMethod == sslServer);
+                }
                 CStack::SSLAllocate(m_pSSL, m_Handle);
             }
         }
@@ -854,6 +1074,8 @@ namespace Delphi {
 
         void CSocketHandle::ShutdownSSL() {
             if (m_pSSL != nullptr) {
+                if (m_pSSLContext != nullptr && m_SSLMethod == sslClient)
+                    m_pSSLContext->SaveSession(m_pSSL, m_SessionKey);
                 CStack::SSLShutdown(m_pSSL);
             }
         }
@@ -881,6 +1103,23 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CSocketHandle::AcceptSSL() {
+            if (m_pSSL == nullptr)
+                throw ESocketError(SSL_NOT_INITIALIZED);
+            // The handshake is driven by the first SSL_read()/SSL_write() on the non-blocking socket
+            ::SSL_set_accept_state(m_pSSL);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CSocketHandle::KTLSSend() const {
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L) && defined(BIO_get_ktls_send)
+            return m_pSSL != nullptr && BIO_get_ktls_send(::SSL_get_wbio(m_pSSL)) != 0;
+#else
+            return false;
+#endif
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         uint64_t CSocketHandle::GetOptionsSSL() {
             if (m_pSSL == nullptr)
                 throw ESocketError(SSL_NOT_INITIALIZED);
@@ -989,6 +1228,34 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CSocketHandle::Adopt(CSocket AHandle) {
+            CloseSocket();
+            if (HandleAllocated())
+                Reset();
+
+            m_Handle = AHandle;
+            m_HandleAllocated = true;
+
+            GetSockOpt(SOL_SOCKET, SO_TYPE, &m_SocketType, sizeof(m_SocketType));
+
+            GStack->SetNonBloking(m_Handle);
+            m_Nonblocking = true;
+
+            UpdateBindingLocal();
+#ifdef WITH_SSL
+            AllocateSSL();
+#endif
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSocketHandle::ReleaseSocket() {
+            if (HandleAllocated()) {
+                GStack->CloseSocket(m_Handle);
+                Reset(false);
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         void CSocketHandle::CloseSocket(bool AResetLocal) {
             if (HandleAllocated()) {
 #ifdef WITH_SSL
@@ -1064,13 +1331,34 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CSocketHandle::Listen() const {
+            Listen(m_BackLog > 0 ? m_BackLog : SOMAXCONN);
+
+            if (m_DeferAccept > 0)
+                SetSockOpt(IPPROTO_TCP, TCP_DEFER_ACCEPT, &m_DeferAccept, sizeof(m_DeferAccept));
+
+            if (m_FastOpen > 0)
+                SetSockOpt(IPPROTO_TCP, TCP_FASTOPEN, &m_FastOpen, sizeof(m_FastOpen));
+
+            if (m_BusyPoll > 0)
+                SetSockOpt(SOL_SOCKET, SO_BUSY_POLL, &m_BusyPoll, sizeof(m_BusyPoll));
+
+            if (m_IncomingCPU >= 0)
+                SetSockOpt(SOL_SOCKET, SO_INCOMING_CPU, &m_IncomingCPU, sizeof(m_IncomingCPU));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         int CSocketHandle::Connect(sa_family_t AFamily, LPCSTR AHost, unsigned short APort) {
             char IP[NI_MAXIP] = {};
-            constexpr int Ignore[] = {EINPROGRESS, EALREADY};
-
             GStack->GetIPByName(AHost, IP, sizeof(IP));
+            return Connect(AFamily, AHost, IP, APort);
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
-            const int SocketError = GStack->Connect(Handle(), AFamily, IP, APort);
+        int CSocketHandle::Connect(sa_family_t AFamily, LPCSTR AHost, LPCSTR AIP, unsigned short APort) {
+            constexpr int Ignore[] = {EINPROGRESS, EALREADY};
+
+            const int SocketError = GStack->Connect(Handle(), AFamily, AIP, APort);
 
             if (!GStack->CheckForSocketError(SocketError, Ignore, chARRAY(Ignore), egSystem)) {
                 UpdateBindingLocal();
@@ -1078,6 +1366,13 @@ namespace Delphi {
             }
 #ifdef WITH_SSL
             if (Assigned(m_pSSL)) {
+                struct in_addr addr = {};
+                if (::inet_pton(AF_INET, AHost, &addr) != 1)
+                    ::SSL_set_tlsext_host_name(m_pSSL, AHost);
+                if (m_pSSLContext != nullptr) {
+                    m_SessionKey.Format("%s:%d", AHost, APort);
+                    m_pSSLContext->RestoreSession(m_pSSL, m_SessionKey);
+                }
                 ConnectSSL();
 #if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
                 SetOptionsSSL(SSL_OP_IGNORE_UNEXPECTED_EOF);
@@ -1161,7 +1456,16 @@ namespace Delphi {
 #ifdef WITH_SSL
             if (m_pSSL != nullptr) {
                 const auto offset = *AOffSet;
-                const auto result = Delphi::Socket::CStack::SSLSendFile(m_pSSL, AHandle, offset, ASize, AFlags);
+                ssize_t result;
+                if (KTLSSend()) {
+                    result = Delphi::Socket::CStack::SSLSendFile(m_pSSL, AHandle, offset, ASize, AFlags);
+                } else {
+                    // Without kernel TLS the file is encrypted in user space
+                    char buffer[SSL3_RT_MAX_PLAIN_LENGTH];
+                    result = ::pread(AHandle, buffer, ASize < sizeof(buffer) ? ASize : sizeof(buffer), offset);
+                    if (result > 0)
+                        result = Delphi::Socket::CStack::SSLSend(m_pSSL, buffer, (int) result);
+                }
                 if (result > 0) {
                     *AOffSet = offset + result;
                 }
@@ -1286,6 +1590,95 @@ namespace Delphi {
 
             return pResult;
         }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSocketHandles::ExportHandles(CString &Value) const {
+            for (int i = 0; i < Count(); ++i) {
+                const auto pHandle = Handles(i);
+                if (pHandle->HandleAllocated()) {
+                    Value << (int) pHandle->Handle();
+                    Value << ';';
+                }
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static CSocket GInheritedSockets[SOCKET_INHERIT_MAX];
+        static int GInheritedCount = -1;
+
+        static void LoadInheritedSockets() {
+            if (GInheritedCount != -1)
+                return;
+
+            GInheritedCount = 0;
+
+            LPCSTR Value = ::getenv(SOCKET_INHERIT_ENV);
+            if (Value == nullptr)
+                return;
+
+            while (*Value != '\0' && GInheritedCount < SOCKET_INHERIT_MAX) {
+                char *End = nullptr;
+                const long Handle = ::strtol(Value, &End, 10);
+
+                if (End == Value)
+                    break;
+
+                int Listening = 0;
+                socklen_t Length = sizeof(Listening);
+
+                if (Handle >= 0 && ::getsockopt((CSocket) Handle, SOL_SOCKET, SO_ACCEPTCONN, &Listening, &Length) == 0 && Listening)
+                    GInheritedSockets[GInheritedCount++] = (CSocket) Handle;
+
+                Value = *End == ';' ? End + 1 : End;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CSocket CSocketHandles::InheritedSocket(LPCSTR AIP, unsigned short APort) {
+            LoadInheritedSockets();
+
+            const bool AnyIP = AIP == nullptr || AIP[0] == '\0' || SameText(AIP, "0.0.0.0");
+
+            for (int i = 0; i < GInheritedCount; ++i) {
+                const CSocket Handle = GInheritedSockets[i];
+
+                if (Handle == INVALID_SOCKET)
+                    continue;
+
+                struct sockaddr_storage Storage = {};
+                socklen_t Length = sizeof(Storage);
+
+                // Bindings, Accept() and the peer names are IPv4 only: an AF_INET6 listener (dual-stack or not)
+                // is left to CloseInheritedSockets() and the binding opens a socket of its own
+                if (::getsockname(Handle, (LPSOCKADDR) &Storage, &Length) == -1 || Storage.ss_family != AF_INET)
+                    continue;
+
+                const auto &Name = *(SOCKADDR_IN *) &Storage;
+
+                if (ntohs(Name.sin_port) != APort)
+                    continue;
+
+                if (AnyIP ? Name.sin_addr.s_addr == htonl(INADDR_ANY) : Name.sin_addr.s_addr == inet_addr(AIP)) {
+                    GInheritedSockets[i] = INVALID_SOCKET;
+                    return Handle;
+                }
+            }
+
+            return INVALID_SOCKET;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CSocketHandles::CloseInheritedSockets() {
+            LoadInheritedSockets();
+
+            for (int i = 0; i < GInheritedCount; ++i) {
+                if (GInheritedSockets[i] != INVALID_SOCKET)
+                    GStack->CloseSocket(GInheritedSockets[i]);
+            }
+
+            GInheritedCount = 0;
+            ::unsetenv(SOCKET_INHERIT_ENV);
+        }
 
         //--------------------------------------------------------------------------------------------------------------
 
@@ -1302,6 +1695,9 @@ namespace Delphi {
             CIOHandlerSocket::Close();
         }
         //--------------------------------------------------------------------------------------------------------------
+
+        DEFINE_FREE_LIST_ALLOCATOR(CIOHandlerSocket)
+        //--------------------------------------------------------------------------------------------------------------
 #ifdef WITH_SSL
         void CIOHandlerSocket::Open(CSSLMethod SSLMethod) {
             if (m_pBinding == nullptr) {
@@ -1491,10 +1887,9 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         int CPollManager::IndexOfConnection(CPollConnection *AConnection) {
-            for (int i = 0; i < GetCount(); ++i)
-                if (Items(i) == AConnection)
-                    return i;
-            return -1;
+            if (!Contains(AConnection))
+                return -1;
+            return AConnection->Index();
         }
 
         //--------------------------------------------------------------------------------------------------------------
@@ -1503,6 +1898,25 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        struct CTCPMetrics {
+            CMetricCounter *BytesReceived;
+            CMetricCounter *BytesSent;
+            CMetricCounter *Accepted;
+            CMetricGauge *Active;
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        static const CTCPMetrics &TCPMetrics() {
+            static const CTCPMetrics Metrics = {
+                CMetricsRegistry::Default().Counter("delphi_tcp_received_bytes_total", "Bytes received over TCP connections."),
+                CMetricsRegistry::Default().Counter("delphi_tcp_sent_bytes_total", "Bytes sent over TCP connections."),
+                CMetricsRegistry::Default().Counter("delphi_tcp_server_connections_total", "Server connections accepted."),
+                CMetricsRegistry::Default().Gauge("delphi_tcp_server_connections", "Server connections currently open.")
+            };
+            return Metrics;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         CTCPConnection::CTCPConnection(CPollManager *AManager): CPollConnection(AManager) {
             m_Clock = 0;
 
@@ -1726,6 +2140,7 @@ namespace Delphi {
 #endif
                             CheckWriteResult(byteCount);
                             DoWork(wmWrite, byteCount);
+                            TCPMetrics().BytesSent->Inc(byteCount);
                             pos += byteCount;
                         } while (pos < AByteCount);
                     } catch (...) {
@@ -1773,6 +2188,9 @@ namespace Delphi {
                 }
 
                 CheckWriteResult(byteCount);
+
+                if (byteCount > 0)
+                    TCPMetrics().BytesSent->Inc(byteCount);
             }
 
             return byteCount;
@@ -1915,7 +2333,7 @@ namespace Delphi {
                 off_t offset = AOffSet;
 
                 while (byteTotal < AByteCount) {
-                    byteCount = m_pIOHandler->SendFile(AHandle, &offset, AByteCount, AFlags);
+                    byteCount = m_pIOHandler->SendFile(AHandle, &offset, AByteCount - byteTotal, AFlags);
 #ifdef WITH_SSL
                     if (m_UsedSSL) {
                         constexpr unsigned long Ignore[] = {SSL_ERROR_NONE, SSL_ERROR_WANT_WRITE};
@@ -1933,6 +2351,8 @@ namespace Delphi {
                     CheckWriteResult(byteCount);
                     byteTotal += byteCount;
                 }
+
+                TCPMetrics().BytesSent->Inc(byteTotal);
             }
 
             return byteTotal;
@@ -2109,6 +2529,7 @@ namespace Delphi {
                 }
 #endif
                 if (AByteCount > 0) {
+                    TCPMetrics().BytesReceived->Inc(AByteCount);
                     m_RecvBuffer.Size((size_t) AByteCount);
                     m_InputBuffer.Seek(0, soEnd);
                     m_InputBuffer.WriteBuffer(m_RecvBuffer.Memory(), m_RecvBuffer.Size());
@@ -2745,12 +3166,20 @@ namespace Delphi {
         CTCPServerConnection::CTCPServerConnection(CPollSocketServer *AServer):
                 CWebSocketConnection(AServer) {
             m_pServer = AServer;
+
+            TCPMetrics().Accepted->Inc();
+            TCPMetrics().Active->Inc();
         }
         //--------------------------------------------------------------------------------------------------------------
 
         CTCPServerConnection::~CTCPServerConnection() {
             m_pServer = nullptr;
+
+            TCPMetrics().Active->Dec();
         }
+        //--------------------------------------------------------------------------------------------------------------
+
+        DEFINE_FREE_LIST_ALLOCATOR(CTCPServerConnection)
 
         //--------------------------------------------------------------------------------------------------------------
 
@@ -2783,17 +3212,31 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+#ifdef WITH_SSL
+        CIOHandlerSocket *CServerIOHandler::Accept(CSocket ASocket, int AFlags, CSSLContext *AContext) {
+#else
         CIOHandlerSocket *CServerIOHandler::Accept(CSocket ASocket, int AFlags) {
+#endif
             CIOHandlerSocket *pResult = nullptr;
 
             auto pIOHandler = new CIOHandlerSocket();
 #ifdef WITH_SSL
-            pIOHandler->Open(sslNotUsed);
+            const bool bUsedSSL = AContext != nullptr && AContext->Active();
+            pIOHandler->Open(bUsedSSL ? sslServer : sslNotUsed);
+            if (bUsedSSL)
+                pIOHandler->Binding()->SSLContext(AContext);
 #else
             pIOHandler->Open();
 #endif
-            if (pIOHandler->Binding()->Accept(ASocket, AFlags))
+            if (pIOHandler->Binding()->Accept(ASocket, AFlags)) {
+#ifdef WITH_SSL
+                if (bUsedSSL) {
+                    pIOHandler->Binding()->AllocateSSL();
+                    pIOHandler->Binding()->AcceptSSL();
+                }
+#endif
                 return pIOHandler;
+            }
             else {
                 FreeAndNil(pIOHandler);
                 pResult = nullptr;
@@ -3586,8 +4029,10 @@ namespace Delphi {
                     for (int i = 0; i < Bindings()->Count(); ++i) {
                         Bindings()->Handles(i)->AllocateSocket(SOCK_STREAM, IPPROTO_IP, 0);
                         Bindings()->Handles(i)->SetSockOpt(SOL_SOCKET, SO_REUSEADDR, (void *) &SO_True, sizeof(SO_True));
+                        if (Bindings()->Handles(i)->ReusePort())
+                            Bindings()->Handles(i)->SetSockOpt(SOL_SOCKET, SO_REUSEPORT, (void *) &SO_True, sizeof(SO_True));
                         Bindings()->Handles(i)->Bind();
-                        Bindings()->Handles(i)->Listen(SOMAXCONN);
+                        Bindings()->Handles(i)->Listen();
 
                         const auto pListenerThread = new CListenerThread(this, Bindings()->Handles(i));
                         m_ListenerThreads.Add(pListenerThread);
@@ -3918,6 +4363,9 @@ namespace Delphi {
             m_TimeOut = INFINITE;
             m_pEventList = nullptr;
             m_EventSize = AEventSize;
+            m_BusyPoll = 0;
+            m_SpinWindow = 0;
+            ResetCounters();
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -3932,6 +4380,28 @@ namespace Delphi {
             m_Handle = Source.m_Handle;
             m_TimeOut = Source.m_TimeOut;
             m_EventSize = Source.m_EventSize;
+            m_BusyPoll = Source.m_BusyPoll;
+            m_SpinWindow = Source.m_BusyPoll;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CPollStack::SetEventSize(int Value) {
+            if (Value <= 0)
+                throw ExceptionFrm(_T("Invalid event batch size: %d."), Value);
+
+            if (m_EventSize != Value) {
+                m_EventSize = Value;
+                delete [] m_pEventList;
+                m_pEventList = nullptr;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CPollStack::ResetCounters() {
+            m_Wakeups = 0;
+            m_EventCount = 0;
+            m_IdleTime = 0;
+            m_SpinTime = 0;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -3997,38 +4467,92 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        int CPollStack::Wait(const sigset_t *ASigMask) {
-            int result;
-
-            if (m_Handle == INVALID_SOCKET)
-                Create(0);
-
-            if (!Assigned(m_pEventList))
-                m_pEventList = new CPollEvent[m_EventSize];
+        static uint64_t PollMicroSeconds() {
+            struct timespec ts = {0, 0};
+            ::clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+        }
+        //--------------------------------------------------------------------------------------------------------------
 
+        int CPollStack::Poll(int ATimeOut, const sigset_t *ASigMask) {
             if (ASigMask == nullptr)
-                result = epoll_wait(m_Handle, m_pEventList, m_EventSize, m_TimeOut);
-            else
-                result = epoll_pwait(m_Handle, m_pEventList, m_EventSize, m_TimeOut, ASigMask);
+                return epoll_wait(m_Handle, m_pEventList, m_EventSize, ATimeOut);
 
-            return result;
+            return epoll_pwait(m_Handle, m_pEventList, m_EventSize, ATimeOut, ASigMask);
         }
         //--------------------------------------------------------------------------------------------------------------
 
-        CPollEvent *CPollStack::GetEvent(int Index) {
-            if ((Index < 0) || (m_pEventList == nullptr) || (Index >= m_EventSize))
-                throw ExceptionFrm(SListIndexError, Index);
-            return &m_pEventList[Index];
-        }
+        int CPollStack::Spin(const sigset_t *ASigMask) {
+            const uint64_t Start = PollMicroSeconds();
+            uint64_t Now;
 
-        //--------------------------------------------------------------------------------------------------------------
+            int result;
 
-        //-- CPollEventHandler -----------------------------------------------------------------------------------------
+            do {
+                result = Poll(0, ASigMask);
+                Now = PollMicroSeconds();
+            } while (result == 0 && Now - Start < (uint64_t) m_SpinWindow);
+
+            m_SpinTime += Now - Start;
 
+            return result;
+        }
         //--------------------------------------------------------------------------------------------------------------
 
-        CPollEventHandler::CPollEventHandler(CPollEventHandlers *AEventHandlers, CSocket ASocket):
-                CCollectionItem(AEventHandlers) {
+        int CPollStack::Wait(const sigset_t *ASigMask) {
+            int result = 0;
+
+            if (m_Handle == INVALID_SOCKET)
+                Create(0);
+
+            if (!Assigned(m_pEventList))
+                m_pEventList = new CPollEvent[m_EventSize];
+
+            if (m_BusyPoll > 0 && m_TimeOut != 0)
+                result = Spin(ASigMask);
+
+            if (result == 0) {
+                const uint64_t Start = PollMicroSeconds();
+                result = Poll(m_TimeOut, ASigMask);
+                const uint64_t Elapsed = PollMicroSeconds() - Start;
+
+                m_IdleTime += Elapsed;
+
+                // Adapt the spin window to the observed gap: stretch it when events arrived soon after the spin
+                // gave up, shrink it when the gap is longer than the busy-poll budget
+                if (m_BusyPoll > 0 && m_TimeOut != 0) {
+                    const uint64_t Gap = m_SpinWindow + Elapsed;
+                    if (result > 0 && Gap <= (uint64_t) m_BusyPoll) {
+                        m_SpinWindow = Gap * 2 > (uint64_t) m_BusyPoll ? m_BusyPoll : (int) Gap * 2;
+                    } else {
+                        m_SpinWindow = m_SpinWindow / 2 < BUSY_POLL_MIN_WINDOW ? BUSY_POLL_MIN_WINDOW : m_SpinWindow / 2;
+                    }
+                }
+            }
+
+            if (result > 0) {
+                m_Wakeups++;
+                m_EventCount += result;
+            }
+
+            return result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CPollEvent *CPollStack::GetEvent(int Index) {
+            if ((Index < 0) || (m_pEventList == nullptr) || (Index >= m_EventSize))
+                throw ExceptionFrm(SListIndexError, Index);
+            return &m_pEventList[Index];
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- CPollEventHandler -----------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        CPollEventHandler::CPollEventHandler(CPollEventHandlers *AEventHandlers, CSocket ASocket):
+                CCollectionItem(AEventHandlers) {
             m_Socket = ASocket;
             m_Events = 0;
             m_TimeStamp = 0;
@@ -4036,6 +4560,7 @@ namespace Delphi {
             m_pBinding = nullptr;
             m_pEventHandlers = AEventHandlers;
             m_OnTimerEvent = nullptr;
+            m_OnSignalEvent = nullptr;
             m_OnTimeOutEvent = nullptr;
             m_OnAcceptEvent = nullptr;
             m_OnConnectEvent = nullptr;
@@ -4052,6 +4577,9 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        DEFINE_FREE_LIST_ALLOCATOR(CPollEventHandler)
+        //--------------------------------------------------------------------------------------------------------------
+
         void CPollEventHandler::ClearBinding() {
             if (Assigned(m_pBinding)) {
                 CPollConnection *pTemp = m_pBinding;
@@ -4074,6 +4602,7 @@ namespace Delphi {
                         break;
 
                     case etTimer:
+                    case etSignal:
                     case etAccept:
                         m_Events = EPOLLIN;
                         m_pEventHandlers->PollAdd(this);
@@ -4105,6 +4634,7 @@ namespace Delphi {
                         if (m_EventType != etNull) {
                             m_pEventHandlers->PollDel(this);
                         }
+                        m_pEventHandlers->m_StoppedCount++;
                         break;
                 }
 
@@ -4163,6 +4693,8 @@ namespace Delphi {
         void CPollEventHandler::Fault() {
             m_Socket = INVALID_SOCKET;
             m_EventType = etDelete;
+            if (m_pEventHandlers != nullptr)
+                m_pEventHandlers->m_StoppedCount++;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -4172,6 +4704,12 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CPollEventHandler::DoSignalEvent() {
+            if (m_OnSignalEvent != nullptr)
+                m_OnSignalEvent(this);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         void CPollEventHandler::DoTimeOutEvent() {
             if (m_OnTimeOutEvent != nullptr)
                 m_OnTimeOutEvent(this);
@@ -4220,10 +4758,26 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         CPollEventHandlers::CPollEventHandlers(): CCollection(this) {
+            m_pResolver = nullptr;
+            m_StoppedCount = 0;
+            m_TimeOutCheck = 0;
             m_OnException = nullptr;
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        CPollEventHandlers::~CPollEventHandlers() {
+            delete m_pResolver;
+            m_pResolver = nullptr;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CDNSResolver *CPollEventHandlers::GetResolver() {
+            if (m_pResolver == nullptr)
+                m_pResolver = new CDNSResolver(this);
+            return m_pResolver;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         CPollEventHandler *CPollEventHandlers::GetItem(int AIndex) const {
             return dynamic_cast<CPollEventHandler *>(inherited::GetItem(AIndex));
         }
@@ -4397,6 +4951,884 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+        //-- CDNSResolver ----------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        static int64_t DNSTickCount() {
+            struct timespec ts = {0, 0};
+            ::clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static CString DNSNormalizeName(const CString &Host) {
+            const CString Result(Host.Lower());
+            if (Result.Length() > 1 && Result.back() == '.')
+                return Result.SubString(0, Result.Length() - 1);
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static void DNSSplitFields(const CString &Line, CStringList &Fields) {
+            CString Field;
+
+            for (size_t i = 0; i < Line.Length(); i++) {
+                const TCHAR C = Line.at(i);
+                if (C == '#')
+                    break;
+                if (C == ' ' || C == '\t' || C == '\r') {
+                    if (!Field.IsEmpty()) {
+                        Fields.Add(Field);
+                        Field.Clear();
+                    }
+                } else {
+                    Field.Append(C);
+                }
+            }
+
+            if (!Field.IsEmpty())
+                Fields.Add(Field);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static bool DNSValidName(const CString &Name) {
+            size_t Label = 0;
+
+            if (Name.IsEmpty() || Name.Length() > 253)
+                return false;
+
+            for (size_t i = 0; i < Name.Length(); i++) {
+                if (Name.at(i) == '.') {
+                    if (Label == 0)
+                        return false;
+                    Label = 0;
+                } else if (++Label > 63) {
+                    return false;
+                }
+            }
+
+            return Label > 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static bool DNSParseServer(const CString &Server, struct sockaddr_in &Addr) {
+            CString Host(Server);
+            unsigned short Port = DNS_PORT;
+
+            const size_t Pos = Server.Find(':');
+            if (Pos != CString::npos) {
+                Host = Server.SubString(0, Pos);
+                Port = (unsigned short) StrToIntDef(Server.SubString(Pos + 1).c_str(), DNS_PORT);
+            }
+
+            Addr = {};
+            Addr.sin_family = AF_INET;
+            Addr.sin_port = htons(Port);
+
+            return ::inet_pton(AF_INET, Host.c_str(), &Addr.sin_addr) == 1;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static bool DNSSkipName(const unsigned char *ABuffer, size_t ASize, size_t &APos) {
+            while (APos < ASize) {
+                const unsigned char Length = ABuffer[APos];
+                if (Length == 0) {
+                    APos++;
+                    return true;
+                }
+                if ((Length & 0xC0u) == 0xC0u) {
+                    APos += 2;
+                    return APos <= ASize;
+                }
+                APos += Length + 1;
+            }
+            return false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static bool DNSReadName(const unsigned char *ABuffer, size_t ASize, size_t APos, CString &Name) {
+            int Jumps = 0;
+
+            Name.Clear();
+
+            while (APos < ASize) {
+                const unsigned char Length = ABuffer[APos];
+
+                if (Length == 0)
+                    return true;
+
+                if ((Length & 0xC0u) == 0xC0u) {
+                    if (APos + 1 >= ASize || ++Jumps > 16)
+                        return false;
+                    APos = ((Length & 0x3Fu) << 8u) | ABuffer[APos + 1];
+                    continue;
+                }
+
+                if (APos + 1 + Length > ASize)
+                    return false;
+
+                if (!Name.IsEmpty())
+                    Name.Append('.');
+
+                for (size_t i = APos + 1; i <= APos + Length; i++)
+                    Name.Append((TCHAR) ::tolower(ABuffer[i]));
+
+                APos += Length + 1;
+            }
+
+            return false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static uint16_t DNSReadWord(const unsigned char *ABuffer) {
+            return (uint16_t) ((ABuffer[0] << 8u) | ABuffer[1]);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static uint32_t DNSReadLong(const unsigned char *ABuffer) {
+            return ((uint32_t) ABuffer[0] << 24u) | ((uint32_t) ABuffer[1] << 16u) | ((uint32_t) ABuffer[2] << 8u) | ABuffer[3];
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        /**
+         * Returns 0 with the first A record, HOST_NOT_FOUND or NO_DATA with the negative TTL from
+         * the SOA record (or -1 when there is none), TRY_AGAIN on server failure and -1 when the
+         * packet does not answer AName.
+         */
+        static int DNSParseResponse(const unsigned char *ABuffer, size_t ASize, const CString &AName, in_addr_t &AAddr, int &ATTL) {
+            if (ASize < 12)
+                return -1;
+
+            const uint16_t Flags = DNSReadWord(ABuffer + 2);
+            const uint16_t QDCount = DNSReadWord(ABuffer + 4);
+            const uint16_t ANCount = DNSReadWord(ABuffer + 6);
+            const uint16_t NSCount = DNSReadWord(ABuffer + 8);
+
+            if ((Flags & 0x8000u) == 0 || QDCount != 1)
+                return -1;
+
+            size_t Pos = 12;
+            CString Name;
+
+            if (!DNSReadName(ABuffer, ASize, Pos, Name) || Name != AName)
+                return -1;
+
+            if (!DNSSkipName(ABuffer, ASize, Pos) || Pos + 4 > ASize)
+                return -1;
+
+            Pos += 4;
+
+            const int RCode = Flags & 0x000Fu;
+
+            if ((Flags & 0x0200u) != 0 || (RCode != 0 && RCode != 3))
+                return TRY_AGAIN;
+
+            ATTL = -1;
+
+            const int Count = ANCount + NSCount;
+            for (int i = 0; i < Count; i++) {
+                if (!DNSSkipName(ABuffer, ASize, Pos) || Pos + 10 > ASize)
+                    return TRY_AGAIN;
+
+                const uint16_t Type = DNSReadWord(ABuffer + Pos);
+                const uint16_t Class = DNSReadWord(ABuffer + Pos + 2);
+                const auto TTL = (int) (DNSReadLong(ABuffer + Pos + 4) & 0x7FFFFFFFu);
+                const uint16_t Length = DNSReadWord(ABuffer + Pos + 8);
+
+                Pos += 10;
+
+                if (Pos + Length > ASize)
+                    return TRY_AGAIN;
+
+                if (i < ANCount) {
+                    // CNAME chain records limit the lifetime of the final address too
+                    if (ATTL == -1 || TTL < ATTL)
+                        ATTL = TTL;
+
+                    if (RCode == 0 && Type == 1 && Class == 1 && Length == 4) {
+                        ::memcpy(&AAddr, ABuffer + Pos, 4);
+                        return 0;
+                    }
+                } else if (Type == 6 && Length >= 4) {
+                    const auto Minimum = (int) (DNSReadLong(ABuffer + Pos + Length - 4) & 0x7FFFFFFFu);
+                    ATTL = TTL < Minimum ? TTL : Minimum;
+                }
+
+                Pos += Length;
+            }
+
+            return RCode == 3 ? HOST_NOT_FOUND : NO_DATA;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CDNSCacheItem: public CObject {
+        public:
+
+            CString Name;
+
+            in_addr_t Addr;
+
+            int ErrorCode;
+
+            int64_t Expires;
+
+            CDNSCacheItem(const CString &AName, in_addr_t AAddr, int AErrorCode, int64_t AExpires): CObject(),
+                Name(AName), Addr(AAddr), ErrorCode(AErrorCode), Expires(AExpires) {
+
+            };
+
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CDNSWaiter: public CObject {
+        public:
+
+            CObject *Owner;
+
+            COnDNSResolvedEvent OnResolved;
+
+            CDNSWaiter(CObject *AOwner, COnDNSResolvedEvent &&AOnResolved): CObject(),
+                Owner(AOwner), OnResolved(AOnResolved) {
+
+            };
+
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        class CDNSQuery: public CObject {
+        public:
+
+            CString Name;
+
+            CStringList Names;
+            int Index;
+
+            uint16_t Id;
+
+            int Attempt;
+
+            int64_t Deadline;
+
+            CList Waiters;
+
+            CDNSQuery(const CString &AName, uint16_t AId): CObject(), Name(AName), Id(AId) {
+                Index = 0;
+                Attempt = 0;
+                Deadline = 0;
+            };
+
+            const CString &QName() const { return Names[Index]; }
+
+            ~CDNSQuery() override {
+                for (int i = 0; i < Waiters.Count(); i++)
+                    delete static_cast<CDNSWaiter *> (Waiters.Items(i));
+            };
+
+        };
+        //--------------------------------------------------------------------------------------------------------------
+
+        CDNSResolver::CDNSResolver(CPollEventHandlers *AEventHandlers): CPollConnection(nullptr),
+                m_CacheIndex(1024) {
+
+            m_pEventHandlers = AEventHandlers;
+            m_pTimer = nullptr;
+            m_pCompleting = nullptr;
+
+            m_Socket = INVALID_SOCKET;
+
+            m_Configured = false;
+            m_HostsLoaded = false;
+            m_TimerActive = false;
+
+            m_QueryTimeOut = DNS_RESOLVER_TIMEOUT;
+            m_Attempts = DNS_RESOLVER_ATTEMPTS;
+            m_NDots = DNS_RESOLVER_NDOTS;
+
+            m_CacheSize = DNS_CACHE_SIZE;
+            m_MinTTL = DNS_CACHE_MIN_TTL;
+            m_MaxTTL = DNS_CACHE_MAX_TTL;
+            m_NegativeTTL = DNS_CACHE_NEGATIVE_TTL;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CDNSResolver::~CDNSResolver() {
+            if (m_pTimer != nullptr) {
+                m_pTimer->OnTimer(nullptr);
+                if (m_pTimer->EventHandler() != nullptr)
+                    m_pTimer->EventHandler()->Stop();
+            }
+
+            ClosePoll();
+            CloseSocket();
+
+            for (int i = 0; i < m_Queries.Count(); i++)
+                delete static_cast<CDNSQuery *> (m_Queries.Items(i));
+
+            ClearCache();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::Open() {
+            if (m_Socket != INVALID_SOCKET)
+                return;
+
+            m_Socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (m_Socket == INVALID_SOCKET)
+                throw EOSError(errno, _T("Could not create resolver socket. Error: "));
+
+            const auto pHandler = m_pEventHandlers->Add(m_Socket);
+#if defined(_GLIBCXX_RELEASE) && (_GLIBCXX_RELEASE >= 9)
+            pHandler->OnReadEvent([this](auto && AHandler) { DoRead(AHandler); });
+#else
+            pHandler->OnReadEvent(std::bind(&CDNSResolver::DoRead, this, _1));
+#endif
+            pHandler->Binding(this);
+            pHandler->Start(etIO, EPOLLIN);
+
+            // The socket never idles out: query deadlines are tracked by the timer
+            CPollConnection::TimeOut(INFINITE);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::CloseSocket() {
+            if (m_Socket != INVALID_SOCKET) {
+                ::close(m_Socket);
+                m_Socket = INVALID_SOCKET;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::Close() {
+            // Called by the event handler while it is being freed
+            CloseSocket();
+            EventHandler(nullptr);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::LoadConfig(LPCTSTR lpszFileName) {
+            bool HasSearch = false;
+
+            m_Configured = true;
+
+            if (FileExists(lpszFileName)) {
+                CStringList Lines;
+                Lines.LoadFromFile(lpszFileName);
+
+                for (int i = 0; i < Lines.Count(); i++) {
+                    CStringList Columns;
+                    DNSSplitFields(Lines[i], Columns);
+
+                    if (Columns.Count() < 2)
+                        continue;
+
+                    const CString &Key = Columns[0];
+
+                    if (Key == _T("nameserver")) {
+                        struct in_addr addr = {};
+                        if (::inet_pton(AF_INET, Columns[1].c_str(), &addr) == 1)
+                            m_Servers.Add(Columns[1]);
+                    } else if (Key == _T("search") || Key == _T("domain")) {
+                        // As in libc, the last "search" or "domain" line wins
+                        m_Search.Clear();
+                        for (int j = 1; j < (Key == _T("domain") ? 2 : Columns.Count()); j++) {
+                            const CString Domain(DNSNormalizeName(Columns[j]));
+                            if (DNSValidName(Domain))
+                                m_Search.Add(Domain);
+                        }
+                        HasSearch = true;
+                    } else if (Key == _T("options")) {
+                        for (int j = 1; j < Columns.Count(); j++) {
+                            const CString &Option = Columns[j];
+                            if (Option.Find(_T("timeout:")) == 0) {
+                                m_QueryTimeOut = StrToIntDef(Option.SubString(8).c_str(), DNS_RESOLVER_TIMEOUT / 1000) * 1000;
+                            } else if (Option.Find(_T("attempts:")) == 0) {
+                                m_Attempts = StrToIntDef(Option.SubString(9).c_str(), DNS_RESOLVER_ATTEMPTS);
+                            } else if (Option.Find(_T("ndots:")) == 0) {
+                                m_NDots = Min(StrToIntDef(Option.SubString(6).c_str(), DNS_RESOLVER_NDOTS), 15);
+                            }
+                        }
+                    }
+                }
+            }
+
+            if (!HasSearch && m_Search.Count() == 0) {
+                // Without "search" or "domain" libc falls back to the domain part of the host name
+                char HostName[HOST_NAME_MAX + 1] = {};
+                if (::gethostname(HostName, sizeof(HostName) - 1) == 0) {
+                    const char *Domain = ::strchr(HostName, '.');
+                    if (Domain != nullptr && DNSValidName(DNSNormalizeName(Domain + 1)))
+                        m_Search.Add(DNSNormalizeName(Domain + 1));
+                }
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::LoadHosts(LPCTSTR lpszFileName) {
+            m_HostsLoaded = true;
+
+            if (!FileExists(lpszFileName))
+                return;
+
+            CStringList Lines;
+            Lines.LoadFromFile(lpszFileName);
+
+            for (int i = 0; i < Lines.Count(); i++) {
+                CStringList Columns;
+                DNSSplitFields(Lines[i], Columns);
+
+                struct in_addr addr = {};
+                if (Columns.Count() < 2 || ::inet_pton(AF_INET, Columns[0].c_str(), &addr) != 1)
+                    continue;
+
+                for (int j = 1; j < Columns.Count(); j++) {
+                    const CString Name(DNSNormalizeName(Columns[j]));
+                    if (m_CacheIndex.ValueOf(Name) == -1)
+                        AddCache(Name, addr.s_addr, 0, -1);
+                }
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::CheckConfig() {
+            if (!m_Configured) {
+                if (m_Servers.Count() == 0) {
+                    LoadConfig();
+                } else {
+                    m_Configured = true;
+                }
+            }
+
+            if (m_Servers.Count() == 0)
+                m_Servers.Add(_T("127.0.0.1"));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::UpdateTimer() {
+            const bool Active = m_Queries.Count() > 0;
+
+            if (Active == m_TimerActive)
+                return;
+
+            if (m_pTimer == nullptr) {
+                m_pTimer = CEPollTimer::CreateTimer(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+                m_pTimer->AllocateTimer(m_pEventHandlers, DNS_RESOLVER_TICK, DNS_RESOLVER_TICK);
+#if defined(_GLIBCXX_RELEASE) && (_GLIBCXX_RELEASE >= 9)
+                m_pTimer->OnTimer([this](auto && AHandler) { DoTimer(AHandler); });
+#else
+                m_pTimer->OnTimer(std::bind(&CDNSResolver::DoTimer, this, _1));
+#endif
+            } else if (Active) {
+                m_pTimer->SetTimer(DNS_RESOLVER_TICK, DNS_RESOLVER_TICK);
+            } else {
+                struct itimerspec ts = {};
+                m_pTimer->SetTime(0, &ts);
+            }
+
+            m_TimerActive = Active;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CDNSResolver::Find(const CString &Key, char *VIP, size_t ASize, int &ErrorCode) {
+            struct in_addr addr = {};
+
+            // Absolute names ("host.") are cached apart from the search list results of "host"
+            const CString Name(DNSNormalizeName(Key));
+
+            ErrorCode = 0;
+
+            if (::inet_pton(AF_INET, Name.c_str(), &addr) == 1) {
+                chVERIFY(SUCCEEDED(StringCchCopyA(VIP, ASize, Name.c_str())));
+                return true;
+            }
+
+            if (!m_HostsLoaded) {
+                LoadHosts();
+                if (m_CacheIndex.ValueOf(_T("localhost")) == -1)
+                    AddCache(_T("localhost"), htonl(INADDR_LOOPBACK), 0, -1);
+            }
+
+            int Index = m_CacheIndex.ValueOf(Key);
+            if (Index == -1 && Name.Length() < Key.Length()) {
+                // Only /etc/hosts entries, which never expire, apply to both forms
+                Index = m_CacheIndex.ValueOf(Name);
+                if (Index != -1 && static_cast<CDNSCacheItem *> (m_Cache.Items(Index))->Expires != -1)
+                    Index = -1;
+            }
+
+            if (Index == -1)
+                return false;
+
+            const auto pItem = static_cast<CDNSCacheItem *> (m_Cache.Items(Index));
+            if (pItem->Expires != -1 && pItem->Expires <= DNSTickCount())
+                return false;
+
+            ErrorCode = pItem->ErrorCode;
+            if (ErrorCode == 0) {
+                addr.s_addr = pItem->Addr;
+                if (::inet_ntop(AF_INET, &addr, VIP, ASize) == nullptr)
+                    ErrorCode = NO_RECOVERY;
+            }
+
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::AddCache(const CString &Name, in_addr_t Addr, int ErrorCode, int TTL) {
+            int64_t Expires = -1;
+
+            if (TTL >= 0) {
+                if (TTL < m_MinTTL) TTL = m_MinTTL;
+                if (TTL > m_MaxTTL) TTL = m_MaxTTL;
+                Expires = DNSTickCount() + (int64_t) TTL * 1000;
+            }
+
+            const int Index = m_CacheIndex.ValueOf(Name);
+            if (Index != -1) {
+                const auto pItem = static_cast<CDNSCacheItem *> (m_Cache.Items(Index));
+                pItem->Addr = Addr;
+                pItem->ErrorCode = ErrorCode;
+                pItem->Expires = Expires;
+                return;
+            }
+
+            if (m_Cache.Count() >= m_CacheSize)
+                PackCache();
+
+            m_CacheIndex.Add(Name, m_Cache.Add(new CDNSCacheItem(Name, Addr, ErrorCode, Expires)));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::PackCache() {
+            const int64_t Now = DNSTickCount();
+
+            CList Items;
+            for (int i = 0; i < m_Cache.Count(); i++) {
+                const auto pItem = static_cast<CDNSCacheItem *> (m_Cache.Items(i));
+                if (pItem->Expires == -1 || pItem->Expires > Now) {
+                    Items.Add(pItem);
+                } else {
+                    delete pItem;
+                }
+            }
+
+            // Still full of live entries: drop everything learned from the network
+            if (Items.Count() >= m_CacheSize) {
+                for (int i = Items.Count() - 1; i >= 0; i--) {
+                    const auto pItem = static_cast<CDNSCacheItem *> (Items.Items(i));
+                    if (pItem->Expires != -1) {
+                        Items.Delete(i);
+                        delete pItem;
+                    }
+                }
+            }
+
+            m_Cache.Clear();
+            m_CacheIndex.Clear();
+
+            for (int i = 0; i < Items.Count(); i++) {
+                const auto pItem = static_cast<CDNSCacheItem *> (Items.Items(i));
+                m_CacheIndex.Add(pItem->Name, m_Cache.Add(pItem));
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::ClearCache() {
+            for (int i = 0; i < m_Cache.Count(); i++)
+                delete static_cast<CDNSCacheItem *> (m_Cache.Items(i));
+
+            m_Cache.Clear();
+            m_CacheIndex.Clear();
+            m_HostsLoaded = false;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CDNSQuery *CDNSResolver::FindQuery(const CString &Name) const {
+            for (int i = 0; i < m_Queries.Count(); i++) {
+                const auto pQuery = static_cast<CDNSQuery *> (m_Queries.Items(i));
+                if (pQuery->Name == Name)
+                    return pQuery;
+            }
+            return nullptr;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CDNSQuery *CDNSResolver::FindQuery(uint16_t Id) const {
+            for (int i = 0; i < m_Queries.Count(); i++) {
+                const auto pQuery = static_cast<CDNSQuery *> (m_Queries.Items(i));
+                if (pQuery->Id == Id)
+                    return pQuery;
+            }
+            return nullptr;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::SearchList(const CString &Name, bool Absolute, CStringList &Names) const {
+            if (Absolute) {
+                Names.Add(Name);
+                return;
+            }
+
+            int Dots = 0;
+            for (size_t i = 0; i < Name.Length(); i++) {
+                if (Name.at(i) == '.')
+                    Dots++;
+            }
+
+            // Like res_search(): a name with at least "ndots" dots is tried as is first
+            if (Dots >= m_NDots)
+                Names.Add(Name);
+
+            for (int i = 0; i < m_Search.Count(); i++) {
+                CString Candidate(Name);
+                Candidate << '.' << m_Search[i];
+                if (DNSValidName(Candidate) && Names.IndexOf(Candidate) == -1)
+                    Names.Add(Candidate);
+            }
+
+            if (Dots < m_NDots && Names.IndexOf(Name) == -1)
+                Names.Add(Name);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::Send(CDNSQuery *AQuery) {
+            const CString &Name = AQuery->QName();
+
+            unsigned char Packet[DNS_PACKET_SIZE] = {};
+            size_t Size = 12;
+
+            Packet[0] = (unsigned char) (AQuery->Id >> 8u);
+            Packet[1] = (unsigned char) (AQuery->Id & 0xFFu);
+            Packet[2] = 0x01; // RD
+            Packet[5] = 0x01; // QDCOUNT
+
+            size_t Start = 0;
+            while (Start <= Name.Length()) {
+                size_t End = Name.Find('.', Start);
+                if (End == CString::npos)
+                    End = Name.Length();
+
+                const size_t Length = End - Start;
+                Packet[Size++] = (unsigned char) Length;
+                ::memcpy(Packet + Size, Name.c_str() + Start, Length);
+                Size += Length;
+
+                Start = End + 1;
+            }
+
+            Packet[Size++] = 0;
+            Packet[Size++] = 0; Packet[Size++] = 1; // QTYPE A
+            Packet[Size++] = 0; Packet[Size++] = 1; // QCLASS IN
+
+            struct sockaddr_in Addr = {};
+            const CString &Server = m_Servers[AQuery->Attempt % m_Servers.Count()];
+
+            AQuery->Attempt++;
+            AQuery->Deadline = DNSTickCount() + m_QueryTimeOut;
+
+            try {
+                Open();
+            } catch (...) {
+                // Fail the waiters now rather than leave a query no socket will ever answer
+                Complete(AQuery, TRY_AGAIN, INADDR_NONE);
+                throw;
+            }
+
+            // A failed send is retried like a lost answer
+            if (DNSParseServer(Server, Addr))
+                ::sendto(m_Socket, Packet, Size, 0, (struct sockaddr *) &Addr, sizeof(Addr));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::Complete(CDNSQuery *AQuery, int ErrorCode, in_addr_t Addr) {
+            char IP[NI_MAXIP] = {};
+
+            if (ErrorCode == 0) {
+                struct in_addr addr = {};
+                addr.s_addr = Addr;
+                if (::inet_ntop(AF_INET, &addr, IP, sizeof(IP)) == nullptr)
+                    ErrorCode = NO_RECOVERY;
+            }
+
+            m_Queries.Remove(AQuery);
+            m_pCompleting = AQuery;
+
+            try {
+                for (int i = 0; i < AQuery->Waiters.Count(); i++) {
+                    const auto pWaiter = static_cast<CDNSWaiter *> (AQuery->Waiters.Items(i));
+                    if (pWaiter->OnResolved != nullptr)
+                        pWaiter->OnResolved(this, AQuery->Name, IP, ErrorCode);
+                }
+            } catch (...) {
+                m_pCompleting = nullptr;
+                delete AQuery;
+                throw;
+            }
+
+            m_pCompleting = nullptr;
+            delete AQuery;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool CDNSResolver::Lookup(const CString &Host, char *VIP, size_t ASize) {
+            int ErrorCode = 0;
+            return Find(Host.Lower(), VIP, ASize, ErrorCode) && ErrorCode == 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::Resolve(const CString &Host, CObject *AOwner, COnDNSResolvedEvent &&OnResolved) {
+            char IP[NI_MAXIP] = {};
+            int ErrorCode = 0;
+
+            const CString Key(Host.Lower());
+            const CString Name(DNSNormalizeName(Key));
+
+            if (Find(Key, IP, sizeof(IP), ErrorCode)) {
+                OnResolved(this, Key, IP, ErrorCode);
+                return;
+            }
+
+            if (!DNSValidName(Name)) {
+                OnResolved(this, Key, IP, HOST_NOT_FOUND);
+                return;
+            }
+
+            auto pQuery = FindQuery(Key);
+
+            if (pQuery == nullptr) {
+                CheckConfig();
+
+                uint16_t Id = 0;
+                do {
+                    if (::getrandom(&Id, sizeof(Id), GRND_NONBLOCK) != sizeof(Id))
+                        Id = (uint16_t) (DNSTickCount() ^ (m_Queries.Count() << 8));
+                } while (FindQuery(Id) != nullptr);
+
+                pQuery = new CDNSQuery(Key, Id);
+                SearchList(Name, Name.Length() < Key.Length(), pQuery->Names);
+                m_Queries.Add(pQuery);
+
+                // Send() completes and frees the query if the socket cannot be opened
+                Send(pQuery);
+                UpdateTimer();
+            }
+
+            pQuery->Waiters.Add(new CDNSWaiter(AOwner, std::move(OnResolved)));
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::Cancel(CObject *AOwner) {
+            for (int i = 0; i < m_Queries.Count(); i++) {
+                const auto pQuery = static_cast<CDNSQuery *> (m_Queries.Items(i));
+                for (int j = pQuery->Waiters.Count() - 1; j >= 0; j--) {
+                    const auto pWaiter = static_cast<CDNSWaiter *> (pQuery->Waiters.Items(j));
+                    if (pWaiter->Owner == AOwner) {
+                        pQuery->Waiters.Delete(j);
+                        delete pWaiter;
+                    }
+                }
+            }
+
+            if (m_pCompleting != nullptr) {
+                for (int j = 0; j < m_pCompleting->Waiters.Count(); j++) {
+                    const auto pWaiter = static_cast<CDNSWaiter *> (m_pCompleting->Waiters.Items(j));
+                    if (pWaiter->Owner == AOwner)
+                        pWaiter->OnResolved = nullptr;
+                }
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::DoRead(CPollEventHandler *) {
+            unsigned char Buffer[DNS_PACKET_SIZE];
+            struct sockaddr_in From = {};
+            socklen_t FromLen;
+            ssize_t Size;
+
+            for (;;) {
+                FromLen = sizeof(From);
+                Size = ::recvfrom(m_Socket, Buffer, sizeof(Buffer), 0, (struct sockaddr *) &From, &FromLen);
+
+                if (Size < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    break;
+                }
+
+                if (Size < 12)
+                    continue;
+
+                const auto pQuery = FindQuery(DNSReadWord(Buffer));
+                if (pQuery == nullptr)
+                    continue;
+
+                bool Trusted = false;
+                for (int i = 0; i < m_Servers.Count() && !Trusted; i++) {
+                    struct sockaddr_in Addr = {};
+                    Trusted = DNSParseServer(m_Servers[i], Addr) && Addr.sin_addr.s_addr == From.sin_addr.s_addr && Addr.sin_port == From.sin_port;
+                }
+
+                if (!Trusted)
+                    continue;
+
+                in_addr_t Addr = INADDR_NONE;
+                int TTL = -1;
+
+                const int ErrorCode = DNSParseResponse(Buffer, (size_t) Size, pQuery->QName(), Addr, TTL);
+
+                if (ErrorCode == -1)
+                    continue;
+
+                if (ErrorCode == TRY_AGAIN) {
+                    // Let the timer move on to the next server right away
+                    pQuery->Deadline = 0;
+                    continue;
+                }
+
+                if (ErrorCode != 0 && pQuery->Index < pQuery->Names.Count() - 1) {
+                    // Not found under this name: go on with the next search list candidate
+                    pQuery->Index++;
+                    pQuery->Attempt = 0;
+                    Send(pQuery);
+                    continue;
+                }
+
+                AddCache(pQuery->Name, Addr, ErrorCode, TTL == -1 && ErrorCode != 0 ? m_NegativeTTL : TTL);
+                Complete(pQuery, ErrorCode, Addr);
+            }
+
+            UpdateTimer();
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CDNSResolver::DoTimer(CPollEventHandler *) {
+            uint64_t exp;
+            m_pTimer->Read(&exp, sizeof(uint64_t));
+
+            const int64_t Now = DNSTickCount();
+            const int MaxAttempts = m_Attempts * m_Servers.Count();
+
+            for (int i = m_Queries.Count() - 1; i >= 0; i--) {
+                if (i >= m_Queries.Count())
+                    continue;
+
+                const auto pQuery = static_cast<CDNSQuery *> (m_Queries.Items(i));
+
+                if (pQuery->Deadline > Now)
+                    continue;
+
+                if (pQuery->Attempt < MaxAttempts) {
+                    Send(pQuery);
+                } else {
+                    Complete(pQuery, TRY_AGAIN, INADDR_NONE);
+                }
+            }
+
+            UpdateTimer();
+        }
+
+        //--------------------------------------------------------------------------------------------------------------
+
         //-- CEPoll ----------------------------------------------------------------------------------------------------
 
         //--------------------------------------------------------------------------------------------------------------
@@ -4461,10 +5893,23 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CEPoll::PackEventHandlers(const CDateTime DateTime) {
+            // Walk all handlers only when one was stopped or once per poll interval for timeouts,
+            // so that a busy loop does not pay O(N) on every wakeup.
+            const int TimeOut = m_pEventHandlers->PollStack().TimeOut();
+            const bool bCheckTimeOut = DateTime >= m_pEventHandlers->m_TimeOutCheck;
+
+            if (!bCheckTimeOut && m_pEventHandlers->m_StoppedCount == 0)
+                return;
+
+            if (bCheckTimeOut)
+                m_pEventHandlers->m_TimeOutCheck = DateTime + (CDateTime) (TimeOut > 0 ? TimeOut : POLL_TIMEOUT_CHECK_INTERVAL) / MSecsPerDay;
+
+            m_pEventHandlers->m_StoppedCount = 0;
+
             for (int i = m_pEventHandlers->Count() - 1; i >= 0; i--) {
                 const auto pHandler = m_pEventHandlers->Handlers(i);
 
-                if (pHandler->EventType() == etIO || pHandler->EventType() == etEvent) {
+                if (bCheckTimeOut && (pHandler->EventType() == etIO || pHandler->EventType() == etEvent)) {
                     CheckTimeOut(pHandler, DateTime);
                 }
 
@@ -4528,6 +5973,12 @@ namespace Delphi {
                         }
                     }
 
+                } else if (pHandler->EventType() == etSignal) {
+
+                    if (uEvents & EPOLLIN) {
+                        pHandler->DoSignalEvent();
+                    }
+
                 } else if (pHandler->EventType() == etIO) {
 
                     if (uEvents & EPOLLIN) {
@@ -4651,7 +6102,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CEPollClient::DoTimeOut(CPollEventHandler *AHandler) {
-            const auto pConnection = dynamic_cast<CTCPConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CTCPConnection *> (pBinding) : nullptr;
 
             if (pConnection != nullptr) {
                 if (m_OnTimeOut == nullptr) {
@@ -4668,7 +6120,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CEPollClient::DoRead(CPollEventHandler *AHandler) {
-            const auto pConnection = dynamic_cast<CTCPConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CTCPConnection *> (pBinding) : nullptr;
 
             if (pConnection != nullptr) {
                 try {
@@ -4682,7 +6135,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CEPollClient::DoWrite(CPollEventHandler *AHandler) {
-            const auto pConnection = dynamic_cast<CTCPConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CTCPConnection *> (pBinding) : nullptr;
 
             if (pConnection != nullptr) {
                 try {
@@ -4702,7 +6156,11 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+#ifdef WITH_SSL
+        CAsyncServer::CAsyncServer(): CEPollServer(), m_SSLContext(sslServer) {
+#else
         CAsyncServer::CAsyncServer(): CEPollServer() {
+#endif
             m_ActiveLevel = alShutDown;
             m_pIOHandler = nullptr;
             m_FreeIOHandler = true;
@@ -4770,7 +6228,11 @@ namespace Delphi {
 
         //--------------------------------------------------------------------------------------------------------------
 
+#ifdef WITH_SSL
+        CAsyncClient::CAsyncClient(): CEPollClient(), m_SSLContext(sslClient) {
+#else
         CAsyncClient::CAsyncClient(): CEPollClient() {
+#endif
             m_Active = false;
             m_AutoConnect = true;
 #ifdef WITH_SSL
@@ -4790,6 +6252,8 @@ namespace Delphi {
 
         CAsyncClient::~CAsyncClient() {
             SetActive(false);
+            if (m_pEventHandlers != nullptr && m_pEventHandlers->HasResolver())
+                m_pEventHandlers->Resolver()->Cancel(this);
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -4825,6 +6289,7 @@ namespace Delphi {
             auto pIOHandler = new CIOHandlerSocket();
 #ifdef WITH_SSL
             pIOHandler->Open(m_UsedSSL ? sslClient : sslNotUsed);
+            pIOHandler->Binding()->SSLContext(&m_SSLContext);
 #else
             pIOHandler->Open();
 #endif
@@ -4847,14 +6312,62 @@ namespace Delphi {
 #endif
             }
 
-            pEventHandler->Start(etConnect);
+            DoConnectStart(pIOHandler, pEventHandler);
 
-            const int ErrorCode = pIOHandler->Binding()->Connect(AF_INET, m_Host.IsEmpty() ? "localhost" : m_Host.c_str(), m_Port == 0 ? 80 : m_Port);
+            const CString Host(m_Host.IsEmpty() ? "localhost" : m_Host);
+            const unsigned short Port = m_Port == 0 ? 80 : m_Port;
 
-            DoConnectStart(pIOHandler, pEventHandler);
+            char IP[NI_MAXIP] = {};
+            const auto pResolver = m_pEventHandlers->Resolver();
+
+            if (pResolver->Lookup(Host, IP, sizeof(IP))) {
+                ConnectResolved(pIOHandler, pEventHandler, Host, IP, Port);
+                return;
+            }
+
+            // The handler stays out of the poll stack until the name is resolved; its Id, unlike
+            // the pointer, cannot be reused if the connection is closed in the meantime.
+            const int Id = pEventHandler->Id();
+
+            pResolver->Resolve(Host, this, [this, Id, Host, Port](CDNSResolver *, const CString &, LPCSTR IP, int ErrorCode) {
+                const auto pHandler = static_cast<CPollEventHandler *> (m_pEventHandlers->FindItemId(Id));
+
+                if (pHandler == nullptr || pHandler->Stopped())
+                    return;
+
+                const auto pBinding = pHandler->Binding();
+                const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CTCPConnection *> (pBinding) : nullptr;
+
+                if (pConnection == nullptr) {
+                    pHandler->Stop();
+                    return;
+                }
+
+                try {
+                    if (ErrorCode != 0) {
+                        CString Message;
+                        Message.Format("Could not resolve host \"%s\": %s", Host.c_str(), ::hstrerror(ErrorCode));
+                        throw ESocketError(Message.c_str());
+                    }
+
+                    ConnectResolved(dynamic_cast<CIOHandlerSocket *> (pConnection->IOHandler()), pHandler, Host, IP, Port);
+                } catch (Delphi::Exception::Exception &E) {
+                    DoException(pConnection, E);
+                    pHandler->Stop();
+                }
+            });
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void CAsyncClient::ConnectResolved(CIOHandlerSocket *AIOHandler, CPollEventHandler *AHandler, const CString &Host,
+                LPCSTR IP, unsigned short Port) {
+
+            AHandler->Start(etConnect);
+
+            const int ErrorCode = AIOHandler->Binding()->Connect(AF_INET, Host.c_str(), IP, Port);
 
             if (ErrorCode == 0)
-                DoConnect(pEventHandler);
+                DoConnect(AHandler);
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -5118,6 +6631,27 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        void CTCPAsyncServer::StopListening() {
+            for (int i = 0; i < Bindings()->Count(); ++i) {
+                const auto SocketHandle = Bindings()->Handles(i);
+
+                if (!SocketHandle->HandleAllocated())
+                    continue;
+
+                for (int j = 0; j < m_pEventHandlers->Count(); ++j) {
+                    const auto pHandler = m_pEventHandlers->Handlers(j);
+                    if (pHandler->EventType() == etAccept && pHandler->Socket() == SocketHandle->Handle())
+                        pHandler->Stop();
+                }
+
+                SocketHandle->ReleaseSocket();
+            }
+
+            if (m_ActiveLevel == alActive)
+                m_ActiveLevel = alBinding;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         void CTCPAsyncServer::SetActiveLevel(CActiveLevel AValue) {
             if (m_ActiveLevel != AValue ) {
 
@@ -5135,11 +6669,18 @@ namespace Delphi {
                     for (int i = 0; i < Bindings()->Count(); ++i) {
                         const auto SocketHandle = Bindings()->Handles(i);
                         if (AValue >= alBinding && !SocketHandle->HandleAllocated()) {
-                            SocketHandle->AllocateSocket(SOCK_STREAM, IPPROTO_IP, O_NONBLOCK);
-                            SocketHandle->SetSockOpt(SOL_SOCKET, SO_REUSEADDR, (void *) &SO_True, sizeof(SO_True));
+                            const auto Inherited = CSocketHandles::InheritedSocket(SocketHandle->IP(), SocketHandle->Port());
+                            if (Inherited != INVALID_SOCKET) {
+                                SocketHandle->Adopt(Inherited);
+                            } else {
+                                SocketHandle->AllocateSocket(SOCK_STREAM, IPPROTO_IP, O_NONBLOCK);
+                                SocketHandle->SetSockOpt(SOL_SOCKET, SO_REUSEADDR, (void *) &SO_True, sizeof(SO_True));
+                                if (SocketHandle->ReusePort())
+                                    SocketHandle->SetSockOpt(SOL_SOCKET, SO_REUSEPORT, (void *) &SO_True, sizeof(SO_True));
 
-                            SocketHandle->Bind();
-                            SocketHandle->Listen(SOMAXCONN);
+                                SocketHandle->Bind();
+                                SocketHandle->Listen();
+                            }
                         }
 
                         if (AValue == alActive) {
@@ -5169,7 +6710,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CTCPAsyncServer::DoTimeOut(CPollEventHandler *AHandler) {
-            const auto pConnection = dynamic_cast<CTCPConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = Contains(pBinding) ? static_cast<CTCPConnection *> (pBinding) : nullptr;
 
             if (pConnection != nullptr) {
                 try {
@@ -5183,7 +6725,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CTCPAsyncServer::DoRead(CPollEventHandler *AHandler) {
-            const auto pConnection = dynamic_cast<CTCPConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = Contains(pBinding) ? static_cast<CTCPConnection *> (pBinding) : nullptr;
 
             if (pConnection != nullptr) {
                 try {
@@ -5197,7 +6740,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CTCPAsyncServer::DoWrite(CPollEventHandler *AHandler) {
-            const auto pConnection = dynamic_cast<CTCPConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = Contains(pBinding) ? static_cast<CTCPConnection *> (pBinding) : nullptr;
 
             if (pConnection != nullptr) {
                 try {
@@ -5214,13 +6758,21 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CTCPAsyncServer::DoAccept(CPollEventHandler *AHandler) {
-            CTCPServerConnection *pConnection = nullptr;
+            // The listener is level-triggered: drain the backlog up to the budget, leave the rest for the next wait
+            for (int Count = 0; Count < m_AcceptBudget || Count == 0; ++Count) {
+                CTCPServerConnection *pConnection = nullptr;
 
-            try {
-                CIOHandlerSocket *pIOHandler = nullptr;
-                pIOHandler = CServerIOHandler::Accept(AHandler->Socket(), SOCK_NONBLOCK);
+                try {
+                    CIOHandlerSocket *pIOHandler = nullptr;
+#ifdef WITH_SSL
+                    pIOHandler = CServerIOHandler::Accept(AHandler->Socket(), SOCK_NONBLOCK, &m_SSLContext);
+#else
+                    pIOHandler = CServerIOHandler::Accept(AHandler->Socket(), SOCK_NONBLOCK);
+#endif
+
+                    if (pIOHandler == nullptr)
+                        break;
 
-                if (Assigned(pIOHandler)) {
                     pConnection = new CTCPServerConnection(this);
 #if defined(_GLIBCXX_RELEASE) && (_GLIBCXX_RELEASE >= 9)
                     pConnection->OnDisconnected([this](auto && Sender) { DoDisconnected(Sender); });
@@ -5237,10 +6789,11 @@ namespace Delphi {
                     pEventHandler->Start(etIO);
 
                     DoConnected(pConnection);
+                } catch (Delphi::Exception::Exception &E) {
+                    delete pConnection;
+                    DoListenException(E);
+                    break;
                 }
-            } catch (Delphi::Exception::Exception &E) {
-                delete pConnection;
-                DoListenException(E);
             }
         }
 
@@ -5270,7 +6823,8 @@ namespace Delphi {
         //--------------------------------------------------------------------------------------------------------------
 
         void CTCPAsyncClient::DoConnect(CPollEventHandler *AHandler) {
-            const auto pConnection = dynamic_cast<CTCPClientConnection *> (AHandler->Binding());
+            const auto pBinding = AHandler->Binding();
+            const auto pConnection = m_Connections.Contains(pBinding) ? static_cast<CTCPClientConnection *> (pBinding) : nullptr;
 
             if (pConnection == nullptr) {
                 AHandler->Stop();
@@ -482,9 +482,18 @@ namespace Delphi {
 
         HRESULT StringCchCopyA(LPSTR pszDest, size_t cchDest, LPCSTR pszSrc) {
 
+            if (cchDest == 0)
+                return S_FALSE;
+
             pszDest = strncpy(pszDest, pszSrc, cchDest);
 
-            return (pszDest[cchDest] == '\0') ? S_OK : S_FALSE;
+            // strncpy leaves the buffer unterminated when the source does not fit: keep the truncated prefix
+            if (pszDest[cchDest - 1] != '\0') {
+                pszDest[cchDest - 1] = '\0';
+                return S_FALSE;
+            }
+
+            return S_OK;
         }
         //--------------------------------------------------------------------------------------------------------------
 
@@ -564,9 +573,18 @@ namespace Delphi {
 
         HRESULT StringCchCopyW(LPWSTR pszDest, size_t cchDest, LPCWSTR pszSrc) {
 
+            if (cchDest == 0)
+                return S_FALSE;
+
             pszDest = wcsncpy(pszDest, pszSrc, cchDest);
 
-            return (pszDest[cchDest] == '\0') ? S_OK : S_FALSE;
+            // wcsncpy leaves the buffer unterminated when the source does not fit: keep the truncated prefix
+            if (pszDest[cchDest - 1] != '\0') {
+                pszDest[cchDest - 1] = '\0';
+                return S_FALSE;
+            }
+
+            return S_OK;
         }
         //--------------------------------------------------------------------------------------------------------------
 
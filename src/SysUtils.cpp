@@ -145,6 +145,113 @@ namespace Delphi {
         }
         //--------------------------------------------------------------------------------------------------------------
 
+        static inline void HashMum(uint64_t &A, uint64_t &B) {
+#ifdef __SIZEOF_INT128__
+            __uint128_t R = A;
+            R *= B;
+            A = (uint64_t) R;
+            B = (uint64_t) (R >> 64);
+#else
+            const uint64_t HA = A >> 32, HB = B >> 32, LA = (uint32_t) A, LB = (uint32_t) B;
+            const uint64_t RH = HA * HB, RM0 = HA * LB, RM1 = HB * LA, RL = LA * LB;
+            const uint64_t T = RL + (RM0 << 32);
+            uint64_t C = T < RL;
+            const uint64_t Lo = T + (RM1 << 32);
+            C += Lo < T;
+            A = Lo;
+            B = RH + (RM0 >> 32) + (RM1 >> 32) + C;
+#endif
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static inline uint64_t HashMix(uint64_t A, uint64_t B) {
+            HashMum(A, B);
+            return A ^ B;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static inline uint64_t HashFold(uint64_t Value, bool Fold) {
+            if (!Fold)
+                return Value;
+            // Sets bit 5 of every byte in 'A'..'Z' without touching the others
+            const uint64_t Heptets = Value & 0x7f7f7f7f7f7f7f7fULL;
+            const uint64_t AboveZ = Heptets + 0x2525252525252525ULL;
+            const uint64_t FromA = Heptets + 0x3f3f3f3f3f3f3f3fULL;
+            const uint64_t Upper = ~Value & (FromA ^ AboveZ) & 0x8080808080808080ULL;
+            return Value | (Upper >> 2);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static inline uint64_t HashRead8(const uint8_t *P, bool Fold) {
+            uint64_t V;
+            ::memcpy(&V, P, sizeof(V));
+            return HashFold(V, Fold);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static inline uint64_t HashRead4(const uint8_t *P, bool Fold) {
+            uint32_t V;
+            ::memcpy(&V, P, sizeof(V));
+            return HashFold(V, Fold);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        LIB_DELPHI uint64_t HashBuffer(const void *Buffer, size_t Size, bool CaseSensitive, uint64_t Seed) {
+            static const uint64_t Secret[4] = {
+                    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+            };
+
+            auto P = (const uint8_t *) Buffer;
+            const bool Fold = !CaseSensitive;
+
+            uint64_t A, B;
+
+            Seed ^= HashMix(Seed ^ Secret[0], Secret[1]);
+
+            if (Size <= 16) {
+                if (Size >= 4) {
+                    const size_t Delta = (Size >> 3) << 2;
+                    A = (HashRead4(P, Fold) << 32) | HashRead4(P + Delta, Fold);
+                    B = (HashRead4(P + Size - 4, Fold) << 32) | HashRead4(P + Size - 4 - Delta, Fold);
+                } else if (Size > 0) {
+                    A = HashFold(((uint64_t) P[0] << 16) | ((uint64_t) P[Size >> 1] << 8) | P[Size - 1], Fold);
+                    B = 0;
+                } else {
+                    A = B = 0;
+                }
+            } else {
+                size_t I = Size;
+
+                if (I > 48) {
+                    uint64_t See1 = Seed, See2 = Seed;
+                    do {
+                        Seed = HashMix(HashRead8(P, Fold) ^ Secret[1], HashRead8(P + 8, Fold) ^ Seed);
+                        See1 = HashMix(HashRead8(P + 16, Fold) ^ Secret[2], HashRead8(P + 24, Fold) ^ See1);
+                        See2 = HashMix(HashRead8(P + 32, Fold) ^ Secret[3], HashRead8(P + 40, Fold) ^ See2);
+                        P += 48;
+                        I -= 48;
+                    } while (I > 48);
+                    Seed ^= See1 ^ See2;
+                }
+
+                while (I > 16) {
+                    Seed = HashMix(HashRead8(P, Fold) ^ Secret[1], HashRead8(P + 8, Fold) ^ Seed);
+                    I -= 16;
+                    P += 16;
+                }
+
+                A = HashRead8(P + I - 16, Fold);
+                B = HashRead8(P + I - 8, Fold);
+            }
+
+            A ^= Secret[1];
+            B ^= Seed;
+            HashMum(A, B);
+
+            return HashMix(A ^ Secret[0] ^ Size, B ^ Secret[1]);
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
         LIB_DELPHI BOOL OSCheck(BOOL RetVal) {
             if (!RetVal)
                 throw EOSError(errno);
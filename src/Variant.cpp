@@ -0,0 +1,279 @@
+/*++
+
+Library name:
+
+  libdelphi
+
+Module Name:
+
+  Variant.cpp
+
+Notices:
+
+  Delphi classes for C++
+
+  Tagged variant value: owned text storage and non-allocating conversions
+
+Author:
+
+  Copyright (c) Prepodobny Alen
+
+  mailto: alienufo@inbox.ru
+  mailto: ufocomp@gmail.com
+
+--*/
+
+#include "delphi.hpp"
+//----------------------------------------------------------------------------------------------------------------------
+
+#define VARIANT_NUMBER_BUFFER 64
+//----------------------------------------------------------------------------------------------------------------------
+
+extern "C++" {
+
+namespace Delphi {
+
+    namespace Variant {
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        //-- VarData ---------------------------------------------------------------------------------------------------
+
+        //--------------------------------------------------------------------------------------------------------------
+
+        void VarData::Clear() {
+            if (VType == vtText && VLength > VARIANT_INLINE_TEXT)
+                delete [] VarRec.VText;
+
+            VType = vtEmpty;
+            VLength = 0;
+            VarRec.VUInt64 = 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void VarData::SetText(LPCTSTR Value, size_t Length) {
+            if (Length > UINT32_MAX)
+                throw ExceptionFrm(_T("Variant text too long: %lu"), (unsigned long) Length);
+
+            TCHAR *Buffer;
+
+            if (Length > VARIANT_INLINE_TEXT) {
+                Buffer = new TCHAR[Length + 1];
+                if (Length != 0)
+                    ::memcpy(Buffer, Value, Length * sizeof(TCHAR));
+                Buffer[Length] = 0;
+                Clear();
+                VarRec.VText = Buffer;
+            } else {
+                TCHAR Inline[VARIANT_INLINE_TEXT + 1] = {0};
+                if (Length != 0)
+                    ::memcpy(Inline, Value, Length * sizeof(TCHAR));
+                Clear();
+                ::memcpy(VarRec.VInline, Inline, sizeof(Inline));
+            }
+
+            VType = vtText;
+            VLength = (uint32_t) Length;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        void VarData::Assign(const VarData &Value) {
+            if (Value.VType == vtText) {
+                SetText(Value.Text(), Value.VLength);
+            } else {
+                Clear();
+                VType = Value.VType;
+                VarRec = Value.VarRec;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool VarData::IsText() const {
+            switch (VType) {
+                case vtChar:
+                case vtString:
+                case vtPChar:
+                case vtAnsiString:
+                case vtUnicodeString:
+                case vtText:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        LPCTSTR VarData::Text() const {
+            switch (VType) {
+                case vtChar:
+                    return &varChar;
+                case vtString:
+                    return varString == nullptr ? nullptr : varString->c_str();
+                case vtPChar:
+                    return varPChar;
+                case vtAnsiString:
+                    return varAnsiString;
+                case vtUnicodeString:
+                    return varUnicodeString == nullptr ? nullptr : varUnicodeString->c_str();
+                case vtText:
+                    return VLength > VARIANT_INLINE_TEXT ? VarRec.VText : VarRec.VInline;
+                default:
+                    return nullptr;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        size_t VarData::TextLength() const {
+            switch (VType) {
+                case vtChar:
+                    return 1;
+                case vtString:
+                    return varString == nullptr ? 0 : varString->Size();
+                case vtPChar:
+                    return varPChar == nullptr ? 0 : ::strlen(varPChar);
+                case vtAnsiString:
+                    return varAnsiString == nullptr ? 0 : ::strlen(varAnsiString);
+                case vtUnicodeString:
+                    return varUnicodeString == nullptr ? 0 : varUnicodeString->Size();
+                case vtText:
+                    return VLength;
+                default:
+                    return 0;
+            }
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        static bool CopyNumber(LPCTSTR Text, size_t Length, TCHAR *Buffer) {
+            if (Text == nullptr || Length == 0 || Length >= VARIANT_NUMBER_BUFFER)
+                return false;
+            ::memcpy(Buffer, Text, Length * sizeof(TCHAR));
+            Buffer[Length] = 0;
+            return true;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        int64_t VarData::AsInt64() const {
+            switch (VType) {
+                case vtInteger:
+                    return varInteger;
+                case vtBoolean:
+                    return varBoolean ? 1 : 0;
+                case vtDouble:
+                    return (int64_t) varDouble;
+                case vtUnsigned:
+                    return varUnsigned;
+                case vtFloat:
+                    return (int64_t) varFloat;
+                case vtUInt64:
+                    return (int64_t) varUInt64;
+                case vtInt64:
+                    return varInt64;
+                case vtVariant:
+                    return varVariant == nullptr ? 0 : varVariant->AsInt64();
+                default:
+                    break;
+            }
+
+            TCHAR Buffer[VARIANT_NUMBER_BUFFER];
+            if (IsText() && CopyNumber(Text(), TextLength(), Buffer))
+                return ::strtoll(Buffer, nullptr, 10);
+
+            return 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        double VarData::AsDouble() const {
+            switch (VType) {
+                case vtDouble:
+                    return varDouble;
+                case vtFloat:
+                    return varFloat;
+                case vtInteger:
+                case vtBoolean:
+                case vtUnsigned:
+                case vtInt64:
+                    return (double) AsInt64();
+                case vtUInt64:
+                    return (double) varUInt64;
+                case vtVariant:
+                    return varVariant == nullptr ? 0 : varVariant->AsDouble();
+                default:
+                    break;
+            }
+
+            TCHAR Buffer[VARIANT_NUMBER_BUFFER];
+            if (IsText() && CopyNumber(Text(), TextLength(), Buffer))
+                return ::strtod(Buffer, nullptr);
+
+            return 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        bool VarData::AsBoolean() const {
+            switch (VType) {
+                case vtBoolean:
+                    return varBoolean;
+                case vtDouble:
+                    return varDouble != 0;
+                case vtFloat:
+                    return varFloat != 0;
+                case vtVariant:
+                    return varVariant != nullptr && varVariant->AsBoolean();
+                default:
+                    break;
+            }
+
+            if (IsText()) {
+                const size_t Length = TextLength();
+                LPCTSTR Str = Text();
+                if (Length == 4 && ::strncasecmp(Str, "true", 4) == 0)
+                    return true;
+                if (Length == 1 && (Str[0] == 't' || Str[0] == 'T' || Str[0] == 'y' || Str[0] == 'Y'))
+                    return true;
+            }
+
+            return AsInt64() != 0;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+        CString VarData::AsString() const {
+            CString Result;
+
+            if (IsText()) {
+                const size_t Length = TextLength();
+                if (Length != 0)
+                    Result.Append(Text(), Length);
+                return Result;
+            }
+
+            switch (VType) {
+                case vtInteger:
+                case vtUnsigned:
+                case vtInt64:
+                    Result.Format("%lld", (long long) AsInt64());
+                    break;
+                case vtUInt64:
+                    Result.Format("%llu", (unsigned long long) varUInt64);
+                    break;
+                case vtBoolean:
+                    Result = varBoolean ? "true" : "false";
+                    break;
+                case vtDouble:
+                case vtFloat:
+                    Result.Format("%.17g", AsDouble());
+                    break;
+                case vtVariant:
+                    if (varVariant != nullptr)
+                        Result = varVariant->AsString();
+                    break;
+                default:
+                    break;
+            }
+
+            return Result;
+        }
+        //--------------------------------------------------------------------------------------------------------------
+
+    }
+}
+}